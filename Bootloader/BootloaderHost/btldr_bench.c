@@ -0,0 +1,254 @@
+/*******************************************************************************
+* File: btldr_bench.c
+*
+* Version: 1.0
+*
+* Description:
+*  Compares the update throughput of the one-row-per-command flow of the
+*  Bootloader component with the multi-row burst of the extended host link,
+*  raw and LZ compressed.
+*  The I2C bus and the device are replaced by a timing model: every
+*  transaction costs the adapter overhead plus nine bit times per byte
+*  (address included), and a transaction that reaches the device while it
+*  programs a row is stretched until the row write completes. Decoding an LZ
+*  packet keeps the device busy for a fixed time per decoded byte.
+*
+*  The image mimics a PSoC 4 application: Thumb code, constant tables and
+*  zero filled rows.
+*
+*  Build: gcc -O2 -pthread -o btldr_bench btldr_bench.c btldr_host.c btldr_crc.c
+*         btldr_lz.c
+*  Usage: btldr_bench [bit rate, Hz] [adapter overhead, us] [row write, us]
+*                     [decode time per byte, us]
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "btldr_host.h"
+#include "btldr_lz.h"
+
+#define BENCH_ROW_SIZE          (128u)
+#define BENCH_FIRST_ROW         (64u)
+
+typedef struct
+{
+    double   bitRate;                   /* SCL frequency, Hz */
+    double   overhead;                  /* adapter cost per transaction, s */
+    double   rowWrite;                  /* flash row write time, s */
+    double   decodeByte;                /* LZ decode time per output byte, s */
+    double   now;                       /* virtual time, s */
+    double   busyUntil;                 /* end of the row write in progress */
+    uint8_t  command;                   /* command of the last write */
+    uint32_t streamBytes;               /* bytes received in the open burst */
+    uint16_t rowsDone;                  /* rows programmed in the open burst */
+    uint8_t  encoding;                  /* encoding of the open burst */
+    BtldrLz_Decoder decoder;
+    uint32_t transactions;
+} BenchModel;
+
+static void BenchModel_Transfer(BenchModel *model, size_t size)
+{
+    if(model->now < model->busyUntil)
+    {
+        model->now = model->busyUntil;
+    }
+    model->now += model->overhead + ((double)(size + 1u) * 9.0) / model->bitRate;
+    model->transactions++;
+}
+
+static int BenchModel_Write(void *context, const uint8_t *data, size_t size)
+{
+    BenchModel *model = (BenchModel *) context;
+    uint16_t length = (uint16_t)(data[2] | (data[3] << 8));
+    size_t decoded;
+
+    BenchModel_Transfer(model, size);
+    model->command = data[1];
+
+    switch(data[1])
+    {
+    case BTLDR_HOST_CMD_PROGRAM_ROW:
+    case BTLDR_HOST_CMD_ERASE_ROW:
+        model->busyUntil = model->now + model->rowWrite;
+        break;
+
+    case BTLDR_HOST_CMD_PROGRAM_ROWS:
+        model->streamBytes = 0u;
+        model->rowsDone = 0u;
+        model->encoding = (length > 5u) ? data[9] : BTLDR_HOST_ENCODING_RAW;
+        BtldrLz_DecoderInit(&model->decoder);
+        break;
+
+    case BTLDR_HOST_CMD_ROWS_DATA:
+        if(model->encoding == BTLDR_HOST_ENCODING_LZ)
+        {
+            decoded = BtldrLz_Decode(&model->decoder, &data[5], (size_t)(length - 1u), NULL);
+            model->busyUntil = model->now + ((double) decoded * model->decodeByte);
+        }
+        else
+        {
+            decoded = (size_t)(length - 1u);
+        }
+
+        /* A packet may complete several rows, programmed one after another */
+        model->streamBytes += (uint32_t) decoded;
+        while((model->streamBytes / BENCH_ROW_SIZE) > model->rowsDone)
+        {
+            model->rowsDone++;
+            model->busyUntil = ((model->busyUntil > model->now) ? model->busyUntil : model->now) +
+                               model->rowWrite;
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    return (0);
+}
+
+static int BenchModel_Read(void *context, uint8_t *data, size_t size)
+{
+    BenchModel *model = (BenchModel *) context;
+    uint16_t length = (uint16_t)(size - BTLDR_HOST_SIZEOF_OVERHEAD);
+    uint16_t checksum;
+
+    BenchModel_Transfer(model, size);
+
+    memset(data, 0, size);
+    if(model->command == BTLDR_HOST_CMD_ROWS_STATUS)
+    {
+        data[4] = (uint8_t) model->rowsDone;
+        data[5] = (uint8_t)(model->rowsDone >> 8);
+    }
+    data[0] = BTLDR_HOST_SOP;
+    data[2] = (uint8_t) length;
+    data[3] = (uint8_t)(length >> 8);
+    checksum = BtldrHost_Checksum(data, BTLDR_HOST_SIZEOF_HEADER + length);
+    data[BTLDR_HOST_SIZEOF_HEADER + length] = (uint8_t) checksum;
+    data[BTLDR_HOST_SIZEOF_HEADER + length + 1u] = (uint8_t)(checksum >> 8);
+    data[BTLDR_HOST_SIZEOF_HEADER + length + 2u] = BTLDR_HOST_EOP;
+
+    return (0);
+}
+
+static double Bench_Run(const BenchModel *setup, uint16_t rowCount, uint16_t rowsPerBurst, uint8_t encoding,
+                        const uint8_t *image)
+{
+    BenchModel model = *setup;
+    BtldrHost_Transport transport = {&model, &BenchModel_Write, &BenchModel_Read};
+    BtldrHost_Link link = {&transport, BTLDR_HOST_MAX_PACKET, BENCH_ROW_SIZE};
+    int result;
+
+    result = BtldrHost_ProgramImage(&link, 0u, BENCH_FIRST_ROW, rowCount, image, rowsPerBurst, encoding);
+    if(model.now < model.busyUntil)
+    {
+        model.now = model.busyUntil;
+    }
+
+    if(rowsPerBurst == 0u)
+    {
+        printf("  %-17s", "one row");
+    }
+    else
+    {
+        printf("  burst of %-4u %-3s", rowsPerBurst, (encoding == BTLDR_HOST_ENCODING_LZ) ? "lz" : "raw");
+    }
+    printf("%6u rows %8.3f s %8.1f rows/s %7.2f transactions/row%s\n",
+           rowCount, model.now, rowCount / model.now, (double) model.transactions / rowCount,
+           (result == BTLDR_HOST_SUCCESS) ? "" : "  FAILED");
+
+    return (model.now);
+}
+
+/* Thumb-like code, then constant tables, then zero filled rows */
+static void Bench_MakeImage(uint8_t *image, size_t size)
+{
+    static const uint8_t opcodes[] = {0x68u, 0x60u, 0x1Cu, 0x42u, 0xD0u, 0xD1u, 0xF0u, 0xF7u,
+                                      0x46u, 0x20u, 0x2Bu, 0x4Bu, 0xBDu, 0xB5u, 0x18u, 0x70u};
+    uint32_t seed = 12345u;
+    size_t codeEnd = (size * 5u) / 8u;
+    size_t tableEnd = (size * 7u) / 8u;
+    size_t i;
+
+    memset(image, 0, size);
+    for(i = 0u; i < codeEnd; i += 2u)
+    {
+        seed = (seed * 1103515245u) + 12345u;
+        /* Register fields and small immediates dominate the low byte */
+        image[i] = (uint8_t)((seed >> 16) & 0x1Fu);
+        image[i + 1u] = opcodes[(seed >> 24) & 0x0Fu];
+    }
+    for(i = codeEnd; i < tableEnd; i += 4u)
+    {
+        image[i] = (uint8_t)((i - codeEnd) / 4u);
+        image[i + 1u] = 0x10u;
+        image[i + 2u] = 0x00u;
+        image[i + 3u] = 0x20u;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    static const uint16_t bursts[] = {4u, 16u, 64u};
+    static const uint16_t sizes[] = {32u, 192u};
+    BenchModel setup;
+    uint8_t *image;
+    uint8_t *encoded;
+    size_t imageSize = (size_t) sizes[1] * BENCH_ROW_SIZE;
+    double raw;
+    double lz;
+    size_t i;
+    size_t j;
+
+    memset(&setup, 0, sizeof(setup));
+    setup.bitRate = (argc > 1) ? atof(argv[1]) : 100000.0;
+    setup.overhead = ((argc > 2) ? atof(argv[2]) : 1000.0) * 1e-6;
+    setup.rowWrite = ((argc > 3) ? atof(argv[3]) : 20000.0) * 1e-6;
+    setup.decodeByte = ((argc > 4) ? atof(argv[4]) : 0.25) * 1e-6;
+
+    image = malloc(imageSize);
+    encoded = malloc(BTLDR_LZ_BOUND(imageSize));
+    if((image == NULL) || (encoded == NULL))
+    {
+        free(image);
+        free(encoded);
+        return (1);
+    }
+    Bench_MakeImage(image, imageSize);
+
+    printf("bus %.0f Hz, adapter overhead %.0f us, row write %.0f us, decode %.2f us/byte, packet %u bytes\n",
+           setup.bitRate, setup.overhead * 1e6, setup.rowWrite * 1e6, setup.decodeByte * 1e6,
+           BTLDR_HOST_MAX_PACKET);
+    for(i = 0u; i < (sizeof(sizes) / sizeof(sizes[0])); i++)
+    {
+        printf("image of %u rows, lz ratio %.2f\n", sizes[i],
+               (double) sizes[i] * BENCH_ROW_SIZE /
+               (double) BtldrLz_Compress(image, (size_t) sizes[i] * BENCH_ROW_SIZE, encoded));
+        (void) Bench_Run(&setup, sizes[i], 0u, BTLDR_HOST_ENCODING_RAW, image);
+        for(j = 0u; j < (sizeof(bursts) / sizeof(bursts[0])); j++)
+        {
+            raw = Bench_Run(&setup, sizes[i], bursts[j], BTLDR_HOST_ENCODING_RAW, image);
+            lz = Bench_Run(&setup, sizes[i], bursts[j], BTLDR_HOST_ENCODING_LZ, image);
+            printf("  %-17slz speedup %.2fx\n", "", raw / lz);
+        }
+    }
+
+    free(image);
+    free(encoded);
+
+    return (0);
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,238 @@
+/*******************************************************************************
+* File: btldr_crc.c
+*
+* Version: 1.0
+*
+* Description:
+*  CRC-32C (Castagnoli, reflected) as computed by the CE95281 bootloader.
+*  Three engines give the same result: one table lookup per byte, the
+*  reference; slicing by 8, eight lookups in eight tables per 64-bit word;
+*  and the CRC32 instruction of SSE4.2, which computes this polynomial, 8
+*  bytes per instruction. BtldrCrc_Update() picks the CRC32 instruction when
+*  the CPU has it and slicing by 8 otherwise.
+*
+*  The tables are computed on first use, once for all threads.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <pthread.h>
+#include <string.h>
+#include "btldr_crc.h"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+    #include <nmmintrin.h>
+    #define BTLDR_CRC_SSE42             (1)
+#else
+    #define BTLDR_CRC_SSE42             (0)
+#endif
+
+/* table[k][b]: CRC of byte b followed by k zero bytes */
+static uint32_t BtldrCrc_table[8][256];
+static int BtldrCrc_hardware;
+static pthread_once_t BtldrCrc_once = PTHREAD_ONCE_INIT;
+
+static void BtldrCrc_Init(void)
+{
+    uint32_t crc;
+    unsigned int i;
+    unsigned int k;
+
+    for(i = 0u; i < 256u; i++)
+    {
+        crc = i;
+        for(k = 0u; k < 8u; k++)
+        {
+            crc = (crc >> 1) ^ (BTLDR_CRC_POLY & (0u - (crc & 1u)));
+        }
+        BtldrCrc_table[0][i] = crc;
+    }
+    for(i = 0u; i < 256u; i++)
+    {
+        for(k = 1u; k < 8u; k++)
+        {
+            crc = BtldrCrc_table[k - 1u][i];
+            BtldrCrc_table[k][i] = (crc >> 8) ^ BtldrCrc_table[0][crc & 0xFFu];
+        }
+    }
+
+#if (BTLDR_CRC_SSE42 != 0)
+    __builtin_cpu_init();
+    BtldrCrc_hardware = __builtin_cpu_supports("sse4.2");
+#endif
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrCrc_Update
+********************************************************************************
+*
+* Summary:
+*  Continues a CRC-32C over a block of bytes with the fastest engine of the
+*  host.
+*
+* Parameters:
+*  crc:  CRC of the previous bytes, BTLDR_CRC_INIT for the first block.
+*
+* Return:
+*  The updated CRC.
+*
+*******************************************************************************/
+uint32_t BtldrCrc_Update(uint32_t crc, const uint8_t *data, size_t size)
+{
+    (void) pthread_once(&BtldrCrc_once, &BtldrCrc_Init);
+
+    return ((BtldrCrc_hardware != 0) ? BtldrCrc_UpdateHardware(crc, data, size) :
+                                       BtldrCrc_UpdateSliced(crc, data, size));
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrCrc_UpdateBytes
+********************************************************************************
+*
+* Summary:
+*  Reference engine: one lookup in a 256-entry table per byte.
+*
+*******************************************************************************/
+uint32_t BtldrCrc_UpdateBytes(uint32_t crc, const uint8_t *data, size_t size)
+{
+    size_t i;
+
+    (void) pthread_once(&BtldrCrc_once, &BtldrCrc_Init);
+
+    crc = ~crc;
+    for(i = 0u; i < size; i++)
+    {
+        crc = (crc >> 8) ^ BtldrCrc_table[0][(crc ^ data[i]) & 0xFFu];
+    }
+
+    return (~crc);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrCrc_UpdateSliced
+********************************************************************************
+*
+* Summary:
+*  Slicing by 8: the eight lookups of a 64-bit word are independent, so the
+*  CPU runs them in parallel instead of one after another.
+*
+*******************************************************************************/
+uint32_t BtldrCrc_UpdateSliced(uint32_t crc, const uint8_t *data, size_t size)
+{
+    uint32_t low;
+    uint32_t high;
+
+    (void) pthread_once(&BtldrCrc_once, &BtldrCrc_Init);
+
+    crc = ~crc;
+    while(size >= 8u)
+    {
+        /* Byte by byte, so the order does not depend on the host */
+        low = crc ^ ((uint32_t) data[0] | ((uint32_t) data[1] << 8) |
+                     ((uint32_t) data[2] << 16) | ((uint32_t) data[3] << 24));
+        high = (uint32_t) data[4] | ((uint32_t) data[5] << 8) |
+               ((uint32_t) data[6] << 16) | ((uint32_t) data[7] << 24);
+        crc = BtldrCrc_table[7][low & 0xFFu] ^ BtldrCrc_table[6][(low >> 8) & 0xFFu] ^
+              BtldrCrc_table[5][(low >> 16) & 0xFFu] ^ BtldrCrc_table[4][low >> 24] ^
+              BtldrCrc_table[3][high & 0xFFu] ^ BtldrCrc_table[2][(high >> 8) & 0xFFu] ^
+              BtldrCrc_table[1][(high >> 16) & 0xFFu] ^ BtldrCrc_table[0][high >> 24];
+        data += 8u;
+        size -= 8u;
+    }
+    while(size != 0u)
+    {
+        crc = (crc >> 8) ^ BtldrCrc_table[0][(crc ^ *data) & 0xFFu];
+        data++;
+        size--;
+    }
+
+    return (~crc);
+}
+
+
+#if (BTLDR_CRC_SSE42 != 0)
+__attribute__((target("sse4.2")))
+static uint32_t BtldrCrc_Sse42(uint32_t crc, const uint8_t *data, size_t size)
+{
+    uint64_t word;
+    uint64_t crc64;
+
+    crc = ~crc;
+    while((size != 0u) && ((((size_t) data) & 7u) != 0u))
+    {
+        crc = _mm_crc32_u8(crc, *data);
+        data++;
+        size--;
+    }
+    crc64 = crc;
+    while(size >= 8u)
+    {
+        memcpy(&word, data, sizeof(word));
+        crc64 = _mm_crc32_u64(crc64, word);
+        data += 8u;
+        size -= 8u;
+    }
+    crc = (uint32_t) crc64;
+    while(size != 0u)
+    {
+        crc = _mm_crc32_u8(crc, *data);
+        data++;
+        size--;
+    }
+
+    return (~crc);
+}
+#endif
+
+
+/*******************************************************************************
+* Function Name: BtldrCrc_UpdateHardware
+********************************************************************************
+*
+* Summary:
+*  CRC32 instruction of SSE4.2, 8 bytes per instruction. Falls back to
+*  slicing by 8 when the CPU does not have it; see BtldrCrc_HasHardware().
+*
+*******************************************************************************/
+uint32_t BtldrCrc_UpdateHardware(uint32_t crc, const uint8_t *data, size_t size)
+{
+    (void) pthread_once(&BtldrCrc_once, &BtldrCrc_Init);
+
+#if (BTLDR_CRC_SSE42 != 0)
+    if(BtldrCrc_hardware != 0)
+    {
+        return (BtldrCrc_Sse42(crc, data, size));
+    }
+#endif
+
+    return (BtldrCrc_UpdateSliced(crc, data, size));
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrCrc_HasHardware
+********************************************************************************
+*
+* Summary:
+*  Tells whether the CPU computes the CRC-32C with an instruction.
+*
+*******************************************************************************/
+int BtldrCrc_HasHardware(void)
+{
+    (void) pthread_once(&BtldrCrc_once, &BtldrCrc_Init);
+
+    return (BtldrCrc_hardware);
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,42 @@
+/*******************************************************************************
+* File: btldr_crc.h
+*
+* Version: 1.0
+*
+* Description:
+*  CRC-32C of the row hashes, image hashes and journal checks of the CE95281
+*  bootloader, bit for bit the same as BtldrExt_Crc32().
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#if !defined(BTLDR_CRC_H)
+#define BTLDR_CRC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* These values must match btldr_ext.h of the CE95281 project */
+#define BTLDR_CRC_POLY                  (0x82F63B78u)
+#define BTLDR_CRC_INIT                  (0x00000000u)
+
+/* CRC-32C of the nine bytes "123456789" */
+#define BTLDR_CRC_CHECK                 (0xE3069283u)
+
+uint32_t BtldrCrc_Update(uint32_t crc, const uint8_t *data, size_t size);
+uint32_t BtldrCrc_UpdateBytes(uint32_t crc, const uint8_t *data, size_t size);
+uint32_t BtldrCrc_UpdateSliced(uint32_t crc, const uint8_t *data, size_t size);
+uint32_t BtldrCrc_UpdateHardware(uint32_t crc, const uint8_t *data, size_t size);
+int      BtldrCrc_HasHardware(void);
+
+#endif /* BTLDR_CRC_H */
+
+
+/* [] END OF FILE */
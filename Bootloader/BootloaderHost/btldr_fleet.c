@@ -0,0 +1,647 @@
+/*******************************************************************************
+* File: btldr_fleet.c
+*
+* Version: 1.0
+*
+* Description:
+*  Updates many devices running the CE95281 bootloader concurrently.
+*
+*  The packets of an image are framed once and sent unchanged to every device
+*  it is installed on: the PROGRAM_ROWS and ROWS_DATA packets of a burst only
+*  depend on the rows, the burst size and the encoding, and the LZ encoding
+*  of the bursts is done once per image rather than once per device.
+*
+*  The devices of one bus are updated in turn, one transaction at a time.
+*  While a device erases and programs the row completed by the last packet
+*  it was sent, the packets of the other devices use the bus; the next
+*  transaction always goes to the device expected to be ready first. Each
+*  bus is served by its own thread, so separate buses run in parallel.
+*
+*  In delta mode the installed row hashes of every device are read, and the
+*  bursts whose rows all match are not sent to that device. The progress
+*  journal is not used.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "btldr_fleet.h"
+#include "btldr_lz.h"
+
+/* Update stages of a device */
+#define BTLDR_FLEET_ENTER       (0)
+#define BTLDR_FLEET_HASHES      (1)
+#define BTLDR_FLEET_BURSTS      (2)
+#define BTLDR_FLEET_SKIPPED     (3)
+#define BTLDR_FLEET_VERIFY      (4)
+#define BTLDR_FLEET_EXIT        (5)
+#define BTLDR_FLEET_DONE        (6)
+
+/* A framed PROGRAM_ROWS or ROWS_DATA packet */
+typedef struct
+{
+    size_t   offset;                    /* in the frame buffer */
+    uint16_t size;
+    uint16_t rowsCompleted;             /* rows the device writes when it receives the packet */
+} BtldrFleet_Packet;
+
+typedef struct
+{
+    size_t   firstRow;                  /* index of the first image row */
+    uint16_t rowCount;
+    size_t   firstPacket;
+    size_t   packetCount;
+} BtldrFleet_Burst;
+
+/* The packets of an image, framed once for every device it is sent to */
+typedef struct
+{
+    const Cyacd_Image *image;
+    size_t             packetSize;
+    uint16_t           rowSize;
+    int                result;          /* BTLDR_HOST_SUCCESS or the reason the image cannot be sent */
+    uint32_t          *hashes;          /* of every image row */
+    uint32_t          *digests;         /* BtldrHost_RowDigest() of every image row */
+    BtldrFleet_Burst  *bursts;
+    size_t             burstCount;
+    BtldrFleet_Packet *packets;
+    uint8_t           *frames;
+} BtldrFleet_Plan;
+
+typedef struct
+{
+    BtldrFleet_Target     *target;
+    const BtldrFleet_Plan *plan;
+    uint8_t               *changed;     /* per image row */
+    int                    stage;
+    size_t                 index;       /* next image row or burst of the stage */
+    size_t                 packet;      /* next packet of the burst */
+    int                    retried;     /* the burst is being sent again */
+    double                 readyAt;     /* time the device is expected to answer without delay */
+} BtldrFleet_State;
+
+typedef struct
+{
+    const BtldrFleet_Bus     *bus;
+    BtldrFleet_State         *states;
+    const BtldrImage_Options *options;
+    double                    rowTime;
+} BtldrFleet_Worker;
+
+/* Number of rows from index first that follow each other in the same array,
+* at most limit
+*/
+static size_t BtldrFleet_RunLength(const Cyacd_Image *image, size_t first, size_t limit)
+{
+    size_t count = 1u;
+
+    while(((first + count) < image->rowCount) && (count < limit) &&
+          (image->rows[first + count].arrayId == image->rows[first].arrayId) &&
+          (image->rows[first + count].row == (uint16_t)(image->rows[first].row + count)))
+    {
+        count++;
+    }
+
+    return (count);
+}
+
+static double BtldrFleet_Clock(const BtldrFleet_Bus *bus)
+{
+    struct timespec now;
+
+    if(bus->clock != NULL)
+    {
+        return (bus->clock(bus->clockContext));
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((double) now.tv_sec + ((double) now.tv_nsec * 1e-9));
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrFleet_BuildPlan
+********************************************************************************
+*
+* Summary:
+*  Splits the image into bursts of consecutive rows and frames their packets,
+*  LZ encoded when the options ask for it and the rows compress. Records for
+*  every packet how many rows it completes, so the device can be left alone
+*  while it writes them.
+*
+* Return:
+*  plan->result: BTLDR_HOST_SUCCESS, BTLDR_IMAGE_ERR_ROW_SIZE or
+*  BTLDR_HOST_ERR_ARGUMENT when out of memory.
+*
+*******************************************************************************/
+static void BtldrFleet_BuildPlan(BtldrFleet_Plan *plan, const BtldrImage_Options *options)
+{
+    const Cyacd_Image *image = plan->image;
+    size_t rowsPerBurst = (options->rowsPerBurst != 0u) ? options->rowsPerBurst : 1u;
+    size_t maxChunk = plan->packetSize - BTLDR_HOST_SIZEOF_OVERHEAD - 1u;
+    size_t maxPackets = (2u * image->rowCount) + ((image->rowCount * plan->rowSize) / maxChunk) + 1u;
+    size_t packetCount = 0u;
+    size_t used = 0u;
+    uint8_t data[BTLDR_HOST_MAX_PACKET];
+    uint8_t *staging = malloc(rowsPerBurst * plan->rowSize);
+    uint8_t *encoded = malloc(BTLDR_LZ_BOUND(rowsPerBurst * plan->rowSize));
+    BtldrLz_Decoder decoder;
+    BtldrFleet_Burst *burst;
+    const uint8_t *stream;
+    size_t streamSize;
+    size_t decoded;
+    size_t rowsBefore;
+    size_t offset;
+    size_t chunk;
+    size_t first = 0u;
+    size_t size;
+    size_t i;
+    uint8_t encoding;
+    uint8_t sequence;
+
+    plan->hashes = malloc((image->rowCount + 1u) * sizeof(uint32_t));
+    plan->digests = malloc((image->rowCount + 1u) * sizeof(uint32_t));
+    plan->bursts = malloc((image->rowCount + 1u) * sizeof(BtldrFleet_Burst));
+    plan->packets = malloc(maxPackets * sizeof(BtldrFleet_Packet));
+    plan->frames = malloc(maxPackets * plan->packetSize);
+    plan->burstCount = 0u;
+    plan->result = BTLDR_HOST_SUCCESS;
+
+    if((staging == NULL) || (encoded == NULL) || (plan->hashes == NULL) || (plan->digests == NULL) ||
+       (plan->bursts == NULL) || (plan->packets == NULL) || (plan->frames == NULL))
+    {
+        plan->result = BTLDR_HOST_ERR_ARGUMENT;
+    }
+
+    for(i = 0u; (plan->result == BTLDR_HOST_SUCCESS) && (i < image->rowCount); i++)
+    {
+        if(image->rows[i].size != plan->rowSize)
+        {
+            plan->result = BTLDR_IMAGE_ERR_ROW_SIZE;
+        }
+        else
+        {
+            plan->hashes[i] = BtldrHost_RowHash(image->rows[i].data, plan->rowSize);
+            plan->digests[i] = BtldrHost_RowDigest(image->rows[i].row, image->rows[i].data, plan->rowSize);
+        }
+    }
+
+    while((plan->result == BTLDR_HOST_SUCCESS) && (first < image->rowCount))
+    {
+        burst = &plan->bursts[plan->burstCount++];
+        burst->firstRow = first;
+        burst->rowCount = (uint16_t) BtldrFleet_RunLength(image, first, rowsPerBurst);
+        burst->firstPacket = packetCount;
+
+        size = (size_t) burst->rowCount * plan->rowSize;
+        for(i = 0u; i < burst->rowCount; i++)
+        {
+            memcpy(&staging[i * plan->rowSize], image->rows[first + i].data, plan->rowSize);
+        }
+
+        /* Rows that do not compress are sent raw */
+        encoding = BTLDR_HOST_ENCODING_RAW;
+        stream = staging;
+        streamSize = size;
+        if(options->compress != 0)
+        {
+            streamSize = BtldrLz_Compress(staging, size, encoded);
+            if(streamSize < size)
+            {
+                encoding = BTLDR_HOST_ENCODING_LZ;
+                stream = encoded;
+            }
+            else
+            {
+                streamSize = size;
+            }
+        }
+
+        /* The same packets as BtldrHost_ProgramRows() and BtldrHost_ProgramRowsLz() */
+        data[0] = image->rows[first].arrayId;
+        data[1] = (uint8_t) image->rows[first].row;
+        data[2] = (uint8_t)(image->rows[first].row >> 8);
+        data[3] = (uint8_t) burst->rowCount;
+        data[4] = (uint8_t)(burst->rowCount >> 8);
+        data[5] = encoding;
+        plan->packets[packetCount].offset = used;
+        plan->packets[packetCount].size = (uint16_t) BtldrHost_BuildPacket(&plan->frames[used],
+            BTLDR_HOST_CMD_PROGRAM_ROWS, data, (encoding == BTLDR_HOST_ENCODING_RAW) ? 5u : 6u);
+        plan->packets[packetCount].rowsCompleted = 0u;
+        used += plan->packets[packetCount].size;
+        packetCount++;
+
+        BtldrLz_DecoderInit(&decoder);
+        decoded = 0u;
+        sequence = 0u;
+        for(offset = 0u; offset < streamSize; offset += chunk)
+        {
+            chunk = ((streamSize - offset) < maxChunk) ? (streamSize - offset) : maxChunk;
+            data[0] = sequence++;
+            memcpy(&data[1], &stream[offset], chunk);
+
+            plan->packets[packetCount].offset = used;
+            plan->packets[packetCount].size = (uint16_t) BtldrHost_BuildPacket(&plan->frames[used],
+                BTLDR_HOST_CMD_ROWS_DATA, data, (uint16_t)(chunk + 1u));
+            rowsBefore = decoded / plan->rowSize;
+            decoded += (encoding == BTLDR_HOST_ENCODING_LZ) ?
+                       BtldrLz_Decode(&decoder, &stream[offset], chunk, NULL) : chunk;
+            plan->packets[packetCount].rowsCompleted = (uint16_t)((decoded / plan->rowSize) - rowsBefore);
+            used += plan->packets[packetCount].size;
+            packetCount++;
+        }
+
+        burst->packetCount = packetCount - burst->firstPacket;
+        first += burst->rowCount;
+    }
+
+    free(staging);
+    free(encoded);
+}
+
+static void BtldrFleet_FreePlan(BtldrFleet_Plan *plan)
+{
+    free(plan->hashes);
+    free(plan->digests);
+    free(plan->bursts);
+    free(plan->packets);
+    free(plan->frames);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrFleet_Seek
+********************************************************************************
+*
+* Summary:
+*  Skips the bursts from state->index on whose rows the device already holds,
+*  and moves on to the end of the update after the last burst.
+*
+*******************************************************************************/
+static void BtldrFleet_Seek(BtldrFleet_State *state)
+{
+    const BtldrFleet_Burst *burst;
+    size_t i;
+
+    state->packet = 0u;
+    state->retried = 0;
+    state->stage = BTLDR_FLEET_BURSTS;
+
+    while(state->index < state->plan->burstCount)
+    {
+        burst = &state->plan->bursts[state->index];
+        for(i = 0u; (i < burst->rowCount) && (state->changed[burst->firstRow + i] == 0u); i++)
+        {
+        }
+        if(i < burst->rowCount)
+        {
+            return;
+        }
+        state->target->stats.rowsSkipped += burst->rowCount;
+        state->index++;
+    }
+
+    state->stage = BTLDR_FLEET_SKIPPED;
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrFleet_Step
+********************************************************************************
+*
+* Summary:
+*  Runs the next transaction of the update of a device: a posted packet, or a
+*  command and its response. A burst that the device did not fully commit is
+*  sent once more before the update fails.
+*
+*******************************************************************************/
+static void BtldrFleet_Step(const BtldrFleet_Worker *worker, BtldrFleet_State *state)
+{
+    const BtldrHost_Link *link = &state->target->link;
+    const BtldrFleet_Plan *plan = state->plan;
+    const Cyacd_Image *image = plan->image;
+    BtldrImage_Stats *stats = &state->target->stats;
+    const BtldrFleet_Burst *burst;
+    const BtldrFleet_Packet *packet;
+    uint32_t hashes[BTLDR_HOST_MAX_HASHES];
+    uint32_t siliconId;
+    uint16_t rowsCompleted = 0u;
+    uint16_t rowsDone;
+    size_t count;
+    size_t i;
+    int valid = 0;
+    int result;
+
+    switch(state->stage)
+    {
+    case BTLDR_FLEET_ENTER:
+        result = BtldrHost_Enter(link, &siliconId, NULL);
+        if((result == BTLDR_HOST_SUCCESS) && (siliconId != image->siliconId))
+        {
+            result = BTLDR_IMAGE_ERR_DEVICE;
+        }
+        state->index = 0u;
+        if((worker->options->delta != 0) && (image->rowCount != 0u))
+        {
+            state->stage = BTLDR_FLEET_HASHES;
+        }
+        else
+        {
+            BtldrFleet_Seek(state);
+        }
+        break;
+
+    case BTLDR_FLEET_HASHES:
+        count = BtldrFleet_RunLength(image, state->index, BTLDR_HOST_MAX_HASHES);
+        result = BtldrHost_GetRowHashes(link, image->rows[state->index].arrayId, image->rows[state->index].row,
+                                        (uint8_t) count, hashes);
+        for(i = 0u; (result == BTLDR_HOST_SUCCESS) && (i < count); i++)
+        {
+            if(plan->hashes[state->index + i] == hashes[i])
+            {
+                state->changed[state->index + i] = 0u;
+            }
+        }
+        state->index += count;
+        if(state->index == image->rowCount)
+        {
+            state->index = 0u;
+            BtldrFleet_Seek(state);
+        }
+        break;
+
+    case BTLDR_FLEET_BURSTS:
+        burst = &plan->bursts[state->index];
+        if(state->packet < burst->packetCount)
+        {
+            packet = &plan->packets[burst->firstPacket + state->packet];
+            result = (link->transport->write(link->transport->context, &plan->frames[packet->offset],
+                                             packet->size) == 0) ? BTLDR_HOST_SUCCESS : BTLDR_HOST_ERR_COMM;
+            rowsCompleted = packet->rowsCompleted;
+            state->packet++;
+        }
+        else
+        {
+            result = BtldrHost_GetRowsDone(link, &rowsDone);
+            if((result == BTLDR_HOST_SUCCESS) && (rowsDone != burst->rowCount))
+            {
+                result = (state->retried == 0) ? BTLDR_HOST_SUCCESS : BTLDR_HOST_ERR_INCOMPLETE;
+                state->retried = 1;
+                state->packet = 0u;
+            }
+            else
+            {
+                for(i = 0u; i < burst->rowCount; i++)
+                {
+                    stats->digestSent += plan->digests[burst->firstRow + i];
+                }
+                stats->rowsSent += burst->rowCount;
+                state->index++;
+                BtldrFleet_Seek(state);
+            }
+        }
+        break;
+
+    case BTLDR_FLEET_SKIPPED:
+        /* Bootloaders that do not report the count leave rowsIdentical at zero */
+        if(BtldrHost_GetRowsSkipped(link, &rowsDone) == BTLDR_HOST_SUCCESS)
+        {
+            stats->rowsIdentical = rowsDone;
+        }
+        result = BTLDR_HOST_SUCCESS;
+        state->stage = BTLDR_FLEET_VERIFY;
+        break;
+
+    case BTLDR_FLEET_VERIFY:
+        result = BtldrHost_VerifyImage(link, stats->digestSent, (uint16_t) stats->rowsSent,
+                                       worker->options->readBack, &valid);
+        if(result == BTLDR_HOST_ERR_CMD)
+        {
+            result = BtldrHost_VerifyChecksum(link, &valid);
+        }
+        if((result == BTLDR_HOST_SUCCESS) && (valid == 0))
+        {
+            result = BTLDR_IMAGE_ERR_INVALID;
+        }
+        state->stage = BTLDR_FLEET_EXIT;
+        break;
+
+    default:
+        result = BtldrHost_Exit(link);
+        state->stage = BTLDR_FLEET_DONE;
+        break;
+    }
+
+    if(result != BTLDR_HOST_SUCCESS)
+    {
+        state->target->result = result;
+        state->stage = BTLDR_FLEET_DONE;
+    }
+
+    state->readyAt = BtldrFleet_Clock(worker->bus) + ((double) rowsCompleted * worker->rowTime);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrFleet_Serve
+********************************************************************************
+*
+* Summary:
+*  Thread function: updates the devices of one bus, always running the next
+*  transaction of the device expected to be ready first. Devices expected
+*  ready at the same time are served in turn.
+*
+*******************************************************************************/
+static void *BtldrFleet_Serve(void *argument)
+{
+    const BtldrFleet_Worker *worker = (const BtldrFleet_Worker *) argument;
+    BtldrFleet_State *states = worker->states;
+    size_t count = worker->bus->targetCount;
+    size_t next = 0u;
+    size_t pick;
+    size_t i;
+    size_t k;
+
+    for(;;)
+    {
+        pick = count;
+        for(i = 0u; i < count; i++)
+        {
+            k = (next + i) % count;
+            if((states[k].stage != BTLDR_FLEET_DONE) &&
+               ((pick == count) || (states[k].readyAt < states[pick].readyAt)))
+            {
+                pick = k;
+            }
+        }
+        if(pick == count)
+        {
+            break;
+        }
+
+        BtldrFleet_Step(worker, &states[pick]);
+        next = (pick + 1u) % count;
+    }
+
+    return (NULL);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrFleet_Update
+********************************************************************************
+*
+* Summary:
+*  Installs the image of every target and ends the session of the devices
+*  that validated it, so they start the new application. Each bus is served
+*  by its own thread, the first one by the calling thread.
+*
+* Parameters:
+*  buses:    The buses and their targets. The results and the row counts are
+*            written to the targets.
+*  options:  Burst size (0 sends bursts of one row), delta mode and
+*            compression. The resume option is ignored.
+*  rowTime:  Time a device is expected to be busy per row written, s, such as
+*            BTLDR_FLEET_ROW_TIME.
+*
+* Return:
+*  BTLDR_HOST_SUCCESS if every device was updated, otherwise the result of the
+*  first target that failed. BTLDR_HOST_ERR_ARGUMENT when out of memory.
+*
+*******************************************************************************/
+int BtldrFleet_Update(BtldrFleet_Bus *buses, size_t busCount, const BtldrImage_Options *options, double rowTime)
+{
+    BtldrFleet_Worker *workers = calloc(busCount + 1u, sizeof(BtldrFleet_Worker));
+    pthread_t *threads = calloc(busCount + 1u, sizeof(pthread_t));
+    int *started = calloc(busCount + 1u, sizeof(int));
+    BtldrFleet_State *states;
+    BtldrFleet_Plan *plans;
+    BtldrFleet_Target *target;
+    size_t targetCount = 0u;
+    size_t planCount = 0u;
+    size_t n = 0u;
+    size_t b;
+    size_t t;
+    size_t p;
+    int result = BTLDR_HOST_SUCCESS;
+
+    for(b = 0u; b < busCount; b++)
+    {
+        targetCount += buses[b].targetCount;
+    }
+    states = calloc(targetCount + 1u, sizeof(BtldrFleet_State));
+    plans = calloc(targetCount + 1u, sizeof(BtldrFleet_Plan));
+    if((workers == NULL) || (threads == NULL) || (started == NULL) || (states == NULL) || (plans == NULL))
+    {
+        free(workers);
+        free(threads);
+        free(started);
+        free(states);
+        free(plans);
+        return (BTLDR_HOST_ERR_ARGUMENT);
+    }
+
+    /* One plan per image and link format */
+    for(b = 0u; b < busCount; b++)
+    {
+        workers[b].bus = &buses[b];
+        workers[b].states = &states[n];
+        workers[b].options = options;
+        workers[b].rowTime = rowTime;
+
+        for(t = 0u; t < buses[b].targetCount; t++)
+        {
+            target = &buses[b].targets[t];
+            memset(&target->stats, 0, sizeof(target->stats));
+            target->stats.rowsTotal = target->image->rowCount;
+            target->result = BTLDR_HOST_SUCCESS;
+
+            for(p = 0u; (p < planCount) && ((plans[p].image != target->image) ||
+                (plans[p].packetSize != target->link.packetSize) || (plans[p].rowSize != target->link.rowSize)); p++)
+            {
+            }
+            if(p == planCount)
+            {
+                plans[p].image = target->image;
+                plans[p].packetSize = target->link.packetSize;
+                plans[p].rowSize = target->link.rowSize;
+                BtldrFleet_BuildPlan(&plans[p], options);
+                planCount++;
+            }
+
+            states[n].target = target;
+            states[n].plan = &plans[p];
+            states[n].stage = BTLDR_FLEET_ENTER;
+            states[n].changed = malloc(target->image->rowCount + 1u);
+            if(states[n].changed == NULL)
+            {
+                target->result = BTLDR_HOST_ERR_ARGUMENT;
+                states[n].stage = BTLDR_FLEET_DONE;
+            }
+            else if(plans[p].result != BTLDR_HOST_SUCCESS)
+            {
+                target->result = plans[p].result;
+                states[n].stage = BTLDR_FLEET_DONE;
+            }
+            else
+            {
+                memset(states[n].changed, 1, target->image->rowCount + 1u);
+            }
+            n++;
+        }
+    }
+
+    /* A bus whose thread cannot be started is served after the first one */
+    for(b = 1u; b < busCount; b++)
+    {
+        started[b] = (pthread_create(&threads[b], NULL, &BtldrFleet_Serve, &workers[b]) == 0);
+    }
+    for(b = 0u; b < busCount; b++)
+    {
+        if((b == 0u) || (started[b] == 0))
+        {
+            (void) BtldrFleet_Serve(&workers[b]);
+        }
+    }
+    for(b = 1u; b < busCount; b++)
+    {
+        if(started[b] != 0)
+        {
+            (void) pthread_join(threads[b], NULL);
+        }
+    }
+
+    for(n = 0u; n < targetCount; n++)
+    {
+        if((result == BTLDR_HOST_SUCCESS) && (states[n].target->result != BTLDR_HOST_SUCCESS))
+        {
+            result = states[n].target->result;
+        }
+        free(states[n].changed);
+    }
+    for(p = 0u; p < planCount; p++)
+    {
+        BtldrFleet_FreePlan(&plans[p]);
+    }
+    free(workers);
+    free(threads);
+    free(started);
+    free(states);
+    free(plans);
+
+    return (result);
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,52 @@
+/*******************************************************************************
+* File: btldr_fleet.h
+*
+* Version: 1.0
+*
+* Description:
+*  Updates many devices running the CE95281 bootloader concurrently: the
+*  devices of one bus are served in turn, packet by packet, and the buses are
+*  driven in parallel threads.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#if !defined(BTLDR_FLEET_H)
+#define BTLDR_FLEET_H
+
+#include "btldr_image.h"
+
+/* Time a device is expected to be busy per row written, when no better
+* estimate is given: the maximum erase and program times of the PSoC 4200
+*/
+#define BTLDR_FLEET_ROW_TIME            (20e-3)
+
+typedef struct
+{
+    BtldrHost_Link     link;            /* one slave address */
+    const Cyacd_Image *image;
+    int                result;          /* outcome of the update of this device */
+    BtldrImage_Stats   stats;
+} BtldrFleet_Target;
+
+typedef struct
+{
+    BtldrFleet_Target *targets;         /* the devices sharing the bus */
+    size_t             targetCount;
+    double           (*clock)(void *context);   /* time on the bus in s, NULL for the host clock */
+    void              *clockContext;
+} BtldrFleet_Bus;
+
+int BtldrFleet_Update(BtldrFleet_Bus *buses, size_t busCount, const BtldrImage_Options *options, double rowTime);
+
+#endif /* BTLDR_FLEET_H */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,785 @@
+/*******************************************************************************
+* File: btldr_host.c
+*
+* Version: 1.0
+*
+* Description:
+*  Host side of the extended bootloader host link. Every command is one write
+*  transaction followed, when the command is answered, by one read
+*  transaction of the expected response size.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "btldr_crc.h"
+#include "btldr_host.h"
+#include "btldr_lz.h"
+
+#define GET_WORD(p)             ((uint16_t)((p)[0] | ((p)[1] << 8)))
+#define SET_WORD(p, w)          do { (p)[0] = (uint8_t)(w); (p)[1] = (uint8_t)((w) >> 8); } while(0)
+#define GET_LONG(p)             ((uint32_t) GET_WORD(p) | ((uint32_t) GET_WORD(&(p)[2]) << 16))
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_Checksum
+********************************************************************************
+*
+* Summary:
+*  Basic summation checksum, identical to BtldrExt_PacketChecksum().
+*
+*******************************************************************************/
+uint16_t BtldrHost_Checksum(const uint8_t *buffer, size_t size)
+{
+    uint16_t sum = 0u;
+    size_t i;
+
+    for(i = 0u; i < size; i++)
+    {
+        sum = (uint16_t)(sum + buffer[i]);
+    }
+
+    return ((uint16_t)(1u + (uint16_t)~sum));
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_RowHash
+********************************************************************************
+*
+* Summary:
+*  CRC-32C of a row, identical to BtldrExt_RowHash().
+*
+*******************************************************************************/
+uint32_t BtldrHost_RowHash(const uint8_t *rowData, size_t size)
+{
+    return (BtldrCrc_Update(BTLDR_CRC_INIT, rowData, size));
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_RowDigest
+********************************************************************************
+*
+* Summary:
+*  Digest of a row sent to the bootloader, identical to BtldrExt_RowDigest().
+*  The image hash of BtldrHost_VerifyImage() is the sum of the digests of
+*  the rows sent.
+*
+*******************************************************************************/
+uint32_t BtldrHost_RowDigest(uint16_t row, const uint8_t *rowData, size_t size)
+{
+    uint8_t rowId[2];
+
+    SET_WORD(rowId, row);
+
+    return (BtldrCrc_Update(BtldrCrc_Update(BTLDR_CRC_INIT, rowId, sizeof(rowId)), rowData, size));
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_BuildPacket
+********************************************************************************
+*
+* Summary:
+*  Frames a command packet.
+*
+* Parameters:
+*  packet:  Output buffer, at least length + BTLDR_HOST_SIZEOF_OVERHEAD bytes.
+*  command: Command code.
+*  data:    Command data, may be NULL when length is zero.
+*  length:  Command data length.
+*
+* Return:
+*  Size of the packet.
+*
+*******************************************************************************/
+size_t BtldrHost_BuildPacket(uint8_t *packet, uint8_t command, const uint8_t *data, uint16_t length)
+{
+    uint16_t checksum;
+
+    packet[0] = BTLDR_HOST_SOP;
+    packet[1] = command;
+    SET_WORD(&packet[2], length);
+    if(length != 0u)
+    {
+        memcpy(&packet[BTLDR_HOST_SIZEOF_HEADER], data, length);
+    }
+
+    checksum = BtldrHost_Checksum(packet, BTLDR_HOST_SIZEOF_HEADER + length);
+    SET_WORD(&packet[BTLDR_HOST_SIZEOF_HEADER + length], checksum);
+    packet[BTLDR_HOST_SIZEOF_HEADER + length + 2u] = BTLDR_HOST_EOP;
+
+    return (BTLDR_HOST_SIZEOF_OVERHEAD + length);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_Post
+********************************************************************************
+*
+* Summary:
+*  Sends a command that is not answered by the bootloader.
+*
+* Return:
+*  BTLDR_HOST_SUCCESS or a negative host error.
+*
+*******************************************************************************/
+int BtldrHost_Post(const BtldrHost_Link *link, uint8_t command, const uint8_t *data, uint16_t length)
+{
+    uint8_t packet[BTLDR_HOST_MAX_PACKET];
+    size_t size;
+
+    if((length + BTLDR_HOST_SIZEOF_OVERHEAD) > link->packetSize)
+    {
+        return (BTLDR_HOST_ERR_ARGUMENT);
+    }
+
+    size = BtldrHost_BuildPacket(packet, command, data, length);
+
+    return ((link->transport->write(link->transport->context, packet, size) == 0) ?
+            BTLDR_HOST_SUCCESS : BTLDR_HOST_ERR_COMM);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_Command
+********************************************************************************
+*
+* Summary:
+*  Sends a command and reads its response.
+*
+* Parameters:
+*  rsp:       Buffer for the response data, may be NULL when rspLength is 0.
+*  rspLength: Expected response data length.
+*
+* Return:
+*  Status reported by the bootloader (0 on success) or a negative host error.
+*
+*******************************************************************************/
+int BtldrHost_Command(const BtldrHost_Link *link, uint8_t command, const uint8_t *data, uint16_t length,
+                      uint8_t *rsp, uint16_t rspLength)
+{
+    uint8_t packet[BTLDR_HOST_MAX_PACKET];
+    size_t size = rspLength + BTLDR_HOST_SIZEOF_OVERHEAD;
+    uint16_t received;
+    int result;
+
+    if(size > sizeof(packet))
+    {
+        return (BTLDR_HOST_ERR_ARGUMENT);
+    }
+
+    result = BtldrHost_Post(link, command, data, length);
+    if(result != BTLDR_HOST_SUCCESS)
+    {
+        return (result);
+    }
+
+    if(link->transport->read(link->transport->context, packet, size) != 0)
+    {
+        return (BTLDR_HOST_ERR_COMM);
+    }
+
+    /* An error response carries no data and is shorter than requested */
+    received = GET_WORD(&packet[2]);
+    if((packet[0] != BTLDR_HOST_SOP) || (received > rspLength) ||
+       (packet[BTLDR_HOST_SIZEOF_HEADER + received + 2u] != BTLDR_HOST_EOP) ||
+       (GET_WORD(&packet[BTLDR_HOST_SIZEOF_HEADER + received]) !=
+        BtldrHost_Checksum(packet, BTLDR_HOST_SIZEOF_HEADER + received)))
+    {
+        return (BTLDR_HOST_ERR_FORMAT);
+    }
+
+    if((packet[1] == BTLDR_HOST_SUCCESS) && (received != rspLength))
+    {
+        return (BTLDR_HOST_ERR_FORMAT);
+    }
+
+    if(received != 0u)
+    {
+        memcpy(rsp, &packet[BTLDR_HOST_SIZEOF_HEADER], received);
+    }
+
+    return ((int) packet[1]);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_Enter
+********************************************************************************
+*
+* Summary:
+*  Starts a bootloading session and reads the device identity. A device
+*  running a bootloadable with the entry service of CE95280 does not answer
+*  the command: it resets into the bootloader, which answers the command
+*  sent once more.
+*
+*******************************************************************************/
+int BtldrHost_Enter(const BtldrHost_Link *link, uint32_t *siliconId, uint8_t *siliconRev)
+{
+    uint8_t rsp[8];
+    int result = BtldrHost_Command(link, BTLDR_HOST_CMD_ENTER, NULL, 0u, rsp, sizeof(rsp));
+
+    if((result == BTLDR_HOST_ERR_FORMAT) || (result == BTLDR_HOST_ERR_COMM))
+    {
+        result = BtldrHost_Command(link, BTLDR_HOST_CMD_ENTER, NULL, 0u, rsp, sizeof(rsp));
+    }
+
+    if(result == BTLDR_HOST_SUCCESS)
+    {
+        if(siliconId != NULL)
+        {
+            *siliconId = (uint32_t) rsp[0] | ((uint32_t) rsp[1] << 8) |
+                         ((uint32_t) rsp[2] << 16) | ((uint32_t) rsp[3] << 24);
+        }
+        if(siliconRev != NULL)
+        {
+            *siliconRev = rsp[4];
+        }
+    }
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_GetFlashSize
+********************************************************************************
+*
+* Summary:
+*  Reads the range of rows available to the bootloadable.
+*
+*******************************************************************************/
+int BtldrHost_GetFlashSize(const BtldrHost_Link *link, uint8_t arrayId, uint16_t *firstRow, uint16_t *lastRow)
+{
+    uint8_t rsp[4];
+    int result = BtldrHost_Command(link, BTLDR_HOST_CMD_GET_FLASH_SIZE, &arrayId, 1u, rsp, sizeof(rsp));
+
+    if(result == BTLDR_HOST_SUCCESS)
+    {
+        *firstRow = GET_WORD(&rsp[0]);
+        *lastRow = GET_WORD(&rsp[2]);
+    }
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_ProgramRow
+********************************************************************************
+*
+* Summary:
+*  Programs one row with the command flow of the Bootloader component: Send
+*  Data packets for the leading part of the row and a Program Row packet for
+*  the rest, which the last Send Data packet leaves full. Every packet is
+*  answered.
+*
+*******************************************************************************/
+int BtldrHost_ProgramRow(const BtldrHost_Link *link, uint8_t arrayId, uint16_t row, const uint8_t *rowData)
+{
+    uint8_t data[BTLDR_HOST_MAX_PACKET];
+    size_t maxData = link->packetSize - BTLDR_HOST_SIZEOF_OVERHEAD;
+    size_t offset = 0u;
+    size_t chunk;
+    int result = BTLDR_HOST_SUCCESS;
+
+    while((result == BTLDR_HOST_SUCCESS) && ((link->rowSize - offset) > (maxData - 3u)))
+    {
+        chunk = (link->rowSize - offset) - (maxData - 3u);
+        chunk = (chunk < maxData) ? chunk : maxData;
+        result = BtldrHost_Command(link, BTLDR_HOST_CMD_SEND_DATA, &rowData[offset], (uint16_t) chunk, NULL, 0u);
+        offset += chunk;
+    }
+
+    if(result == BTLDR_HOST_SUCCESS)
+    {
+        data[0] = arrayId;
+        SET_WORD(&data[1], row);
+        memcpy(&data[3], &rowData[offset], link->rowSize - offset);
+        result = BtldrHost_Command(link, BTLDR_HOST_CMD_PROGRAM_ROW, data,
+                                   (uint16_t)(3u + (link->rowSize - offset)), NULL, 0u);
+    }
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_Burst
+********************************************************************************
+*
+* Summary:
+*  Sends a burst: PROGRAM_ROWS, the encoded row stream split into unanswered
+*  ROWS_DATA packets, and a single ROWS_STATUS acknowledge.
+*
+*******************************************************************************/
+static int BtldrHost_Burst(const BtldrHost_Link *link, uint8_t arrayId, uint16_t firstRow, uint16_t rowCount,
+                           uint8_t encoding, const uint8_t *stream, size_t streamSize, uint16_t *rowsDone)
+{
+    uint8_t data[BTLDR_HOST_MAX_PACKET];
+    size_t maxChunk = link->packetSize - BTLDR_HOST_SIZEOF_OVERHEAD - 1u;
+    size_t offset = 0u;
+    size_t chunk;
+    uint8_t sequence = 0u;
+    uint16_t done;
+    int result;
+
+    /* The encoding byte is left out for raw bursts, as the first version of
+    * the command had none.
+    */
+    data[0] = arrayId;
+    SET_WORD(&data[1], firstRow);
+    SET_WORD(&data[3], rowCount);
+    data[5] = encoding;
+    result = BtldrHost_Post(link, BTLDR_HOST_CMD_PROGRAM_ROWS, data,
+                            (encoding == BTLDR_HOST_ENCODING_RAW) ? 5u : 6u);
+
+    while((result == BTLDR_HOST_SUCCESS) && (offset < streamSize))
+    {
+        chunk = ((streamSize - offset) < maxChunk) ? (streamSize - offset) : maxChunk;
+        data[0] = sequence++;
+        memcpy(&data[1], &stream[offset], chunk);
+        result = BtldrHost_Post(link, BTLDR_HOST_CMD_ROWS_DATA, data, (uint16_t)(chunk + 1u));
+        offset += chunk;
+    }
+
+    if(result == BTLDR_HOST_SUCCESS)
+    {
+        result = BtldrHost_GetRowsDone(link, &done);
+        if(rowsDone != NULL)
+        {
+            *rowsDone = done;
+        }
+        if((result == BTLDR_HOST_SUCCESS) && (done != rowCount))
+        {
+            result = BTLDR_HOST_ERR_INCOMPLETE;
+        }
+    }
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_GetRowsDone
+********************************************************************************
+*
+* Summary:
+*  Acknowledges a burst: reads how many of its rows the bootloader has
+*  committed.
+*
+*******************************************************************************/
+int BtldrHost_GetRowsDone(const BtldrHost_Link *link, uint16_t *rowsDone)
+{
+    uint8_t rsp[3];
+    int result = BtldrHost_Command(link, BTLDR_HOST_CMD_ROWS_STATUS, NULL, 0u, rsp, sizeof(rsp));
+
+    *rowsDone = (result == BTLDR_HOST_SUCCESS) ? GET_WORD(&rsp[0]) : 0u;
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_ProgramRows
+********************************************************************************
+*
+* Summary:
+*  Programs consecutive rows as one raw burst.
+*
+* Parameters:
+*  rows:     rowCount * rowSize bytes.
+*  rowsDone: Receives the number of rows committed, may be NULL.
+*
+* Return:
+*  Status reported by the bootloader or a negative host error.
+*  BTLDR_HOST_ERR_INCOMPLETE if the device committed fewer rows than sent.
+*
+*******************************************************************************/
+int BtldrHost_ProgramRows(const BtldrHost_Link *link, uint8_t arrayId, uint16_t firstRow, uint16_t rowCount,
+                          const uint8_t *rows, uint16_t *rowsDone)
+{
+    return (BtldrHost_Burst(link, arrayId, firstRow, rowCount, BTLDR_HOST_ENCODING_RAW,
+                            rows, (size_t) rowCount * link->rowSize, rowsDone));
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_ProgramRowsLz
+********************************************************************************
+*
+* Summary:
+*  Programs consecutive rows as one LZ encoded burst. The bootloader decodes
+*  the stream as the packets arrive and programs every row as soon as it is
+*  complete. Falls back to a raw burst when the rows do not compress.
+*
+* Parameters:
+*  Same as BtldrHost_ProgramRows().
+*
+* Return:
+*  Same as BtldrHost_ProgramRows().
+*
+*******************************************************************************/
+int BtldrHost_ProgramRowsLz(const BtldrHost_Link *link, uint8_t arrayId, uint16_t firstRow, uint16_t rowCount,
+                            const uint8_t *rows, uint16_t *rowsDone)
+{
+    size_t size = (size_t) rowCount * link->rowSize;
+    uint8_t *stream = malloc(BTLDR_LZ_BOUND(size));
+    size_t streamSize;
+    int result;
+
+    if(stream == NULL)
+    {
+        return (BTLDR_HOST_ERR_ARGUMENT);
+    }
+
+    /* Rows that do not compress are sent raw */
+    streamSize = BtldrLz_Compress(rows, size, stream);
+    if(streamSize < size)
+    {
+        result = BtldrHost_Burst(link, arrayId, firstRow, rowCount, BTLDR_HOST_ENCODING_LZ,
+                                 stream, streamSize, rowsDone);
+    }
+    else
+    {
+        result = BtldrHost_Burst(link, arrayId, firstRow, rowCount, BTLDR_HOST_ENCODING_RAW,
+                                 rows, size, rowsDone);
+    }
+    free(stream);
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_ProgramImage
+********************************************************************************
+*
+* Summary:
+*  Programs consecutive rows either one row at a time (rowsPerBurst is 0) or
+*  in bursts of up to rowsPerBurst rows, raw or LZ encoded.
+*
+*******************************************************************************/
+int BtldrHost_ProgramImage(const BtldrHost_Link *link, uint8_t arrayId, uint16_t firstRow, uint16_t rowCount,
+                           const uint8_t *rows, uint16_t rowsPerBurst, uint8_t encoding)
+{
+    uint16_t done = 0u;
+    uint16_t count;
+    int result = BTLDR_HOST_SUCCESS;
+
+    while((result == BTLDR_HOST_SUCCESS) && (done < rowCount))
+    {
+        if(rowsPerBurst == 0u)
+        {
+            result = BtldrHost_ProgramRow(link, arrayId, (uint16_t)(firstRow + done),
+                                          &rows[(size_t) done * link->rowSize]);
+            done++;
+        }
+        else
+        {
+            count = ((rowCount - done) < rowsPerBurst) ? (uint16_t)(rowCount - done) : rowsPerBurst;
+            if(encoding == BTLDR_HOST_ENCODING_LZ)
+            {
+                result = BtldrHost_ProgramRowsLz(link, arrayId, (uint16_t)(firstRow + done), count,
+                                                 &rows[(size_t) done * link->rowSize], NULL);
+            }
+            else
+            {
+                result = BtldrHost_ProgramRows(link, arrayId, (uint16_t)(firstRow + done), count,
+                                               &rows[(size_t) done * link->rowSize], NULL);
+            }
+            done = (uint16_t)(done + count);
+        }
+    }
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_GetRowHashes
+********************************************************************************
+*
+* Summary:
+*  Reads the hashes of up to BTLDR_HOST_MAX_HASHES installed rows.
+*
+*******************************************************************************/
+int BtldrHost_GetRowHashes(const BtldrHost_Link *link, uint8_t arrayId, uint16_t firstRow, uint8_t count,
+                           uint32_t *hashes)
+{
+    uint8_t data[4];
+    uint8_t rsp[4u * BTLDR_HOST_MAX_HASHES];
+    uint8_t i;
+    int result;
+
+    if((count == 0u) || (count > BTLDR_HOST_MAX_HASHES))
+    {
+        return (BTLDR_HOST_ERR_ARGUMENT);
+    }
+
+    data[0] = arrayId;
+    SET_WORD(&data[1], firstRow);
+    data[3] = count;
+    result = BtldrHost_Command(link, BTLDR_HOST_CMD_GET_ROW_HASHES, data, sizeof(data), rsp, (uint16_t)(4u * count));
+
+    if(result == BTLDR_HOST_SUCCESS)
+    {
+        for(i = 0u; i < count; i++)
+        {
+            hashes[i] = (uint32_t) GET_WORD(&rsp[4u * i]) | ((uint32_t) GET_WORD(&rsp[(4u * i) + 2u]) << 16);
+        }
+    }
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_GetRowsSkipped
+********************************************************************************
+*
+* Summary:
+*  Reads how many rows the bootloader found identical in flash, and did not
+*  program, since the session was entered.
+*
+* Return:
+*  Status reported by the bootloader or a negative host error.
+*  BTLDR_HOST_ERR_FORMAT if the bootloader does not report the count.
+*
+*******************************************************************************/
+int BtldrHost_GetRowsSkipped(const BtldrHost_Link *link, uint16_t *rowsSkipped)
+{
+    uint8_t data[1] = {0u};
+    uint8_t rsp[5];
+    int result = BtldrHost_Command(link, BTLDR_HOST_CMD_ROWS_STATUS, data, sizeof(data), rsp, sizeof(rsp));
+
+    if(result == BTLDR_HOST_SUCCESS)
+    {
+        *rowsSkipped = GET_WORD(&rsp[3]);
+    }
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_OpenJournal
+********************************************************************************
+*
+* Summary:
+*  Opens the progress journal of the update of an image. If the bootloader
+*  holds the journal of an interrupted update of the same image, the rows it
+*  committed need not be sent again.
+*
+* Parameters:
+*  imageId:   Identifier of the image; it must change whenever the image does.
+*  committed: Receives one bit per row from the first row reported by
+*             BtldrHost_GetFlashSize(), LSB first, set if the row is committed.
+*  mapSize:   Size of the bitmap, one bit per row up to the last row.
+*  resumed:   Receives nonzero if the journal was reopened.
+*
+* Return:
+*  Status reported by the bootloader or a negative host error.
+*
+*******************************************************************************/
+int BtldrHost_OpenJournal(const BtldrHost_Link *link, uint32_t imageId, uint8_t *committed, uint16_t mapSize,
+                          int *resumed)
+{
+    uint8_t data[4];
+    uint8_t rsp[BTLDR_HOST_MAX_PACKET - BTLDR_HOST_SIZEOF_OVERHEAD];
+    int result;
+
+    if(((size_t) mapSize + 1u) > sizeof(rsp))
+    {
+        return (BTLDR_HOST_ERR_ARGUMENT);
+    }
+
+    SET_WORD(&data[0], (uint16_t) imageId);
+    SET_WORD(&data[2], (uint16_t)(imageId >> 16));
+    result = BtldrHost_Command(link, BTLDR_HOST_CMD_OPEN_JOURNAL, data, sizeof(data), rsp, (uint16_t)(mapSize + 1u));
+
+    if(result == BTLDR_HOST_SUCCESS)
+    {
+        *resumed = (rsp[0] != 0u);
+        memcpy(committed, &rsp[1], mapSize);
+    }
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_VerifyChecksum
+********************************************************************************
+*
+* Summary:
+*  Asks the bootloader to validate the bootloadable.
+*
+*******************************************************************************/
+int BtldrHost_VerifyChecksum(const BtldrHost_Link *link, int *valid)
+{
+    uint8_t rsp[1];
+    int result = BtldrHost_Command(link, BTLDR_HOST_CMD_VERIFY_CHECKSUM, NULL, 0u, rsp, sizeof(rsp));
+
+    if(result == BTLDR_HOST_SUCCESS)
+    {
+        *valid = (rsp[0] != 0u);
+    }
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_VerifyImage
+********************************************************************************
+*
+* Summary:
+*  Asks the bootloader to verify the rows programmed since Enter against
+*  their image hash, as kept by the bootloader while it programmed them or,
+*  with readBack, read back from flash together with the checksum of the
+*  whole bootloadable.
+*
+* Parameters:
+*  digest:   Sum of the BtldrHost_RowDigest() of the rows sent.
+*  rowCount: Number of rows sent.
+*  valid:    Receives nonzero if the image passed.
+*
+* Return:
+*  Status reported by the bootloader or a negative host error. Bootloaders
+*  without the command report BTLDR_HOST_ERR_CMD.
+*
+*******************************************************************************/
+int BtldrHost_VerifyImage(const BtldrHost_Link *link, uint32_t digest, uint16_t rowCount, int readBack, int *valid)
+{
+    uint8_t data[7];
+    uint8_t rsp[1];
+    int result;
+
+    SET_WORD(&data[0], (uint16_t) digest);
+    SET_WORD(&data[2], (uint16_t)(digest >> 16));
+    SET_WORD(&data[4], rowCount);
+    data[6] = (readBack != 0) ? BTLDR_HOST_VERIFY_READ_BACK : 0u;
+
+    result = BtldrHost_Command(link, BTLDR_HOST_CMD_VERIFY_IMAGE, data, sizeof(data), rsp, sizeof(rsp));
+    if(result == BTLDR_HOST_SUCCESS)
+    {
+        *valid = (rsp[0] != 0u);
+    }
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_GetCounters
+********************************************************************************
+*
+* Summary:
+*  Reads the performance counters the bootloader keeps for each of its
+*  commands since Enter, BTLDR_HOST_COUNTERS_PER_RSP commands per query, and
+*  converts its cycles to seconds at the clock it reports.
+*
+* Parameters:
+*  counters:    Receives the counters, in the order of the command table.
+*  maxCounters: Size of counters.
+*  count:       Receives the number of counters stored.
+*
+* Return:
+*  Status reported by the bootloader or a negative host error. Bootloaders
+*  without the counters report BTLDR_HOST_ERR_CMD.
+*  BTLDR_HOST_ERR_FORMAT if the clock is reported as zero.
+*
+*******************************************************************************/
+int BtldrHost_GetCounters(const BtldrHost_Link *link, BtldrHost_Counter *counters, size_t maxCounters,
+                          size_t *count)
+{
+    uint8_t data[1];
+    uint8_t rsp[5u + (BTLDR_HOST_COUNTERS_PER_RSP * BTLDR_HOST_SIZEOF_COUNTER)];
+    const uint8_t *entry;
+    size_t total = 1u;
+    double cycleTime;
+    size_t i;
+    int result = BTLDR_HOST_SUCCESS;
+
+    *count = 0u;
+    while((result == BTLDR_HOST_SUCCESS) && (*count < total) && (*count < maxCounters))
+    {
+        data[0] = (uint8_t) *count;
+        result = BtldrHost_Command(link, BTLDR_HOST_CMD_GET_COUNTERS, data, sizeof(data), rsp, sizeof(rsp));
+        if((result == BTLDR_HOST_SUCCESS) && (GET_LONG(&rsp[1]) == 0u))
+        {
+            result = BTLDR_HOST_ERR_FORMAT;
+        }
+        if(result == BTLDR_HOST_SUCCESS)
+        {
+            total = rsp[0];
+            cycleTime = 1.0 / (double) GET_LONG(&rsp[1]);
+            entry = &rsp[5];
+            for(i = 0u; (i < BTLDR_HOST_COUNTERS_PER_RSP) && (*count < total) && (*count < maxCounters); i++)
+            {
+                counters[*count].command = entry[0];
+                counters[*count].calls = GET_WORD(&entry[1]);
+                counters[*count].time = (double) GET_LONG(&entry[3]) * cycleTime;
+                counters[*count].maxTime = (double) GET_LONG(&entry[7]) * cycleTime;
+                counters[*count].flashTime = (double) GET_LONG(&entry[11]) * cycleTime;
+                counters[*count].waitTime = (double) GET_LONG(&entry[15]) * cycleTime;
+                entry = &entry[BTLDR_HOST_SIZEOF_COUNTER];
+                (*count)++;
+            }
+        }
+    }
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_SelectApp
+********************************************************************************
+*
+* Summary:
+*  Selects the resident application the bootloader launches from the next
+*  Exit on, without programming any row.
+*
+* Parameters:
+*  app: BTLDR_HOST_APP_A or BTLDR_HOST_APP_B.
+*
+* Return:
+*  Status reported by the bootloader or a negative host error.
+*  BTLDR_HOST_ERR_APP if no application is committed to slot B. Bootloaders
+*  with a single application report BTLDR_HOST_ERR_CMD.
+*
+*******************************************************************************/
+int BtldrHost_SelectApp(const BtldrHost_Link *link, uint8_t app)
+{
+    return (BtldrHost_Command(link, BTLDR_HOST_CMD_SELECT_APP, &app, 1u, NULL, 0u));
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrHost_Exit
+********************************************************************************
+*
+* Summary:
+*  Ends the session. The bootloader resets into the bootloadable and does not
+*  answer.
+*
+*******************************************************************************/
+int BtldrHost_Exit(const BtldrHost_Link *link)
+{
+    return (BtldrHost_Post(link, BTLDR_HOST_CMD_EXIT, NULL, 0u));
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,147 @@
+/*******************************************************************************
+* File: btldr_host.h
+*
+* Version: 1.0
+*
+* Description:
+*  Host side of the extended bootloader host link implemented by the CE95281
+*  bootloader (btldr_ext.c). Builds and checks packets and runs the command
+*  sequences over a caller-supplied I2C transport.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#if !defined(BTLDR_HOST_H)
+#define BTLDR_HOST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/***************************************
+*        Protocol constants
+***************************************/
+
+/* These values must match btldr_ext.h of the CE95281 project */
+#define BTLDR_HOST_SOP                  (0x01u)
+#define BTLDR_HOST_EOP                  (0x17u)
+#define BTLDR_HOST_SIZEOF_HEADER        (4u)
+#define BTLDR_HOST_SIZEOF_OVERHEAD      (7u)
+#define BTLDR_HOST_MAX_PACKET           (64u)
+
+#define BTLDR_HOST_CMD_VERIFY_CHECKSUM  (0x31u)
+#define BTLDR_HOST_CMD_GET_FLASH_SIZE   (0x32u)
+#define BTLDR_HOST_CMD_ERASE_ROW        (0x34u)
+#define BTLDR_HOST_CMD_SYNC             (0x35u)
+#define BTLDR_HOST_CMD_SEND_DATA        (0x37u)
+#define BTLDR_HOST_CMD_ENTER            (0x38u)
+#define BTLDR_HOST_CMD_PROGRAM_ROW      (0x39u)
+#define BTLDR_HOST_CMD_VERIFY_ROW       (0x3Au)
+#define BTLDR_HOST_CMD_EXIT             (0x3Bu)
+#define BTLDR_HOST_CMD_PROGRAM_ROWS     (0x40u)
+#define BTLDR_HOST_CMD_ROWS_DATA        (0x41u)
+#define BTLDR_HOST_CMD_ROWS_STATUS      (0x42u)
+#define BTLDR_HOST_CMD_GET_ROW_HASHES   (0x43u)
+#define BTLDR_HOST_CMD_OPEN_JOURNAL     (0x44u)
+#define BTLDR_HOST_CMD_VERIFY_IMAGE     (0x45u)
+#define BTLDR_HOST_VERIFY_READ_BACK     (0x01u)
+#define BTLDR_HOST_CMD_GET_COUNTERS     (0x46u)
+#define BTLDR_HOST_COUNTERS_PER_RSP     (2u)
+#define BTLDR_HOST_SIZEOF_COUNTER       (19u)
+#define BTLDR_HOST_CMD_SELECT_APP       (0x47u)
+#define BTLDR_HOST_APP_A                (0x00u)
+#define BTLDR_HOST_APP_B                (0x01u)
+#define BTLDR_HOST_ENCODING_RAW         (0x00u)
+#define BTLDR_HOST_ENCODING_LZ          (0x01u)
+#define BTLDR_HOST_MAX_HASHES           ((BTLDR_HOST_MAX_PACKET - BTLDR_HOST_SIZEOF_OVERHEAD) / 4u)
+
+/* Device status codes are returned as positive values */
+#define BTLDR_HOST_SUCCESS              (0)
+#define BTLDR_HOST_ERR_CMD              (0x05)
+#define BTLDR_HOST_ERR_APP              (0x0C)
+#define BTLDR_HOST_ERR_SEQUENCE         (0x10)
+
+/* Host side errors are negative */
+#define BTLDR_HOST_ERR_COMM             (-1)
+#define BTLDR_HOST_ERR_FORMAT           (-2)
+#define BTLDR_HOST_ERR_ARGUMENT         (-3)
+#define BTLDR_HOST_ERR_INCOMPLETE       (-4)
+
+
+/***************************************
+*        Types
+***************************************/
+
+/* One call is one I2C transaction. Both functions return 0 on success. */
+typedef struct
+{
+    void *context;
+    int (*write)(void *context, const uint8_t *data, size_t size);
+    int (*read)(void *context, uint8_t *data, size_t size);
+} BtldrHost_Transport;
+
+typedef struct
+{
+    const BtldrHost_Transport *transport;
+    size_t   packetSize;                /* largest packet sent, at most BTLDR_HOST_MAX_PACKET */
+    uint16_t rowSize;                   /* flash row size of the device */
+} BtldrHost_Link;
+
+/* Performance counters of one command since Enter */
+typedef struct
+{
+    uint8_t  command;
+    uint16_t calls;                     /* saturates at 0xFFFF */
+    double   time;                      /* in the command, flash writes included, s */
+    double   maxTime;                   /* of the longest call, s */
+    double   flashTime;                 /* writing rows and waiting for background writes, s */
+    double   waitTime;                  /* waiting for the command and for the host to read the response, s */
+} BtldrHost_Counter;
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+uint16_t BtldrHost_Checksum(const uint8_t *buffer, size_t size);
+uint32_t BtldrHost_RowHash(const uint8_t *rowData, size_t size);
+uint32_t BtldrHost_RowDigest(uint16_t row, const uint8_t *rowData, size_t size);
+size_t   BtldrHost_BuildPacket(uint8_t *packet, uint8_t command, const uint8_t *data, uint16_t length);
+
+int BtldrHost_Post(const BtldrHost_Link *link, uint8_t command, const uint8_t *data, uint16_t length);
+int BtldrHost_Command(const BtldrHost_Link *link, uint8_t command, const uint8_t *data, uint16_t length,
+                      uint8_t *rsp, uint16_t rspLength);
+
+int BtldrHost_Enter(const BtldrHost_Link *link, uint32_t *siliconId, uint8_t *siliconRev);
+int BtldrHost_GetFlashSize(const BtldrHost_Link *link, uint8_t arrayId, uint16_t *firstRow, uint16_t *lastRow);
+int BtldrHost_ProgramRow(const BtldrHost_Link *link, uint8_t arrayId, uint16_t row, const uint8_t *rowData);
+int BtldrHost_GetRowsDone(const BtldrHost_Link *link, uint16_t *rowsDone);
+int BtldrHost_ProgramRows(const BtldrHost_Link *link, uint8_t arrayId, uint16_t firstRow, uint16_t rowCount,
+                          const uint8_t *rows, uint16_t *rowsDone);
+int BtldrHost_ProgramRowsLz(const BtldrHost_Link *link, uint8_t arrayId, uint16_t firstRow, uint16_t rowCount,
+                            const uint8_t *rows, uint16_t *rowsDone);
+int BtldrHost_ProgramImage(const BtldrHost_Link *link, uint8_t arrayId, uint16_t firstRow, uint16_t rowCount,
+                           const uint8_t *rows, uint16_t rowsPerBurst, uint8_t encoding);
+int BtldrHost_GetRowHashes(const BtldrHost_Link *link, uint8_t arrayId, uint16_t firstRow, uint8_t count,
+                           uint32_t *hashes);
+int BtldrHost_GetRowsSkipped(const BtldrHost_Link *link, uint16_t *rowsSkipped);
+int BtldrHost_OpenJournal(const BtldrHost_Link *link, uint32_t imageId, uint8_t *committed, uint16_t mapSize,
+                          int *resumed);
+int BtldrHost_VerifyChecksum(const BtldrHost_Link *link, int *valid);
+int BtldrHost_VerifyImage(const BtldrHost_Link *link, uint32_t digest, uint16_t rowCount, int readBack, int *valid);
+int BtldrHost_GetCounters(const BtldrHost_Link *link, BtldrHost_Counter *counters, size_t maxCounters,
+                          size_t *count);
+int BtldrHost_SelectApp(const BtldrHost_Link *link, uint8_t app);
+int BtldrHost_Exit(const BtldrHost_Link *link);
+
+#endif /* BTLDR_HOST_H */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,639 @@
+/*******************************************************************************
+* File: btldr_image.c
+*
+* Version: 1.0
+*
+* Description:
+*  Programs a whole .cyacd image through the extended bootloader host link.
+*  In delta mode the installed row hashes are read first and only the rows
+*  that differ are transferred, so unchanged rows are neither sent nor
+*  written. A .cyacd stream can also be sent while it is parsed. With the
+*  progress journal of the bootloader, an update interrupted by a reset or a
+*  link failure resumes from the rows it had not committed.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "btldr_crc.h"
+#include "btldr_image.h"
+
+/* Rows committed by an earlier attempt to install the same image */
+typedef struct
+{
+    uint16_t firstRow;                  /* row of bit 0 */
+    uint16_t rowCount;                  /* rows in the map, 0 without a journal */
+    uint8_t  committed[BTLDR_HOST_MAX_PACKET];
+} BtldrImage_Journal;
+
+/* Number of rows from index first that follow each other in the same array
+* and satisfy the changed filter (NULL accepts every row), at most limit.
+*/
+static size_t BtldrImage_RunLength(const Cyacd_Image *image, const uint8_t *changed, size_t first, size_t limit)
+{
+    size_t count = 1u;
+
+    while(((first + count) < image->rowCount) && (count < limit) &&
+          (image->rows[first + count].arrayId == image->rows[first].arrayId) &&
+          (image->rows[first + count].row == (uint16_t)(image->rows[first].row + count)) &&
+          ((changed == NULL) || (changed[first + count] != 0u)))
+    {
+        count++;
+    }
+
+    return (count);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrImage_FindChanged
+********************************************************************************
+*
+* Summary:
+*  Reads the installed row hashes and clears changed[] for every image row
+*  whose hash matches.
+*
+*******************************************************************************/
+static int BtldrImage_FindChanged(const BtldrHost_Link *link, const Cyacd_Image *image, uint8_t *changed)
+{
+    uint32_t hashes[BTLDR_HOST_MAX_HASHES];
+    const Cyacd_Row *row;
+    size_t first = 0u;
+    size_t count;
+    size_t i;
+    int result = BTLDR_HOST_SUCCESS;
+
+    while((result == BTLDR_HOST_SUCCESS) && (first < image->rowCount))
+    {
+        count = BtldrImage_RunLength(image, NULL, first, BTLDR_HOST_MAX_HASHES);
+        row = &image->rows[first];
+
+        result = BtldrHost_GetRowHashes(link, row->arrayId, row->row, (uint8_t) count, hashes);
+        for(i = 0u; (result == BTLDR_HOST_SUCCESS) && (i < count); i++)
+        {
+            if(BtldrHost_RowHash(row[i].data, row[i].size) == hashes[i])
+            {
+                changed[first + i] = 0u;
+            }
+        }
+        first += count;
+    }
+
+    return (result);
+}
+
+
+/* Continues the ID that names an image to the progress journal with one
+* row: its array, its row number and its data. BtldrImage_Update() and
+* BtldrImage_UpdateStream() take the rows in file order, so the two agree
+* on the ID of a file.
+*/
+static uint32_t BtldrImage_IdRow(uint32_t imageId, uint8_t arrayId, uint16_t row, const uint8_t *data, size_t size)
+{
+    uint8_t rowId[3];
+
+    rowId[0] = arrayId;
+    rowId[1] = (uint8_t) row;
+    rowId[2] = (uint8_t)(row >> 8);
+    imageId = BtldrCrc_Update(imageId, rowId, sizeof(rowId));
+
+    return (BtldrCrc_Update(imageId, data, size));
+}
+
+/* Image ID and row count of a stream, parsed from a copy of it so the
+* stream itself stays before its first row
+*/
+static int BtldrImage_StreamId(const Cyacd_Stream *stream, uint16_t rowSize, uint32_t *imageId, size_t *rowCount)
+{
+    Cyacd_Stream scan = *stream;
+    Cyacd_Row row;
+    uint8_t *data = malloc(rowSize);
+    int parsed = CYACD_ERR_MEMORY;
+    int result = BTLDR_HOST_ERR_ARGUMENT;
+
+    *imageId = BTLDR_CRC_INIT;
+    *rowCount = 0u;
+    if(data != NULL)
+    {
+        parsed = Cyacd_NextRow(&scan, &row, data, rowSize);
+    }
+    while((parsed == CYACD_SUCCESS) && (row.size == rowSize))
+    {
+        *imageId = BtldrImage_IdRow(*imageId, row.arrayId, row.row, data, rowSize);
+        (*rowCount)++;
+        parsed = Cyacd_NextRow(&scan, &row, data, rowSize);
+    }
+
+    if(parsed == CYACD_END)
+    {
+        result = BTLDR_HOST_SUCCESS;
+    }
+    else if((parsed == CYACD_ERR_SIZE) || (parsed == CYACD_SUCCESS))
+    {
+        result = BTLDR_IMAGE_ERR_ROW_SIZE;
+    }
+    else if(data != NULL)
+    {
+        result = BTLDR_IMAGE_ERR_FORMAT;
+    }
+    else
+    {
+        /* Out of memory */
+    }
+    free(data);
+
+    return (result);
+}
+
+/*******************************************************************************
+* Function Name: BtldrImage_OpenJournal
+********************************************************************************
+*
+* Summary:
+*  Opens the progress journal of the image on the bootloader. A bootloader
+*  without a journal leaves the journal empty, and the update runs without
+*  one.
+*
+*******************************************************************************/
+static int BtldrImage_OpenJournal(const BtldrHost_Link *link, uint32_t imageId, BtldrImage_Journal *journal)
+{
+    uint16_t firstRow;
+    uint16_t lastRow;
+    uint16_t mapSize;
+    int resumed;
+    int result;
+
+    journal->rowCount = 0u;
+
+    result = BtldrHost_GetFlashSize(link, 0u, &firstRow, &lastRow);
+    if((result != BTLDR_HOST_SUCCESS) || (lastRow < firstRow))
+    {
+        return (result);
+    }
+
+    mapSize = (uint16_t)(((lastRow - firstRow) + 8u) / 8u);
+    if(mapSize >= sizeof(journal->committed))
+    {
+        return (BTLDR_HOST_SUCCESS);
+    }
+
+    result = BtldrHost_OpenJournal(link, imageId, journal->committed, mapSize, &resumed);
+    if(result == BTLDR_HOST_SUCCESS)
+    {
+        journal->firstRow = firstRow;
+        journal->rowCount = (uint16_t)((lastRow - firstRow) + 1u);
+    }
+    else if(result > BTLDR_HOST_SUCCESS)
+    {
+        /* The command is not supported */
+        result = BTLDR_HOST_SUCCESS;
+    }
+    else
+    {
+        /* Link failure */
+    }
+
+    return (result);
+}
+
+/* Nonzero if the journal holds the row */
+static int BtldrImage_Committed(const BtldrImage_Journal *journal, uint8_t arrayId, uint16_t row)
+{
+    uint16_t bit = (uint16_t)(row - journal->firstRow);
+
+    return ((arrayId == 0u) && (row >= journal->firstRow) && (bit < journal->rowCount) &&
+            ((journal->committed[bit / 8u] & (1u << (bit % 8u))) != 0u));
+}
+
+
+/* Counts count consecutive rows as sent and adds them to the image hash */
+static void BtldrImage_Sent(BtldrImage_Stats *stats, uint16_t firstRow, size_t count, const uint8_t *rows,
+                            size_t rowSize)
+{
+    size_t i;
+
+    for(i = 0u; i < count; i++)
+    {
+        stats->digestSent += BtldrHost_RowDigest((uint16_t)(firstRow + i), &rows[i * rowSize], rowSize);
+    }
+    stats->rowsSent += count;
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrImage_Finish
+********************************************************************************
+*
+* Summary:
+*  Reads how many of the sent rows the bootloader found already programmed,
+*  then asks it to verify the rows sent against their image hash, which it
+*  keeps while it programs them, or with readBack against the flash. A
+*  bootloader without the image hash validates the checksum of the whole
+*  bootloadable instead. Bootloaders that do not report the count leave
+*  rowsIdentical at zero.
+*
+*******************************************************************************/
+static int BtldrImage_Finish(const BtldrHost_Link *link, const BtldrImage_Options *options, BtldrImage_Stats *stats)
+{
+    uint16_t rowsSkipped;
+    int valid = 0;
+    int result;
+
+    if(BtldrHost_GetRowsSkipped(link, &rowsSkipped) == BTLDR_HOST_SUCCESS)
+    {
+        stats->rowsIdentical = rowsSkipped;
+    }
+
+    result = BtldrHost_VerifyImage(link, stats->digestSent, (uint16_t) stats->rowsSent, options->readBack, &valid);
+    if(result == BTLDR_HOST_ERR_CMD)
+    {
+        result = BtldrHost_VerifyChecksum(link, &valid);
+    }
+    if((result == BTLDR_HOST_SUCCESS) && (valid == 0))
+    {
+        result = BTLDR_IMAGE_ERR_INVALID;
+    }
+
+    return (result);
+}
+
+/*******************************************************************************
+* Function Name: BtldrImage_Update
+********************************************************************************
+*
+* Summary:
+*  Enters the bootloader, checks the silicon ID, programs the image rows and
+*  asks the bootloader to validate the result. The session is left open; call
+*  BtldrHost_Exit() to start the new application.
+*
+* Parameters:
+*  options: Burst size, delta mode, compression and resume. Resume is
+*           ignored in delta mode and below BTLDR_IMAGE_JOURNAL_MIN_ROWS
+*           rows.
+*  stats:   Receives the row counts, may be NULL.
+*
+* Return:
+*  BTLDR_HOST_SUCCESS, a device status, a negative BTLDR_HOST_ERR code or a
+*  BTLDR_IMAGE_ERR code.
+*
+*******************************************************************************/
+int BtldrImage_Update(const BtldrHost_Link *link, const Cyacd_Image *image,
+                      const BtldrImage_Options *options, BtldrImage_Stats *stats)
+{
+    BtldrImage_Stats local;
+    BtldrImage_Journal journal;
+    uint8_t *changed;
+    uint8_t *staging;
+    uint32_t siliconId;
+    uint32_t imageId = BTLDR_CRC_INIT;
+    size_t i = 0u;
+    size_t j;
+    size_t count;
+    int result;
+
+    if(stats == NULL)
+    {
+        stats = &local;
+    }
+    memset(stats, 0, sizeof(*stats));
+    stats->rowsTotal = image->rowCount;
+
+    for(j = 0u; j < image->rowCount; j++)
+    {
+        if(image->rows[j].size != link->rowSize)
+        {
+            return (BTLDR_IMAGE_ERR_ROW_SIZE);
+        }
+    }
+
+    result = BtldrHost_Enter(link, &siliconId, NULL);
+    if(result != BTLDR_HOST_SUCCESS)
+    {
+        return (result);
+    }
+    if(siliconId != image->siliconId)
+    {
+        return (BTLDR_IMAGE_ERR_DEVICE);
+    }
+
+    changed = malloc(image->rowCount + 1u);
+    staging = malloc(((size_t) options->rowsPerBurst + 1u) * link->rowSize);
+    if((changed == NULL) || (staging == NULL))
+    {
+        free(changed);
+        free(staging);
+        return (BTLDR_HOST_ERR_ARGUMENT);
+    }
+    memset(changed, 1, image->rowCount + 1u);
+
+    journal.rowCount = 0u;
+    if((options->resume != 0) && (options->delta == 0) && (image->rowCount >= BTLDR_IMAGE_JOURNAL_MIN_ROWS))
+    {
+        /* The journal identifies the image by the hash of its rows */
+        for(j = 0u; j < image->rowCount; j++)
+        {
+            imageId = BtldrImage_IdRow(imageId, image->rows[j].arrayId, image->rows[j].row, image->rows[j].data,
+                                       link->rowSize);
+        }
+        result = BtldrImage_OpenJournal(link, imageId, &journal);
+    }
+
+    if((result == BTLDR_HOST_SUCCESS) && (options->delta != 0))
+    {
+        result = BtldrImage_FindChanged(link, image, changed);
+    }
+
+    for(j = 0u; j < image->rowCount; j++)
+    {
+        if((changed[j] != 0u) && BtldrImage_Committed(&journal, image->rows[j].arrayId, image->rows[j].row))
+        {
+            changed[j] = 0u;
+            stats->rowsResumed++;
+        }
+    }
+
+    while((result == BTLDR_HOST_SUCCESS) && (i < image->rowCount))
+    {
+        if(changed[i] == 0u)
+        {
+            stats->rowsSkipped++;
+            i++;
+        }
+        else if(options->rowsPerBurst == 0u)
+        {
+            result = BtldrHost_ProgramRow(link, image->rows[i].arrayId, image->rows[i].row, image->rows[i].data);
+            BtldrImage_Sent(stats, image->rows[i].row, 1u, image->rows[i].data, link->rowSize);
+            i++;
+        }
+        else
+        {
+            count = BtldrImage_RunLength(image, changed, i, options->rowsPerBurst);
+            for(j = 0u; j < count; j++)
+            {
+                memcpy(&staging[j * link->rowSize], image->rows[i + j].data, link->rowSize);
+            }
+            if(options->compress != 0)
+            {
+                result = BtldrHost_ProgramRowsLz(link, image->rows[i].arrayId, image->rows[i].row,
+                                                 (uint16_t) count, staging, NULL);
+            }
+            else
+            {
+                result = BtldrHost_ProgramRows(link, image->rows[i].arrayId, image->rows[i].row,
+                                               (uint16_t) count, staging, NULL);
+            }
+            BtldrImage_Sent(stats, image->rows[i].row, count, staging, link->rowSize);
+            i += count;
+        }
+    }
+
+    free(changed);
+    free(staging);
+
+    if(result == BTLDR_HOST_SUCCESS)
+    {
+        result = BtldrImage_Finish(link, options, stats);
+    }
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrImage_SendRows
+********************************************************************************
+*
+* Summary:
+*  Sends count consecutive rows of a stream. In delta mode the installed
+*  hashes of the rows are read first and only the changed runs are sent.
+*
+* Parameters:
+*  rows:    count * rowSize bytes.
+*  changed: count bytes of scratch memory.
+*  journal: Rows committed by an interrupted update, which are not sent.
+*
+*******************************************************************************/
+static int BtldrImage_SendRows(const BtldrHost_Link *link, uint8_t arrayId, uint16_t firstRow, size_t count,
+                               const uint8_t *rows, uint8_t *changed, const BtldrImage_Journal *journal,
+                               const BtldrImage_Options *options, BtldrImage_Stats *stats)
+{
+    uint32_t hashes[BTLDR_HOST_MAX_HASHES];
+    size_t i = 0u;
+    size_t j;
+    size_t run;
+    int result = BTLDR_HOST_SUCCESS;
+
+    memset(changed, 1, count);
+    while((options->delta != 0) && (result == BTLDR_HOST_SUCCESS) && (i < count))
+    {
+        run = ((count - i) < BTLDR_HOST_MAX_HASHES) ? (count - i) : BTLDR_HOST_MAX_HASHES;
+        result = BtldrHost_GetRowHashes(link, arrayId, (uint16_t)(firstRow + i), (uint8_t) run, hashes);
+        for(j = 0u; (result == BTLDR_HOST_SUCCESS) && (j < run); j++)
+        {
+            if(BtldrHost_RowHash(&rows[(i + j) * link->rowSize], link->rowSize) == hashes[j])
+            {
+                changed[i + j] = 0u;
+            }
+        }
+        i += run;
+    }
+
+    for(i = 0u; i < count; i++)
+    {
+        if((changed[i] != 0u) && BtldrImage_Committed(journal, arrayId, (uint16_t)(firstRow + i)))
+        {
+            changed[i] = 0u;
+            stats->rowsResumed++;
+        }
+    }
+
+    i = 0u;
+    while((result == BTLDR_HOST_SUCCESS) && (i < count))
+    {
+        for(run = 0u; ((i + run) < count) && (changed[i + run] == changed[i]); run++)
+        {
+        }
+
+        if(changed[i] == 0u)
+        {
+            stats->rowsSkipped += run;
+        }
+        else if(options->rowsPerBurst == 0u)
+        {
+            for(j = 0u; (result == BTLDR_HOST_SUCCESS) && (j < run); j++)
+            {
+                result = BtldrHost_ProgramRow(link, arrayId, (uint16_t)(firstRow + i + j),
+                                              &rows[(i + j) * link->rowSize]);
+            }
+            BtldrImage_Sent(stats, (uint16_t)(firstRow + i), run, &rows[i * link->rowSize], link->rowSize);
+        }
+        else if(options->compress != 0)
+        {
+            result = BtldrHost_ProgramRowsLz(link, arrayId, (uint16_t)(firstRow + i), (uint16_t) run,
+                                             &rows[i * link->rowSize], NULL);
+            BtldrImage_Sent(stats, (uint16_t)(firstRow + i), run, &rows[i * link->rowSize], link->rowSize);
+        }
+        else
+        {
+            result = BtldrHost_ProgramRows(link, arrayId, (uint16_t)(firstRow + i), (uint16_t) run,
+                                           &rows[i * link->rowSize], NULL);
+            BtldrImage_Sent(stats, (uint16_t)(firstRow + i), run, &rows[i * link->rowSize], link->rowSize);
+        }
+        i += run;
+    }
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrImage_UpdateStream
+********************************************************************************
+*
+* Summary:
+*  Same as BtldrImage_Update() for an image that is parsed while it is sent.
+*  Rows are parsed straight into the staging buffer of the next burst, which
+*  is sent as soon as it is full or the next row does not follow it, so the
+*  first burst leaves before the rest of the file is read. Only when a
+*  journal is to be kept is the file parsed once beforehand, for the image
+*  ID, which is the one BtldrImage_Update() gives the same file.
+*
+* Parameters:
+*  stream:  Open stream positioned before the first row.
+*  options: Burst size, delta mode, compression and resume, as for
+*           BtldrImage_Update().
+*  stats:   Receives the row counts, may be NULL.
+*
+* Return:
+*  Same as BtldrImage_Update(), or BTLDR_IMAGE_ERR_FORMAT if a row of the
+*  file is malformed. The rows before it may have been programmed.
+*
+*******************************************************************************/
+int BtldrImage_UpdateStream(const BtldrHost_Link *link, Cyacd_Stream *stream,
+                            const BtldrImage_Options *options, BtldrImage_Stats *stats)
+{
+    BtldrImage_Stats local;
+    BtldrImage_Journal journal;
+    Cyacd_Row row;
+    uint8_t *changed;
+    uint8_t *staging;
+    uint32_t siliconId;
+    uint32_t imageId = BTLDR_CRC_INIT;
+    size_t rowCount = 0u;
+    uint16_t firstRow = 0u;
+    uint8_t arrayId = 0u;
+    size_t capacity = (options->rowsPerBurst != 0u) ? options->rowsPerBurst : BTLDR_HOST_MAX_HASHES;
+    size_t count = 0u;
+    int parsed;
+    int result;
+
+    if(stats == NULL)
+    {
+        stats = &local;
+    }
+    memset(stats, 0, sizeof(*stats));
+
+    if((options->resume != 0) && (options->delta == 0))
+    {
+        result = BtldrImage_StreamId(stream, link->rowSize, &imageId, &rowCount);
+        if(result != BTLDR_HOST_SUCCESS)
+        {
+            return (result);
+        }
+    }
+
+    result = BtldrHost_Enter(link, &siliconId, NULL);
+    if(result != BTLDR_HOST_SUCCESS)
+    {
+        return (result);
+    }
+    if(siliconId != stream->siliconId)
+    {
+        return (BTLDR_IMAGE_ERR_DEVICE);
+    }
+
+    journal.rowCount = 0u;
+    if(rowCount >= BTLDR_IMAGE_JOURNAL_MIN_ROWS)
+    {
+        result = BtldrImage_OpenJournal(link, imageId, &journal);
+        if(result != BTLDR_HOST_SUCCESS)
+        {
+            return (result);
+        }
+    }
+
+    changed = malloc(capacity);
+    staging = malloc(capacity * link->rowSize);
+    if((changed == NULL) || (staging == NULL))
+    {
+        free(changed);
+        free(staging);
+        return (BTLDR_HOST_ERR_ARGUMENT);
+    }
+
+    while(result == BTLDR_HOST_SUCCESS)
+    {
+        parsed = Cyacd_NextRow(stream, &row, &staging[count * link->rowSize], link->rowSize);
+        if(parsed == CYACD_END)
+        {
+            break;
+        }
+        if((parsed == CYACD_ERR_SIZE) || ((parsed == CYACD_SUCCESS) && (row.size != link->rowSize)))
+        {
+            result = BTLDR_IMAGE_ERR_ROW_SIZE;
+            break;
+        }
+        if(parsed != CYACD_SUCCESS)
+        {
+            result = BTLDR_IMAGE_ERR_FORMAT;
+            break;
+        }
+        stats->rowsTotal++;
+
+        /* A gap in the rows ends the burst; the new row moves to its start */
+        if((count != 0u) && ((row.arrayId != arrayId) || (row.row != (uint16_t)(firstRow + count))))
+        {
+            result = BtldrImage_SendRows(link, arrayId, firstRow, count, staging, changed, &journal, options, stats);
+            memmove(staging, &staging[count * link->rowSize], link->rowSize);
+            count = 0u;
+        }
+        if(count == 0u)
+        {
+            arrayId = row.arrayId;
+            firstRow = row.row;
+        }
+        count++;
+
+        if((result == BTLDR_HOST_SUCCESS) && (count == capacity))
+        {
+            result = BtldrImage_SendRows(link, arrayId, firstRow, count, staging, changed, &journal, options, stats);
+            count = 0u;
+        }
+    }
+
+    if((result == BTLDR_HOST_SUCCESS) && (count != 0u))
+    {
+        result = BtldrImage_SendRows(link, arrayId, firstRow, count, staging, changed, &journal, options, stats);
+    }
+
+    free(changed);
+    free(staging);
+
+    if(result == BTLDR_HOST_SUCCESS)
+    {
+        result = BtldrImage_Finish(link, options, stats);
+    }
+
+    return (result);
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,845 @@
+/*******************************************************************************
+* File: btldr_layout.c
+*
+* Version: 1.0
+*
+* Description:
+*  Command line tool that keeps the flash layout of the CE95280 bootloadable
+*  stable from one release to the next, so that the delta update of
+*  btldr_update only sends the rows that really changed. Without it, code
+*  added to a function moves every function linked after it and the update
+*  rewrites most of the image.
+*
+*  "manifest" records a release: the address and size of every input section
+*  of the .text output section, taken from the map file of the GCC linker,
+*  and the CRC-32C of every row of the .cyacd image. Given the manifest of
+*  the previous release, it also reports how many rows the new image changes.
+*
+*  "pin" plans the layout of the next build from the map file of a plain
+*  link and the manifest of the previous release. A section that still fits
+*  keeps its address. New sections and sections that grew are placed, the
+*  largest first, into the gaps left by removed and moved sections, and the
+*  rest after the end of the previous layout. The plan is written as a linker
+*  script fragment to include at the start of the .text output section of a
+*  custom cm0gcc.ld, before the generic input section patterns; the sections
+*  it does not name are placed after it by those patterns. The tool reports
+*  the rows the new layout touches, not counting code that changed in place.
+*
+*  Sections are identified by their name and the file name of their object,
+*  so the project must be built with -ffunction-sections -fdata-sections.
+*  Sections of linker stubs and of objects whose name does not identify them
+*  are left to the linker.
+*
+*  Build: gcc -O2 -I. -o btldr_layout btldr_layout.c btldr_crc.c cyacd.c
+*  Usage: btldr_layout manifest <build.map> <image.cyacd> <release.manifest> [<previous.manifest>]
+*         btldr_layout pin <previous.manifest> <build.map> <pinned.ld>
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "btldr_crc.h"
+#include "cyacd.h"
+
+#define LAYOUT_OUTPUT_SECTION   ".text"
+#define LAYOUT_ROW_SIZE         (128u)
+#define LAYOUT_MAX_NAME         (256u)
+#define LAYOUT_MAX_LINE         (1024u)
+
+/* Largest alignment an input section may need */
+#define LAYOUT_ALIGN            (8u)
+
+/* Placement of a section of the new build */
+#define LAYOUT_PINNED           (0)     /* at its address in the previous release */
+#define LAYOUT_GAP              (1)     /* in a gap of the previous layout */
+#define LAYOUT_APPENDED         (2)     /* after the previous layout, by the linker */
+
+typedef struct
+{
+    char     name[LAYOUT_MAX_NAME];     /* input section */
+    char     object[LAYOUT_MAX_NAME];   /* file name of the object, archive:member for a library */
+    uint32_t address;
+    uint32_t size;
+    int      placement;
+} Layout_Section;
+
+typedef struct
+{
+    uint8_t  arrayId;
+    uint16_t row;
+    uint32_t hash;
+} Layout_Row;
+
+typedef struct
+{
+    uint32_t        base;               /* start of the output section */
+    uint32_t        end;                /* end of its last input section */
+    Layout_Section *sections;
+    size_t          sectionCount;
+    Layout_Row     *rows;               /* manifest only */
+    size_t          rowCount;
+} Layout_Map;
+
+/* Free range of the previous layout */
+typedef struct
+{
+    uint32_t start;
+    uint32_t end;
+} Layout_Gap;
+
+static void Layout_Usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s manifest <build.map> <image.cyacd> <release.manifest> [<previous.manifest>]\n"
+                    "       %s pin <previous.manifest> <build.map> <pinned.ld>\n", name, name);
+}
+
+static void Layout_Free(Layout_Map *map)
+{
+    free(map->sections);
+    free(map->rows);
+    memset(map, 0, sizeof(*map));
+}
+
+static int Layout_AddSection(Layout_Map *map, const char *name, const char *object, uint32_t address,
+                             uint32_t size)
+{
+    Layout_Section *sections;
+    Layout_Section *section;
+
+    if((map->sectionCount & 0xFFu) == 0u)
+    {
+        sections = realloc(map->sections, (map->sectionCount + 0x100u) * sizeof(Layout_Section));
+        if(sections == NULL)
+        {
+            return (-1);
+        }
+        map->sections = sections;
+    }
+
+    section = &map->sections[map->sectionCount];
+    memset(section, 0, sizeof(*section));
+    strncpy(section->name, name, LAYOUT_MAX_NAME - 1u);
+    strncpy(section->object, object, LAYOUT_MAX_NAME - 1u);
+    section->address = address;
+    section->size = size;
+    map->sectionCount++;
+    if((address + size) > map->end)
+    {
+        map->end = address + size;
+    }
+
+    return (0);
+}
+
+/* File name of an object of the map: "dir/lib.a(member.o)" becomes
+* "lib.a:member.o", the form of the linker script patterns
+*/
+static int Layout_ObjectName(const char *path, char *object)
+{
+    const char *name = path;
+    const char *p;
+    size_t length;
+
+    for(p = path; *p != '\0'; p++)
+    {
+        if((*p == '/') || (*p == '\\'))
+        {
+            name = p + 1;
+        }
+    }
+
+    length = strlen(name);
+    if((length == 0u) || (length >= LAYOUT_MAX_NAME) || (strpbrk(name, " \t") != NULL))
+    {
+        return (-1);
+    }
+
+    strcpy(object, name);
+    p = strchr(object, '(');
+    if(p != NULL)
+    {
+        if(object[length - 1u] != ')')
+        {
+            return (-1);
+        }
+        object[p - object] = ':';
+        object[length - 1u] = '\0';
+    }
+
+    return (0);
+}
+
+
+/*******************************************************************************
+* Function Name: Layout_ReadMap
+********************************************************************************
+*
+* Summary:
+*  Reads the input sections of the .text output section from the memory map
+*  part of a GCC linker map file. An input section name longer than its
+*  column is alone on its line, and its address, size and object are on the
+*  next one. Empty sections and sections without a usable object name are
+*  left out.
+*
+* Return:
+*  0 on success, -1 if the file cannot be read or has no .text section.
+*
+*******************************************************************************/
+static int Layout_ReadMap(const char *path, Layout_Map *map)
+{
+    char line[LAYOUT_MAX_LINE];
+    char name[LAYOUT_MAX_NAME] = "";
+    char object[LAYOUT_MAX_NAME];
+    char first[LAYOUT_MAX_LINE];
+    char *rest;
+    unsigned long address;
+    unsigned long size;
+    int inMap = 0;
+    int inSection = 0;
+    int found = 0;
+    int fields;
+    int result = 0;
+    FILE *file = fopen(path, "r");
+
+    memset(map, 0, sizeof(*map));
+    if(file == NULL)
+    {
+        return (-1);
+    }
+
+    while((result == 0) && (fgets(line, sizeof(line), file) != NULL))
+    {
+        line[strcspn(line, "\r\n")] = '\0';
+
+        if(inMap == 0)
+        {
+            inMap = (strncmp(line, "Linker script and memory map", 28u) == 0);
+            continue;
+        }
+
+        /* An output section, or a statement of the script, starts in the first column */
+        if((line[0] != ' ') && (line[0] != '\0'))
+        {
+            inSection = 0;
+            if((sscanf(line, "%1023s %lx", first, &address) == 2) && (strcmp(first, LAYOUT_OUTPUT_SECTION) == 0))
+            {
+                inSection = 1;
+                found = 1;
+                map->base = (uint32_t) address;
+                map->end = (uint32_t) address;
+            }
+            name[0] = '\0';
+            continue;
+        }
+        if(inSection == 0)
+        {
+            continue;
+        }
+
+        /* " .text.name 0xaddress 0xsize object", " .text.name" then " 0xaddress 0xsize object",
+        * or a symbol, a fill or a pattern line
+        */
+        fields = sscanf(line, "%1023s", first);
+        if((fields == 1) && (first[0] == '.'))
+        {
+            if(strlen(first) >= LAYOUT_MAX_NAME)
+            {
+                name[0] = '\0';
+                continue;
+            }
+            strcpy(name, first);
+            rest = strstr(line, first) + strlen(first);
+        }
+        else if((fields == 1) && (name[0] != '\0') && (strncmp(first, "0x", 2u) == 0))
+        {
+            rest = line;
+        }
+        else
+        {
+            name[0] = '\0';
+            continue;
+        }
+
+        fields = sscanf(rest, "%lx %lx %1023[^\n]", &address, &size, first);
+        if(fields == 3)
+        {
+            if((size != 0u) && (Layout_ObjectName(first, object) == 0))
+            {
+                result = Layout_AddSection(map, name, object, (uint32_t) address, (uint32_t) size);
+            }
+            name[0] = '\0';
+        }
+        else if(fields != EOF)
+        {
+            /* A symbol line */
+            name[0] = '\0';
+        }
+        else
+        {
+            /* The name is alone on its line */
+        }
+    }
+
+    fclose(file);
+    if((result != 0) || (found == 0))
+    {
+        Layout_Free(map);
+        result = -1;
+    }
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: Layout_ReadManifest
+********************************************************************************
+*
+* Summary:
+*  Reads a manifest written by Layout_WriteManifest().
+*
+* Return:
+*  0 on success, -1 if the file cannot be read or a line is not understood.
+*
+*******************************************************************************/
+static int Layout_ReadManifest(const char *path, Layout_Map *map)
+{
+    char line[LAYOUT_MAX_LINE];
+    char name[LAYOUT_MAX_NAME];
+    char object[LAYOUT_MAX_NAME];
+    unsigned long address;
+    unsigned long size;
+    unsigned arrayId;
+    unsigned row;
+    Layout_Row *rows;
+    int result = 0;
+    FILE *file = fopen(path, "r");
+
+    memset(map, 0, sizeof(*map));
+    if(file == NULL)
+    {
+        return (-1);
+    }
+
+    while((result == 0) && (fgets(line, sizeof(line), file) != NULL))
+    {
+        if((line[0] == '#') || (line[strspn(line, " \t\r\n")] == '\0'))
+        {
+            continue;
+        }
+        if(sscanf(line, "base %lx", &address) == 1)
+        {
+            map->base = (uint32_t) address;
+            map->end = (uint32_t) address;
+        }
+        else if(sscanf(line, "section %255s %255s %lx %lx", name, object, &address, &size) == 4)
+        {
+            result = Layout_AddSection(map, name, object, (uint32_t) address, (uint32_t) size);
+        }
+        else if(sscanf(line, "row %u %u %lx", &arrayId, &row, &address) == 3)
+        {
+            if((map->rowCount & 0xFFu) == 0u)
+            {
+                rows = realloc(map->rows, (map->rowCount + 0x100u) * sizeof(Layout_Row));
+                if(rows == NULL)
+                {
+                    result = -1;
+                    break;
+                }
+                map->rows = rows;
+            }
+            map->rows[map->rowCount].arrayId = (uint8_t) arrayId;
+            map->rows[map->rowCount].row = (uint16_t) row;
+            map->rows[map->rowCount].hash = (uint32_t) address;
+            map->rowCount++;
+        }
+        else
+        {
+            result = -1;
+        }
+    }
+
+    fclose(file);
+    if(result != 0)
+    {
+        Layout_Free(map);
+    }
+
+    return (result);
+}
+
+static int Layout_WriteManifest(const char *path, const Layout_Map *map, const Cyacd_Image *image)
+{
+    size_t i;
+    FILE *file = fopen(path, "w");
+
+    if(file == NULL)
+    {
+        return (-1);
+    }
+
+    fprintf(file, "# btldr_layout manifest: sections of %s, then the CRC-32C of every row\n",
+            LAYOUT_OUTPUT_SECTION);
+    fprintf(file, "base 0x%08lX\n", (unsigned long) map->base);
+    for(i = 0u; i < map->sectionCount; i++)
+    {
+        fprintf(file, "section %s %s 0x%08lX 0x%lX\n", map->sections[i].name, map->sections[i].object,
+                (unsigned long) map->sections[i].address, (unsigned long) map->sections[i].size);
+    }
+    for(i = 0u; i < image->rowCount; i++)
+    {
+        fprintf(file, "row %u %u 0x%08lX\n", (unsigned) image->rows[i].arrayId, (unsigned) image->rows[i].row,
+                (unsigned long) BtldrCrc_Update(BTLDR_CRC_INIT, image->rows[i].data, image->rows[i].size));
+    }
+
+    return ((fclose(file) == 0) ? 0 : -1);
+}
+
+static Layout_Section *Layout_Find(const Layout_Map *map, const Layout_Section *section)
+{
+    size_t i;
+
+    for(i = 0u; i < map->sectionCount; i++)
+    {
+        if((strcmp(map->sections[i].name, section->name) == 0) &&
+           (strcmp(map->sections[i].object, section->object) == 0))
+        {
+            return (&map->sections[i]);
+        }
+    }
+
+    return (NULL);
+}
+
+/* Nonzero if the pattern of the section, "*object(name)", would match
+* another section of the map as well
+*/
+static int Layout_Ambiguous(const Layout_Map *map, const Layout_Section *section)
+{
+    size_t length = strlen(section->object);
+    size_t objectLength;
+    size_t i;
+
+    for(i = 0u; i < map->sectionCount; i++)
+    {
+        objectLength = strlen(map->sections[i].object);
+        if((&map->sections[i] != section) && (strcmp(map->sections[i].name, section->name) == 0) &&
+           (objectLength >= length) && (strcmp(&map->sections[i].object[objectLength - length], section->object) == 0))
+        {
+            return (1);
+        }
+    }
+
+    return (0);
+}
+
+static int Layout_BySize(const void *a, const void *b)
+{
+    const Layout_Section *left = *(const Layout_Section * const *) a;
+    const Layout_Section *right = *(const Layout_Section * const *) b;
+
+    return ((left->size < right->size) ? 1 : ((left->size > right->size) ? -1 : 0));
+}
+
+static int Layout_ByAddress(const void *a, const void *b)
+{
+    const Layout_Section *left = *(const Layout_Section * const *) a;
+    const Layout_Section *right = *(const Layout_Section * const *) b;
+
+    return ((left->address > right->address) ? 1 : ((left->address < right->address) ? -1 : 0));
+}
+
+/* Alignment of a section: no more than its address in the map has */
+static uint32_t Layout_Alignment(const Layout_Section *section)
+{
+    uint32_t align = LAYOUT_ALIGN;
+
+    while((align > 1u) && ((section->address & (align - 1u)) != 0u))
+    {
+        align >>= 1;
+    }
+
+    return (align);
+}
+
+/* Nonzero if all the rows of the range [start, end) are marked */
+static int Layout_Touched(const uint8_t *touched, size_t rowCount, uint32_t start, uint32_t end)
+{
+    uint32_t row;
+
+    for(row = start / LAYOUT_ROW_SIZE; (start < end) && (row <= ((end - 1u) / LAYOUT_ROW_SIZE)); row++)
+    {
+        if((row >= rowCount) || (touched[row] == 0u))
+        {
+            return (0);
+        }
+    }
+
+    return (1);
+}
+
+/* Marks the rows of the range [start, end) */
+static void Layout_Touch(uint8_t *touched, size_t rowCount, uint32_t start, uint32_t end)
+{
+    uint32_t row;
+
+    for(row = start / LAYOUT_ROW_SIZE; (start < end) && (row <= ((end - 1u) / LAYOUT_ROW_SIZE)); row++)
+    {
+        if(row < rowCount)
+        {
+            touched[row] = 1u;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: Layout_Pin
+********************************************************************************
+*
+* Summary:
+*  Places the sections of the new build against the previous release: sets
+*  the placement and, unless appended, the address of every section, and
+*  counts the rows the layout changes.
+*
+*  A gap is a range of the previous layout that no pinned section covers. A
+*  section that shrank keeps its address; the rest of its range becomes a
+*  gap as well. A row is touched when a section is placed in it at another
+*  address than before, or when a section that it held moved or went away.
+*
+* Parameters:
+*  previous:     Manifest of the previous release.
+*  next:         Map of the new build.
+*  order:        Receives the sections in the order of their address, the
+*                appended ones last; next->sectionCount entries.
+*  rowsTouched:  Receives the number of rows whose content moves.
+*
+* Return:
+*  0 on success, -1 if out of memory.
+*
+*******************************************************************************/
+static int Layout_Pin(const Layout_Map *previous, Layout_Map *next, Layout_Section **order, size_t *rowsTouched)
+{
+    size_t count = next->sectionCount;
+    size_t rowCount = (previous->end + next->end + (count * LAYOUT_ALIGN)) / LAYOUT_ROW_SIZE;
+    Layout_Gap *gaps = malloc((count + 1u) * sizeof(Layout_Gap));
+    uint8_t *touched = calloc(rowCount, 1u);
+    const Layout_Section *old;
+    Layout_Section *section;
+    uint32_t cursor = previous->base;
+    uint32_t appendAt;
+    uint32_t start;
+    uint32_t align;
+    size_t gapCount = 0u;
+    size_t placed = 0u;
+    size_t i;
+    size_t j;
+
+    if((gaps == NULL) || (touched == NULL))
+    {
+        free(gaps);
+        free(touched);
+        return (-1);
+    }
+
+    /* Sections that still fit keep their address */
+    for(i = 0u; i < count; i++)
+    {
+        section = &next->sections[i];
+        old = Layout_Find(previous, section);
+        section->placement = LAYOUT_APPENDED;
+        if((old != NULL) && (section->size <= old->size) && (Layout_Ambiguous(next, section) == 0))
+        {
+            section->placement = LAYOUT_PINNED;
+            section->address = old->address;
+            order[placed++] = section;
+        }
+    }
+    qsort(order, placed, sizeof(order[0]), &Layout_ByAddress);
+
+    /* The gaps between them, up to the end of the previous layout */
+    for(i = 0u; i <= placed; i++)
+    {
+        start = (i < placed) ? order[i]->address : previous->end;
+        if(start > cursor)
+        {
+            gaps[gapCount].start = cursor;
+            gaps[gapCount].end = start;
+            gapCount++;
+        }
+        if(i < placed)
+        {
+            cursor = order[i]->address + order[i]->size;
+        }
+    }
+
+    /* The ranges left by removed and moved sections and by the end of shrunk
+    * ones are filled with other sections or padded
+    */
+    for(i = 0u; i < previous->sectionCount; i++)
+    {
+        old = &previous->sections[i];
+        section = Layout_Find(next, old);
+        if((section == NULL) || (section->placement != LAYOUT_PINNED))
+        {
+            Layout_Touch(touched, rowCount, old->address, old->address + old->size);
+        }
+        else
+        {
+            Layout_Touch(touched, rowCount, old->address + section->size, old->address + old->size);
+        }
+    }
+
+    /* The largest sections first, each into the first gap it fits, in the
+    * rows that change anyway when there is room
+    */
+    j = placed;
+    for(i = 0u; i < count; i++)
+    {
+        if(next->sections[i].placement == LAYOUT_APPENDED)
+        {
+            order[j++] = &next->sections[i];
+        }
+    }
+    qsort(&order[placed], count - placed, sizeof(order[0]), &Layout_BySize);
+    for(i = placed; i < count; i++)
+    {
+        section = order[i];
+        align = Layout_Alignment(section);
+        for(j = 0u; (section->placement == LAYOUT_APPENDED) && (j < (2u * gapCount)); j++)
+        {
+            start = (gaps[j % gapCount].start + (align - 1u)) & ~(align - 1u);
+            if((start < gaps[j % gapCount].end) && (section->size <= (gaps[j % gapCount].end - start)) &&
+               ((j >= gapCount) || (Layout_Touched(touched, rowCount, start, start + section->size) != 0)))
+            {
+                section->placement = LAYOUT_GAP;
+                section->address = start;
+                gaps[j % gapCount].start = start + section->size;
+            }
+        }
+    }
+
+    /* The appended sections follow the previous layout */
+    appendAt = previous->end;
+    for(i = 0u; i < count; i++)
+    {
+        section = &next->sections[i];
+        if(section->placement == LAYOUT_APPENDED)
+        {
+            align = Layout_Alignment(section);
+            section->address = (appendAt + (align - 1u)) & ~(align - 1u);
+            appendAt = section->address + section->size;
+        }
+        if(section->placement != LAYOUT_PINNED)
+        {
+            Layout_Touch(touched, rowCount, section->address, section->address + section->size);
+        }
+    }
+
+    /* The pinned and the gap sections in the order of their address */
+    for(i = 0u, j = 0u; i < count; i++)
+    {
+        if(next->sections[i].placement != LAYOUT_APPENDED)
+        {
+            order[j++] = &next->sections[i];
+        }
+    }
+    qsort(order, j, sizeof(order[0]), &Layout_ByAddress);
+    for(i = 0u; i < count; i++)
+    {
+        if(next->sections[i].placement == LAYOUT_APPENDED)
+        {
+            order[j++] = &next->sections[i];
+        }
+    }
+
+    *rowsTouched = 0u;
+    for(i = 0u; i < rowCount; i++)
+    {
+        *rowsTouched += touched[i];
+    }
+
+    free(gaps);
+    free(touched);
+
+    return (0);
+}
+
+static int Layout_WriteScript(const char *path, const Layout_Map *previous, Layout_Section * const *order,
+                              size_t count)
+{
+    size_t i;
+    FILE *file = fopen(path, "w");
+
+    if(file == NULL)
+    {
+        return (-1);
+    }
+
+    fprintf(file, "/* Generated by btldr_layout. Include at the start of the %s output section,\n"
+                  "* before the generic input section patterns. Offsets from 0x%08lX.\n*/\n",
+            LAYOUT_OUTPUT_SECTION, (unsigned long) previous->base);
+    for(i = 0u; (i < count) && (order[i]->placement != LAYOUT_APPENDED); i++)
+    {
+        fprintf(file, ". = 0x%05lX;\nKEEP(*%s(%s))\n", (unsigned long)(order[i]->address - previous->base),
+                order[i]->object, order[i]->name);
+    }
+
+    return ((fclose(file) == 0) ? 0 : -1);
+}
+
+static int Layout_Manifest(char *args[], int argCount)
+{
+    Layout_Map map;
+    Layout_Map previous;
+    Cyacd_Image image;
+    size_t changed = 0u;
+    size_t i;
+    size_t j;
+    uint32_t hash;
+    int result;
+
+    if(Layout_ReadMap(args[0], &map) != 0)
+    {
+        fprintf(stderr, "%s: cannot read the %s section of the map\n", args[0], LAYOUT_OUTPUT_SECTION);
+        return (1);
+    }
+    result = Cyacd_Load(args[1], &image);
+    if(result != CYACD_SUCCESS)
+    {
+        fprintf(stderr, "%s: cannot read image (%d)\n", args[1], result);
+        Layout_Free(&map);
+        return (1);
+    }
+
+    result = 0;
+    if(Layout_WriteManifest(args[2], &map, &image) != 0)
+    {
+        perror(args[2]);
+        result = 1;
+    }
+    else if(argCount > 3)
+    {
+        if(Layout_ReadManifest(args[3], &previous) != 0)
+        {
+            fprintf(stderr, "%s: not a manifest\n", args[3]);
+            result = 1;
+        }
+        else
+        {
+            for(i = 0u; i < image.rowCount; i++)
+            {
+                hash = BtldrCrc_Update(BTLDR_CRC_INIT, image.rows[i].data, image.rows[i].size);
+                for(j = 0u; j < previous.rowCount; j++)
+                {
+                    if((previous.rows[j].arrayId == image.rows[i].arrayId) &&
+                       (previous.rows[j].row == image.rows[i].row))
+                    {
+                        break;
+                    }
+                }
+                if((j == previous.rowCount) || (previous.rows[j].hash != hash))
+                {
+                    changed++;
+                }
+            }
+            printf("%zu of %zu rows changed since the previous release\n", changed, image.rowCount);
+            Layout_Free(&previous);
+        }
+    }
+    else
+    {
+        printf("%zu sections, %zu rows recorded\n", map.sectionCount, image.rowCount);
+    }
+
+    Cyacd_Free(&image);
+    Layout_Free(&map);
+
+    return (result);
+}
+
+static int Layout_PinCommand(char *args[])
+{
+    Layout_Map previous;
+    Layout_Map next;
+    Layout_Section **order;
+    size_t counts[3] = {0u, 0u, 0u};
+    size_t rowsTouched;
+    size_t i;
+    int result = 0;
+
+    if(Layout_ReadManifest(args[0], &previous) != 0)
+    {
+        fprintf(stderr, "%s: not a manifest\n", args[0]);
+        return (1);
+    }
+    if(Layout_ReadMap(args[1], &next) != 0)
+    {
+        fprintf(stderr, "%s: cannot read the %s section of the map\n", args[1], LAYOUT_OUTPUT_SECTION);
+        Layout_Free(&previous);
+        return (1);
+    }
+    if(next.base != previous.base)
+    {
+        fprintf(stderr, "%s starts at 0x%08lX, the previous release at 0x%08lX\n", LAYOUT_OUTPUT_SECTION,
+                (unsigned long) next.base, (unsigned long) previous.base);
+        result = 1;
+    }
+
+    order = malloc((next.sectionCount + 1u) * sizeof(order[0]));
+    if((result == 0) && ((order == NULL) || (Layout_Pin(&previous, &next, order, &rowsTouched) != 0)))
+    {
+        fprintf(stderr, "out of memory\n");
+        result = 1;
+    }
+    if((result == 0) && (Layout_WriteScript(args[2], &previous, order, next.sectionCount) != 0))
+    {
+        perror(args[2]);
+        result = 1;
+    }
+
+    if(result == 0)
+    {
+        for(i = 0u; i < next.sectionCount; i++)
+        {
+            counts[next.sections[i].placement]++;
+        }
+        printf("%zu sections: %zu pinned, %zu moved into gaps, %zu appended\n", next.sectionCount,
+               counts[LAYOUT_PINNED], counts[LAYOUT_GAP], counts[LAYOUT_APPENDED]);
+        printf("%zu rows touched by the layout, plus the rows of code changed in place\n", rowsTouched);
+    }
+
+    free(order);
+    Layout_Free(&next);
+    Layout_Free(&previous);
+
+    return (result);
+}
+
+int main(int argc, char *argv[])
+{
+    if((argc >= 5) && (argc <= 6) && (strcmp(argv[1], "manifest") == 0))
+    {
+        return (Layout_Manifest(&argv[2], argc - 2));
+    }
+    if((argc == 5) && (strcmp(argv[1], "pin") == 0))
+    {
+        return (Layout_PinCommand(&argv[2]));
+    }
+
+    Layout_Usage(argv[0]);
+
+    return (2);
+}
+
+
+/* [] END OF FILE */
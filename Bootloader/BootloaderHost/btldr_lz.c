@@ -0,0 +1,186 @@
+/*******************************************************************************
+* File: btldr_lz.c
+*
+* Version: 1.0
+*
+* Description:
+*  LZ coding of the row stream of a compressed burst. The stream is a
+*  sequence of groups: a flag byte followed by up to eight items, flag bits
+*  LSB first. A set bit is a literal byte, a clear bit a match of two bytes:
+*  the distance minus one and the length minus BTLDR_LZ_MIN_MATCH. A match
+*  copies from the last BTLDR_LZ_WINDOW decoded bytes of the same burst, so
+*  the bootloader needs no more than a 256-byte window to decode it while the
+*  packets arrive.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <string.h>
+#include "btldr_lz.h"
+
+
+/*******************************************************************************
+* Function Name: BtldrLz_Compress
+********************************************************************************
+*
+* Summary:
+*  Greedy compressor: at every position the longest match in the window is
+*  taken when it is at least BTLDR_LZ_MIN_MATCH bytes long.
+*
+* Parameters:
+*  out: At least BTLDR_LZ_BOUND(size) bytes.
+*
+* Return:
+*  Size of the encoded stream.
+*
+*******************************************************************************/
+size_t BtldrLz_Compress(const uint8_t *in, size_t size, uint8_t *out)
+{
+    size_t pos = 0u;
+    size_t used = 0u;
+    size_t flagsAt = 0u;
+    size_t maxLength;
+    size_t bestLength;
+    size_t bestDistance;
+    size_t distance;
+    size_t length;
+    unsigned int items = 8u;
+
+    while(pos < size)
+    {
+        if(items == 8u)
+        {
+            flagsAt = used++;
+            out[flagsAt] = 0u;
+            items = 0u;
+        }
+
+        maxLength = ((size - pos) < BTLDR_LZ_MAX_MATCH) ? (size - pos) : BTLDR_LZ_MAX_MATCH;
+        bestLength = 0u;
+        bestDistance = 0u;
+        for(distance = 1u; (distance <= BTLDR_LZ_WINDOW) && (distance <= pos); distance++)
+        {
+            /* The source may overlap the bytes being matched */
+            for(length = 0u; (length < maxLength) && (in[pos + length] == in[pos + length - distance]); length++)
+            {
+            }
+            if(length > bestLength)
+            {
+                bestLength = length;
+                bestDistance = distance;
+                if(length == maxLength)
+                {
+                    break;
+                }
+            }
+        }
+
+        if(bestLength >= BTLDR_LZ_MIN_MATCH)
+        {
+            out[used++] = (uint8_t)(bestDistance - 1u);
+            out[used++] = (uint8_t)(bestLength - BTLDR_LZ_MIN_MATCH);
+            pos += bestLength;
+        }
+        else
+        {
+            out[flagsAt] |= (uint8_t)(1u << items);
+            out[used++] = in[pos++];
+        }
+        items++;
+    }
+
+    return (used);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrLz_DecoderInit
+********************************************************************************
+*
+* Summary:
+*  Prepares a decoder for a new burst.
+*
+*******************************************************************************/
+void BtldrLz_DecoderInit(BtldrLz_Decoder *decoder)
+{
+    memset(decoder, 0, sizeof(*decoder));
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrLz_Decode
+********************************************************************************
+*
+* Summary:
+*  Decodes the next part of an encoded stream. The parts may be split at any
+*  byte, as the ROWS_DATA packets are.
+*
+* Parameters:
+*  out: Receives the decoded bytes, may be NULL to count them only.
+*
+* Return:
+*  Number of bytes decoded.
+*
+*******************************************************************************/
+size_t BtldrLz_Decode(BtldrLz_Decoder *decoder, const uint8_t *in, size_t size, uint8_t *out)
+{
+    size_t produced = 0u;
+    size_t count;
+    size_t i;
+    uint8_t from;
+
+    for(i = 0u; i < size; i++)
+    {
+        if(decoder->flagsLeft == 0u)
+        {
+            decoder->flags = in[i];
+            decoder->flagsLeft = 8u;
+        }
+        else if(decoder->matchPending != 0u)
+        {
+            from = (uint8_t)(decoder->position - decoder->distance - 1u);
+            for(count = (size_t) in[i] + BTLDR_LZ_MIN_MATCH; count != 0u; count--)
+            {
+                decoder->window[decoder->position] = decoder->window[from];
+                if(out != NULL)
+                {
+                    out[produced] = decoder->window[from];
+                }
+                produced++;
+                decoder->position++;
+                from++;
+            }
+            decoder->matchPending = 0u;
+            decoder->flags >>= 1u;
+            decoder->flagsLeft--;
+        }
+        else if((decoder->flags & 0x01u) != 0u)
+        {
+            decoder->window[decoder->position++] = in[i];
+            if(out != NULL)
+            {
+                out[produced] = in[i];
+            }
+            produced++;
+            decoder->flags >>= 1u;
+            decoder->flagsLeft--;
+        }
+        else
+        {
+            decoder->distance = in[i];
+            decoder->matchPending = 1u;
+        }
+    }
+
+    return (produced);
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,52 @@
+/*******************************************************************************
+* File: btldr_lz.h
+*
+* Version: 1.0
+*
+* Description:
+*  LZ coding of the row stream of a compressed burst (BTLDR_EXT_ENCODING_LZ
+*  of the CE95281 bootloader).
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#if !defined(BTLDR_LZ_H)
+#define BTLDR_LZ_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* These values must match btldr_ext.h of the CE95281 project */
+#define BTLDR_LZ_WINDOW                 (256u)
+#define BTLDR_LZ_MIN_MATCH              (3u)
+#define BTLDR_LZ_MAX_MATCH              (BTLDR_LZ_MIN_MATCH + 255u)
+
+/* Largest encoded size of size bytes: all literals plus the flag bytes */
+#define BTLDR_LZ_BOUND(size)            ((size) + (((size) + 7u) / 8u))
+
+/* Streaming decoder, the same state machine as BtldrExt_LzDecode() */
+typedef struct
+{
+    uint8_t flags;
+    uint8_t flagsLeft;
+    uint8_t matchPending;
+    uint8_t distance;
+    uint8_t position;
+    uint8_t window[BTLDR_LZ_WINDOW];
+} BtldrLz_Decoder;
+
+size_t BtldrLz_Compress(const uint8_t *in, size_t size, uint8_t *out);
+void   BtldrLz_DecoderInit(BtldrLz_Decoder *decoder);
+size_t BtldrLz_Decode(BtldrLz_Decoder *decoder, const uint8_t *in, size_t size, uint8_t *out);
+
+#endif /* BTLDR_LZ_H */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,293 @@
+/*******************************************************************************
+* File: btldr_tune.c
+*
+* Version: 1.0
+*
+* Description:
+*  Chooses the packet size and the rows per burst of an update.
+*
+*  The model charges every transaction the adapter overhead plus a time per
+*  byte, the slave address included, and every row the erase and program
+*  time. A bootloader that programs in the foreground stretches the bus for
+*  the whole write; one that programs burst rows in the background overlaps
+*  the write with the reception of the next row and only waits for the last
+*  row of the burst. A burst, or a command of the one-row-per-command flow,
+*  in which a byte is corrupted is sent again whole: larger packets and
+*  deeper bursts save transactions but lose more to each error.
+*
+*  BtldrTune_Probe() measures the adapter overhead and the time per byte on
+*  the link itself, with unanswered SYNC packets of two sizes; the row time
+*  and the error rate are taken from the model given.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <string.h>
+#include <time.h>
+#include "btldr_tune.h"
+
+/* 100 kHz bus with nine bit times per byte, a USB adapter, the maximum
+* erase and program times of the PSoC 4200 and one corrupted byte in ten
+* million
+*/
+const BtldrTune_Model BtldrTune_defaultModel = {1000e-6, 90e-6, 20e-3, 0, 1e-7};
+
+static double BtldrTune_HostClock(void *context)
+{
+    struct timespec now;
+
+    (void) context;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((double) now.tv_sec + ((double) now.tv_nsec * 1e-9));
+}
+
+/* One transaction of size bytes */
+static double BtldrTune_Transaction(const BtldrTune_Model *model, size_t size)
+{
+    return (model->overhead + ((double)(size + 1u) * model->byteTime));
+}
+
+/* Expected time of an exchange of size bytes on the bus that is repeated
+* until none of its bytes is corrupted
+*/
+static double BtldrTune_Retried(const BtldrTune_Model *model, double time, size_t size)
+{
+    double intact = 1.0;
+    double factor = 1.0 - model->errorRate;
+
+    /* (1 - errorRate) ^ size */
+    while(size != 0u)
+    {
+        if((size & 1u) != 0u)
+        {
+            intact *= factor;
+        }
+        factor *= factor;
+        size >>= 1;
+    }
+
+    return ((intact > 0.0) ? (time / intact) : 1e30);
+}
+
+/* A command of length data bytes and its empty response */
+static double BtldrTune_Command(const BtldrTune_Model *model, size_t length, double deviceTime)
+{
+    size_t size = length + BTLDR_HOST_SIZEOF_OVERHEAD;
+
+    return (BtldrTune_Retried(model, BtldrTune_Transaction(model, size) + deviceTime +
+                              BtldrTune_Transaction(model, BTLDR_HOST_SIZEOF_OVERHEAD),
+                              size + BTLDR_HOST_SIZEOF_OVERHEAD + 2u));
+}
+
+/* One row with SEND_DATA and PROGRAM_ROW, split as BtldrHost_ProgramRow() does */
+static double BtldrTune_Row(const BtldrTune_Model *model, uint16_t rowSize, size_t packetSize)
+{
+    size_t maxData = packetSize - BTLDR_HOST_SIZEOF_OVERHEAD;
+    size_t left = rowSize;
+    size_t chunk;
+    double time = 0.0;
+
+    while(left > (maxData - 3u))
+    {
+        chunk = left - (maxData - 3u);
+        chunk = (chunk < maxData) ? chunk : maxData;
+        time += BtldrTune_Command(model, chunk, 0.0);
+        left -= chunk;
+    }
+
+    return (time + BtldrTune_Command(model, 3u + left, model->rowTime));
+}
+
+/* One raw burst of rowCount rows, as BtldrHost_ProgramRows() sends it */
+static double BtldrTune_Burst(const BtldrTune_Model *model, uint16_t rowSize, size_t rowCount, size_t packetSize)
+{
+    size_t stream = rowCount * rowSize;
+    size_t maxChunk = packetSize - BTLDR_HOST_SIZEOF_OVERHEAD - 1u;
+    size_t packets = (stream + maxChunk - 1u) / maxChunk;
+    size_t bytes = stream + (packets * (BTLDR_HOST_SIZEOF_OVERHEAD + 1u));
+    double command = BtldrTune_Transaction(model, BTLDR_HOST_SIZEOF_OVERHEAD + 5u);
+    double status = BtldrTune_Transaction(model, BTLDR_HOST_SIZEOF_OVERHEAD) +
+                    BtldrTune_Transaction(model, BTLDR_HOST_SIZEOF_OVERHEAD + 3u);
+    double data = ((double) packets * model->overhead) + ((double)(bytes + packets) * model->byteTime);
+    double row = data / (double) rowCount;
+    double time;
+
+    if(model->background != 0)
+    {
+        /* Each row is received while the one before is programmed */
+        time = command + row + ((double)(rowCount - 1u) * ((row > model->rowTime) ? row : model->rowTime)) +
+               model->rowTime + status;
+    }
+    else
+    {
+        time = command + data + ((double) rowCount * model->rowTime) + status;
+    }
+
+    return (BtldrTune_Retried(model, time, bytes + packets + (3u * BTLDR_HOST_SIZEOF_OVERHEAD) + 11u));
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrTune_Probe
+********************************************************************************
+*
+* Summary:
+*  Measures the adapter overhead and the time per byte of the link: enters
+*  the bootloader, then times BTLDR_TUNE_PROBES unanswered SYNC packets
+*  without data and as many of the packet size of the link. SYNC only resets
+*  the state of a burst. The other fields of the model are left as they are.
+*
+* Parameters:
+*  clock:        Time in s, NULL for the host clock.
+*  clockContext: Passed to clock.
+*  model:        Receives the overhead and the time per byte.
+*
+* Return:
+*  BTLDR_HOST_SUCCESS, the status of ENTER or a negative host error.
+*  BTLDR_HOST_ERR_FORMAT if the timings do not fit the model.
+*
+*******************************************************************************/
+int BtldrTune_Probe(const BtldrHost_Link *link, double (*clock)(void *context), void *clockContext,
+                    BtldrTune_Model *model)
+{
+    uint8_t data[BTLDR_HOST_MAX_PACKET];
+    size_t longData = link->packetSize - BTLDR_HOST_SIZEOF_OVERHEAD;
+    double start;
+    double shortTime;
+    double longTime;
+    double byteTime;
+    uint32_t i;
+    int result;
+
+    if((link->packetSize <= BTLDR_HOST_SIZEOF_OVERHEAD) || (link->packetSize > BTLDR_HOST_MAX_PACKET))
+    {
+        return (BTLDR_HOST_ERR_ARGUMENT);
+    }
+    if(clock == NULL)
+    {
+        clock = &BtldrTune_HostClock;
+    }
+    memset(data, 0, sizeof(data));
+
+    result = BtldrHost_Enter(link, NULL, NULL);
+
+    start = clock(clockContext);
+    for(i = 0u; (result == BTLDR_HOST_SUCCESS) && (i < BTLDR_TUNE_PROBES); i++)
+    {
+        result = BtldrHost_Post(link, BTLDR_HOST_CMD_SYNC, NULL, 0u);
+    }
+    shortTime = (clock(clockContext) - start) / BTLDR_TUNE_PROBES;
+
+    start = clock(clockContext);
+    for(i = 0u; (result == BTLDR_HOST_SUCCESS) && (i < BTLDR_TUNE_PROBES); i++)
+    {
+        result = BtldrHost_Post(link, BTLDR_HOST_CMD_SYNC, data, (uint16_t) longData);
+    }
+    longTime = (clock(clockContext) - start) / BTLDR_TUNE_PROBES;
+
+    if(result == BTLDR_HOST_SUCCESS)
+    {
+        byteTime = (longTime - shortTime) / (double) longData;
+        if((byteTime <= 0.0) || (shortTime < ((BTLDR_HOST_SIZEOF_OVERHEAD + 1u) * byteTime)))
+        {
+            result = BTLDR_HOST_ERR_FORMAT;
+        }
+        else
+        {
+            model->byteTime = byteTime;
+            model->overhead = shortTime - ((BTLDR_HOST_SIZEOF_OVERHEAD + 1u) * byteTime);
+        }
+    }
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrTune_Estimate
+********************************************************************************
+*
+* Summary:
+*  Models the time it takes to program rowCount consecutive rows, raw, in
+*  packets of up to packetSize bytes and bursts of up to rowsPerBurst rows.
+*  The commands that do not depend on the choice, as ENTER and the verify,
+*  are left out.
+*
+* Parameters:
+*  packetSize:   From BTLDR_TUNE_MIN_PACKET to BTLDR_HOST_MAX_PACKET.
+*  rowsPerBurst: 0 for one row per command.
+*
+* Return:
+*  The expected time, s.
+*
+*******************************************************************************/
+double BtldrTune_Estimate(const BtldrTune_Model *model, uint16_t rowSize, size_t rowCount, size_t packetSize,
+                          uint16_t rowsPerBurst)
+{
+    size_t bursts;
+    size_t left;
+
+    if(rowsPerBurst == 0u)
+    {
+        return ((double) rowCount * BtldrTune_Row(model, rowSize, packetSize));
+    }
+
+    bursts = rowCount / rowsPerBurst;
+    left = rowCount % rowsPerBurst;
+
+    return (((bursts != 0u) ? ((double) bursts * BtldrTune_Burst(model, rowSize, rowsPerBurst, packetSize)) : 0.0) +
+            ((left != 0u) ? BtldrTune_Burst(model, rowSize, left, packetSize) : 0.0));
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrTune_Choose
+********************************************************************************
+*
+* Summary:
+*  Finds the packet size and the rows per burst with the shortest modelled
+*  time. Of equal times, the larger packet and the shallower burst win.
+*
+* Parameters:
+*  maxPacket: Largest packet the bootloader accepts.
+*  choice:    Receives the packet size, the rows per burst and the time.
+*
+*******************************************************************************/
+void BtldrTune_Choose(const BtldrTune_Model *model, uint16_t rowSize, size_t rowCount, size_t maxPacket,
+                      BtldrTune_Choice *choice)
+{
+    size_t maxBurst = (rowCount < UINT16_MAX) ? rowCount : UINT16_MAX;
+    size_t packetSize;
+    size_t rows;
+    double estimate;
+
+    maxPacket = (maxPacket < BTLDR_HOST_MAX_PACKET) ? maxPacket : BTLDR_HOST_MAX_PACKET;
+    choice->packetSize = maxPacket;
+    choice->rowsPerBurst = 0u;
+    choice->estimate = BtldrTune_Estimate(model, rowSize, rowCount, maxPacket, 0u);
+
+    for(packetSize = maxPacket; packetSize >= BTLDR_TUNE_MIN_PACKET; packetSize--)
+    {
+        for(rows = 0u; rows <= maxBurst; rows++)
+        {
+            estimate = BtldrTune_Estimate(model, rowSize, rowCount, packetSize, (uint16_t) rows);
+            if(estimate < choice->estimate)
+            {
+                choice->packetSize = packetSize;
+                choice->rowsPerBurst = (uint16_t) rows;
+                choice->estimate = estimate;
+            }
+        }
+    }
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,60 @@
+/*******************************************************************************
+* File: btldr_tune.h
+*
+* Version: 1.0
+*
+* Description:
+*  Chooses the packet size and the rows per burst of an update from a cost
+*  model of the bus, the host adapter and the flash of the device, with the
+*  adapter costs probed on the link.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#if !defined(BTLDR_TUNE_H)
+#define BTLDR_TUNE_H
+
+#include "btldr_host.h"
+
+/* Smallest packet considered: room for the longest fixed-size command */
+#define BTLDR_TUNE_MIN_PACKET           (16u)
+
+/* Transactions timed per packet size by BtldrTune_Probe() */
+#define BTLDR_TUNE_PROBES               (4u)
+
+typedef struct
+{
+    double overhead;                    /* adapter cost per transaction, s */
+    double byteTime;                    /* bus and device time per byte, address included, s */
+    double rowTime;                     /* erase and program time of a row, s */
+    int    background;                  /* the bootloader programs burst rows while it receives */
+    double errorRate;                   /* probability that a byte is corrupted on the bus */
+} BtldrTune_Model;
+
+typedef struct
+{
+    size_t   packetSize;
+    uint16_t rowsPerBurst;              /* 0: one row per command */
+    double   estimate;                  /* modelled time to program the rows, s */
+} BtldrTune_Choice;
+
+extern const BtldrTune_Model BtldrTune_defaultModel;
+
+int    BtldrTune_Probe(const BtldrHost_Link *link, double (*clock)(void *context), void *clockContext,
+                       BtldrTune_Model *model);
+double BtldrTune_Estimate(const BtldrTune_Model *model, uint16_t rowSize, size_t rowCount, size_t packetSize,
+                          uint16_t rowsPerBurst);
+void   BtldrTune_Choose(const BtldrTune_Model *model, uint16_t rowSize, size_t rowCount, size_t maxPacket,
+                        BtldrTune_Choice *choice);
+
+#endif /* BTLDR_TUNE_H */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,407 @@
+/*******************************************************************************
+* File: btldr_update.c
+*
+* Version: 1.0
+*
+* Description:
+*  Command line tool that updates a device running the CE95281 bootloader
+*  from a .cyacd file over a Linux i2c-dev adapter, or the local stand-in of
+*  sim/btldr_sim.c. By default only the rows whose installed hash differs
+*  from the image are sent, which also resumes an interrupted update. With -f
+*  and -r the bootloader keeps a progress journal instead, and an update of
+*  the same file that was interrupted resumes from the rows it had not
+*  committed; images under BTLDR_IMAGE_JOURNAL_MIN_ROWS rows are sent in full
+*  instead. The file is memory-mapped and parsed while the rows
+*  are sent.
+*
+*  Given several addresses, or several adapters each with its addresses, the
+*  tool updates all the devices at once with btldr_fleet.c: the devices of
+*  an adapter take turns on its bus and the adapters run in parallel. The
+*  file is then loaded first, and -r is ignored.
+*
+*  With -a the packet size and the rows per burst are chosen with
+*  btldr_tune.c: the adapter overhead and the time per byte are probed on
+*  the link, of the first device when there are several, and the update
+*  time is modelled for each choice. The model assumes a bootloader that
+*  programs in the foreground, except on the simulated device, whose build
+*  is known.
+*
+*  After the update of a single device, the performance counters of the
+*  bootloader are read before the session ends and printed as a breakdown
+*  of the device time per command: calls, total and longest time in the
+*  command, time writing flash and time waiting for the host.
+*
+*  With -x and a bootloader built with BTLDR_EXT_MULTI_APP, a single device
+*  is told which of its two resident applications to launch once updated.
+*
+*  Build: gcc -O2 -pthread -I. -Isim -I"../CE95281 - Bootloader Project with
+*         PSoC 4/CE95281.cydsn" -o btldr_update btldr_update.c btldr_fleet.c
+*         btldr_image.c btldr_host.c btldr_crc.c btldr_tune.c btldr_lz.c cyacd.c
+*         i2c_linux.c sim/btldr_sim.c
+*         "../CE95281 - Bootloader Project with PSoC 4/CE95281.cydsn/btldr_ext.c"
+*  Usage: btldr_update [-f] [-z] [-r] [-p] [-a | -b rows] [-x app] <i2c device> <address>[,<address>...]
+*                      [<i2c device> <address>[,<address>...] ...] <image.cyacd>
+*         btldr_update -s [-f] [-z] [-r] [-p] [-a | -b rows] [-x app] <image.cyacd>
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "btldr_fleet.h"
+#include "btldr_sim.h"
+#include "btldr_tune.h"
+#include "i2c_linux.h"
+
+#define UPDATE_ROW_SIZE         (128u)
+#define UPDATE_ROWS_PER_BURST   (16u)
+#define UPDATE_MAX_TARGETS      (32u)
+#define UPDATE_MAX_COUNTERS     (32u)
+
+static void Update_Usage(const char *name)
+{
+    fprintf(stderr, "Usage: %s [-f] [-z] [-r] [-p] [-a | -b rows] [-x app] <i2c device> <address>[,<address>...]\n"
+                    "           [<i2c device> <address>[,<address>...] ...] <image.cyacd>\n"
+                    "       %s -s [-f] [-z] [-r] [-p] [-a | -b rows] [-x app] <image.cyacd>\n"
+                    "  -s       update the local simulated device instead of an I2C device\n"
+                    "  -f       send every row instead of the changed rows only\n"
+                    "  -z       send the bursts LZ compressed\n"
+                    "  -r       with -f, keep a progress journal and resume an interrupted update (%u rows or more)\n"
+                    "  -p       verify by reading the rows back from flash (slow)\n"
+                    "  -a       choose the packet size and the rows per burst from the probed link\n"
+                    "  -b rows  rows per burst, 0 programs one row per command (default %u)\n"
+                    "  -x app   then launch the resident application app: 0 slot A, 1 slot B (one device only)\n",
+            name, name, BTLDR_IMAGE_JOURNAL_MIN_ROWS, UPDATE_ROWS_PER_BURST);
+}
+
+/* Probes the link and chooses the packet size and the rows per burst */
+static void Update_Tune(const BtldrHost_Link *link, double (*clock)(void *context), int background, size_t rowCount,
+                        BtldrTune_Choice *choice)
+{
+    BtldrTune_Model model = BtldrTune_defaultModel;
+    int result;
+
+    model.background = background;
+    result = BtldrTune_Probe(link, clock, NULL, &model);
+    if(result != BTLDR_HOST_SUCCESS)
+    {
+        fprintf(stderr, "cannot probe the link (%d), tuning for the default model\n", result);
+    }
+
+    BtldrTune_Choose(&model, link->rowSize, rowCount, link->packetSize, choice);
+    printf("%.0f us + %.1f us/byte per transaction: %zu byte packets, %u rows per burst, "
+           "%.3f s modelled for %zu rows\n", model.overhead * 1e6, model.byteTime * 1e6, choice->packetSize,
+           (unsigned) choice->rowsPerBurst, choice->estimate, rowCount);
+}
+
+/* Device time per command, for the commands called since Enter */
+static void Update_PrintCounters(const BtldrHost_Counter *counters, size_t count)
+{
+    size_t i;
+
+    printf("command  calls  total ms    max ms  flash ms   wait ms\n");
+    for(i = 0u; i < count; i++)
+    {
+        if(counters[i].calls != 0u)
+        {
+            printf("   0x%02X %6u %9.3f %9.3f %9.3f %9.3f\n", (unsigned) counters[i].command,
+                   (unsigned) counters[i].calls, counters[i].time * 1e3, counters[i].maxTime * 1e3,
+                   counters[i].flashTime * 1e3, counters[i].waitTime * 1e3);
+        }
+    }
+}
+
+static double Update_Elapsed(const struct timespec *start)
+{
+    struct timespec end;
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return ((double)(end.tv_sec - start->tv_sec) + ((double)(end.tv_nsec - start->tv_nsec) * 1e-9));
+}
+
+
+/*******************************************************************************
+* Function Name: Update_Fleet
+********************************************************************************
+*
+* Summary:
+*  Updates every device named by the <i2c device> <address>[,<address>...]
+*  pairs of args at once, one bus per i2c device.
+*
+* Return:
+*  Exit code of the tool.
+*
+*******************************************************************************/
+static int Update_Fleet(char *args[], int pairs, const char *path, const BtldrImage_Options *options, int tune)
+{
+    static I2cLinux devices[UPDATE_MAX_TARGETS];
+    static BtldrHost_Transport transports[UPDATE_MAX_TARGETS];
+    static BtldrFleet_Target targets[UPDATE_MAX_TARGETS];
+    static BtldrFleet_Bus buses[UPDATE_MAX_TARGETS];
+    BtldrImage_Options tuned = *options;
+    BtldrTune_Choice choice;
+    Cyacd_Image image;
+    struct timespec start;
+    const char *next;
+    char *end;
+    unsigned long address;
+    size_t count = 0u;
+    size_t rows = 0u;
+    size_t i;
+    int pair;
+    int result;
+
+    result = Cyacd_Load(path, &image);
+    if(result != CYACD_SUCCESS)
+    {
+        fprintf(stderr, "%s: cannot read image (%d)\n", path, result);
+        return (1);
+    }
+
+    for(pair = 0; (result == 0) && (pair < pairs); pair++)
+    {
+        buses[pair].targets = &targets[count];
+        buses[pair].targetCount = 0u;
+        buses[pair].clock = NULL;
+        buses[pair].clockContext = NULL;
+
+        for(next = args[(2 * pair) + 1]; (result == 0) && (*next != '\0'); next = (*end == ',') ? (end + 1) : end)
+        {
+            if(count == UPDATE_MAX_TARGETS)
+            {
+                fprintf(stderr, "at most %u devices\n", UPDATE_MAX_TARGETS);
+                result = 1;
+                break;
+            }
+            address = strtoul(next, &end, 0);
+            if((end == next) || ((*end != ',') && (*end != '\0')) || (address > 0x7Fu))
+            {
+                fprintf(stderr, "%s: not an address\n", next);
+                result = 1;
+                break;
+            }
+            if(I2cLinux_Open(&devices[count], args[2 * pair], (uint8_t) address) != 0)
+            {
+                perror(args[2 * pair]);
+                result = 1;
+                break;
+            }
+            I2cLinux_Transport(&devices[count], &transports[count]);
+            targets[count].link.transport = &transports[count];
+            targets[count].link.packetSize = BTLDR_HOST_MAX_PACKET;
+            targets[count].link.rowSize = UPDATE_ROW_SIZE;
+            targets[count].image = &image;
+            buses[pair].targetCount++;
+            count++;
+        }
+    }
+
+    if((result == 0) && (tune != 0))
+    {
+        Update_Tune(&targets[0].link, NULL, 0, image.rowCount, &choice);
+        tuned.rowsPerBurst = choice.rowsPerBurst;
+        for(i = 0u; i < count; i++)
+        {
+            targets[i].link.packetSize = choice.packetSize;
+        }
+    }
+
+    if(result == 0)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        result = BtldrFleet_Update(buses, (size_t) pairs, &tuned, BTLDR_FLEET_ROW_TIME);
+
+        for(i = 0u; i < count; i++)
+        {
+            printf("0x%02X: %zu rows: %zu sent (%zu already in flash), %zu unchanged%s\n",
+                   (unsigned) devices[i].address, targets[i].stats.rowsTotal, targets[i].stats.rowsSent,
+                   targets[i].stats.rowsIdentical, targets[i].stats.rowsSkipped,
+                   (targets[i].result == BTLDR_HOST_SUCCESS) ? "" : ", update failed");
+            rows += targets[i].stats.rowsSent;
+        }
+        printf("%zu devices, %zu rows sent, %.3f s\n", count, rows, Update_Elapsed(&start));
+        if(result != BTLDR_HOST_SUCCESS)
+        {
+            fprintf(stderr, "update failed (%d)\n", result);
+        }
+        result = (result == BTLDR_HOST_SUCCESS) ? 0 : 1;
+    }
+
+    for(i = 0u; i < count; i++)
+    {
+        I2cLinux_Close(&devices[i]);
+    }
+    Cyacd_Free(&image);
+
+    return (result);
+}
+
+int main(int argc, char *argv[])
+{
+    BtldrImage_Options options = {UPDATE_ROWS_PER_BURST, 1, 0, 0, 0};
+    BtldrImage_Stats stats;
+    BtldrSim_Stats simStats;
+    BtldrHost_Transport transport;
+    BtldrHost_Link link;
+    Cyacd_Stream stream;
+    I2cLinux device;
+    struct timespec start;
+    BtldrTune_Choice choice;
+    BtldrHost_Counter counters[UPDATE_MAX_COUNTERS];
+    size_t counterCount = 0u;
+    const char *path;
+    int simulated = 0;
+    int tune = 0;
+    int app = -1;
+    int option;
+    int result;
+
+    while((option = getopt(argc, argv, "sfzrpab:x:")) != -1)
+    {
+        switch(option)
+        {
+        case 's':
+            simulated = 1;
+            break;
+        case 'f':
+            options.delta = 0;
+            break;
+        case 'z':
+            options.compress = 1;
+            break;
+        case 'r':
+            options.resume = 1;
+            break;
+        case 'p':
+            options.readBack = 1;
+            break;
+        case 'a':
+            tune = 1;
+            break;
+        case 'b':
+            options.rowsPerBurst = (uint16_t) strtoul(optarg, NULL, 0);
+            break;
+        case 'x':
+            app = (int) strtoul(optarg, NULL, 0);
+            break;
+        default:
+            Update_Usage(argv[0]);
+            return (2);
+        }
+    }
+    if((simulated != 0) ? ((argc - optind) != 1) : (((argc - optind) < 3) || (((argc - optind) % 2) == 0)))
+    {
+        Update_Usage(argv[0]);
+        return (2);
+    }
+    path = argv[argc - 1];
+
+    if((simulated == 0) && (((argc - optind) > 3) || (strchr(argv[optind + 1], ',') != NULL)))
+    {
+        if(app >= 0)
+        {
+            Update_Usage(argv[0]);
+            return (2);
+        }
+        return (Update_Fleet(&argv[optind], (argc - optind) / 2, path, &options, tune));
+    }
+
+    result = Cyacd_Open(path, &stream);
+    if(result != CYACD_SUCCESS)
+    {
+        fprintf(stderr, "%s: cannot read image (%d)\n", path, result);
+        return (1);
+    }
+
+    if(simulated != 0)
+    {
+        if(BtldrSim_Open(NULL) != 0)
+        {
+            fprintf(stderr, "cannot start the simulated device\n");
+            Cyacd_Close(&stream);
+            return (1);
+        }
+        BtldrSim_Transport(&transport);
+    }
+    else
+    {
+        if(I2cLinux_Open(&device, argv[optind], (uint8_t) strtoul(argv[optind + 1], NULL, 0)) != 0)
+        {
+            perror(argv[optind]);
+            Cyacd_Close(&stream);
+            return (1);
+        }
+        I2cLinux_Transport(&device, &transport);
+    }
+    link.transport = &transport;
+    link.packetSize = BTLDR_HOST_MAX_PACKET;
+    link.rowSize = UPDATE_ROW_SIZE;
+
+    if(tune != 0)
+    {
+        /* The rows are not parsed yet: a row line takes 2 * rowSize + 15 characters */
+        Update_Tune(&link, (simulated != 0) ? &BtldrSim_Clock : NULL, (simulated != 0) ? BtldrSim_backgroundWrite : 0,
+                    stream.size / ((2u * UPDATE_ROW_SIZE) + 15u), &choice);
+        link.packetSize = choice.packetSize;
+        options.rowsPerBurst = choice.rowsPerBurst;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    result = BtldrImage_UpdateStream(&link, &stream, &options, &stats);
+    if(result == BTLDR_HOST_SUCCESS)
+    {
+        /* Bootloaders built without the counters have none to report */
+        if(BtldrHost_GetCounters(&link, counters, UPDATE_MAX_COUNTERS, &counterCount) != BTLDR_HOST_SUCCESS)
+        {
+            counterCount = 0u;
+        }
+        if(app >= 0)
+        {
+            result = BtldrHost_SelectApp(&link, (uint8_t) app);
+        }
+    }
+    if(result == BTLDR_HOST_SUCCESS)
+    {
+        result = BtldrHost_Exit(&link);
+    }
+
+    printf("%zu rows: %zu sent (%zu already in flash), %zu unchanged (%zu resumed), %.3f s\n", stats.rowsTotal,
+           stats.rowsSent, stats.rowsIdentical, stats.rowsSkipped, stats.rowsResumed, Update_Elapsed(&start));
+    if(counterCount != 0u)
+    {
+        Update_PrintCounters(counters, counterCount);
+    }
+    if(result != BTLDR_HOST_SUCCESS)
+    {
+        fprintf(stderr, "update failed (%d)\n", result);
+    }
+
+    if(simulated != 0)
+    {
+        BtldrSim_GetStats(&simStats);
+        printf("simulated device: %u row writes, %.3f s on a %.0f Hz bus\n", (unsigned) simStats.rowWrites,
+               simStats.now, BtldrSim_defaultTiming.bitRate);
+        BtldrSim_Close();
+    }
+    else
+    {
+        I2cLinux_Close(&device);
+    }
+    Cyacd_Close(&stream);
+
+    return ((result == BTLDR_HOST_SUCCESS) ? 0 : 1);
+}
+
+
+/* [] END OF FILE */
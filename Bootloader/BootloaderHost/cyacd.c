@@ -0,0 +1,322 @@
+/*******************************************************************************
+* File: cyacd.c
+*
+* Version: 1.0
+*
+* Description:
+*  Reader of the .cyacd bootloadable image files. The header line holds the
+*  silicon ID, the silicon revision and the packet checksum type. Every other
+*  line is ":" followed by the array ID, the row number, the data length, the
+*  row data and a checksum of all previous bytes of the line, in hex.
+*
+*  The stream maps the file and converts one row per call straight into the
+*  caller's buffer: the text is neither copied nor kept, and no memory is
+*  allocated per row. Cyacd_Load() reads the whole image with the same
+*  parser.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "cyacd.h"
+
+/* Array ID, row number, data length */
+#define CYACD_ROW_HEADER        (5u)
+
+static int Cyacd_HexDigit(char c)
+{
+    if((c >= '0') && (c <= '9'))
+    {
+        return (c - '0');
+    }
+    if((c >= 'A') && (c <= 'F'))
+    {
+        return (c - 'A' + 10);
+    }
+    if((c >= 'a') && (c <= 'f'))
+    {
+        return (c - 'a' + 10);
+    }
+    return (-1);
+}
+
+/* Converts size bytes of hex text. Returns 0 on success. */
+static int Cyacd_HexBytes(const char *text, uint8_t *out, size_t size)
+{
+    size_t i;
+    int hi;
+    int lo;
+
+    for(i = 0u; i < size; i++)
+    {
+        hi = Cyacd_HexDigit(text[2u * i]);
+        lo = Cyacd_HexDigit(text[(2u * i) + 1u]);
+        if((hi < 0) || (lo < 0))
+        {
+            return (-1);
+        }
+        out[i] = (uint8_t)((hi << 4) | lo);
+    }
+
+    return (0);
+}
+
+
+/*******************************************************************************
+* Function Name: Cyacd_Open
+********************************************************************************
+*
+* Summary:
+*  Maps a .cyacd file and parses its header line. The rows are parsed by
+*  Cyacd_NextRow() when they are needed.
+*
+* Return:
+*  CYACD_SUCCESS or a negative CYACD_ERR code. On error nothing is mapped.
+*
+*******************************************************************************/
+int Cyacd_Open(const char *path, Cyacd_Stream *stream)
+{
+    uint8_t header[6];
+    struct stat info;
+    void *text;
+    int fd;
+
+    memset(stream, 0, sizeof(*stream));
+
+    fd = open(path, O_RDONLY);
+    if(fd < 0)
+    {
+        return (CYACD_ERR_FILE);
+    }
+    if(fstat(fd, &info) != 0)
+    {
+        close(fd);
+        return (CYACD_ERR_FILE);
+    }
+
+    /* Header: 4-byte silicon ID, silicon revision, checksum type */
+    if(info.st_size < 12)
+    {
+        close(fd);
+        return (CYACD_ERR_FORMAT);
+    }
+
+    text = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(text == MAP_FAILED)
+    {
+        return (CYACD_ERR_FILE);
+    }
+    (void) madvise(text, (size_t) info.st_size, MADV_SEQUENTIAL);
+
+    stream->text = (const char *) text;
+    stream->size = (size_t) info.st_size;
+    if(Cyacd_HexBytes(stream->text, header, sizeof(header)) != 0)
+    {
+        Cyacd_Close(stream);
+        return (CYACD_ERR_FORMAT);
+    }
+
+    stream->siliconId = ((uint32_t) header[0] << 24) | ((uint32_t) header[1] << 16) |
+                        ((uint32_t) header[2] << 8) | header[3];
+    stream->siliconRev = header[4];
+    stream->checksumType = header[5];
+    stream->offset = 12u;
+
+    return (CYACD_SUCCESS);
+}
+
+
+/*******************************************************************************
+* Function Name: Cyacd_NextRow
+********************************************************************************
+*
+* Summary:
+*  Parses the next row line of the stream.
+*
+* Parameters:
+*  row:      Receives the row; row->data points to data.
+*  data:     Buffer for the row data.
+*  dataSize: Size of the buffer.
+*
+* Return:
+*  CYACD_SUCCESS, CYACD_END after the last row, or a negative CYACD_ERR code.
+*  CYACD_ERR_SIZE if the row data does not fit in the buffer.
+*
+*******************************************************************************/
+int Cyacd_NextRow(Cyacd_Stream *stream, Cyacd_Row *row, uint8_t *data, size_t dataSize)
+{
+    const char *line;
+    size_t length = 0u;
+    size_t i;
+    uint8_t header[CYACD_ROW_HEADER];
+    uint8_t sum = 0u;
+    uint8_t checksum;
+
+    while((stream->offset < stream->size) && (stream->text[stream->offset] != ':'))
+    {
+        stream->offset++;
+    }
+    if(stream->offset >= stream->size)
+    {
+        return (CYACD_END);
+    }
+
+    line = &stream->text[stream->offset + 1u];
+    while(((stream->offset + 1u + length) < stream->size) && (line[length] != '\r') &&
+          (line[length] != '\n') && (line[length] != ':'))
+    {
+        length++;
+    }
+    stream->offset += 1u + length;
+
+    if((length < (2u * (CYACD_ROW_HEADER + 1u))) || (Cyacd_HexBytes(line, header, CYACD_ROW_HEADER) != 0))
+    {
+        return (CYACD_ERR_FORMAT);
+    }
+
+    row->arrayId = header[0];
+    row->row = (uint16_t)((header[1] << 8) | header[2]);
+    row->size = (uint16_t)((header[3] << 8) | header[4]);
+    row->data = data;
+
+    if(length != (2u * (CYACD_ROW_HEADER + row->size + 1u)))
+    {
+        return (CYACD_ERR_FORMAT);
+    }
+    if(row->size > dataSize)
+    {
+        return (CYACD_ERR_SIZE);
+    }
+    if((Cyacd_HexBytes(line + (2u * CYACD_ROW_HEADER), data, row->size) != 0) ||
+       (Cyacd_HexBytes(line + (2u * (CYACD_ROW_HEADER + row->size)), &checksum, 1u) != 0))
+    {
+        return (CYACD_ERR_FORMAT);
+    }
+
+    for(i = 0u; i < CYACD_ROW_HEADER; i++)
+    {
+        sum = (uint8_t)(sum + header[i]);
+    }
+    for(i = 0u; i < row->size; i++)
+    {
+        sum = (uint8_t)(sum + data[i]);
+    }
+
+    return (((uint8_t)(sum + checksum) == 0u) ? CYACD_SUCCESS : CYACD_ERR_CHECKSUM);
+}
+
+
+/*******************************************************************************
+* Function Name: Cyacd_Close
+********************************************************************************
+*
+* Summary:
+*  Unmaps the file of a stream.
+*
+*******************************************************************************/
+void Cyacd_Close(Cyacd_Stream *stream)
+{
+    if(stream->text != NULL)
+    {
+        (void) munmap((void *) stream->text, stream->size);
+    }
+    memset(stream, 0, sizeof(*stream));
+}
+
+
+/*******************************************************************************
+* Function Name: Cyacd_Load
+********************************************************************************
+*
+* Summary:
+*  Reads a whole .cyacd file and converts every row to binary.
+*
+* Return:
+*  CYACD_SUCCESS or a negative CYACD_ERR code. On error the image is empty.
+*
+*******************************************************************************/
+int Cyacd_Load(const char *path, Cyacd_Image *image)
+{
+    Cyacd_Stream stream;
+    size_t lines = 0u;
+    size_t used = 0u;
+    size_t capacity;
+    size_t i;
+    int result;
+
+    memset(image, 0, sizeof(*image));
+
+    result = Cyacd_Open(path, &stream);
+    if(result != CYACD_SUCCESS)
+    {
+        return (result);
+    }
+
+    for(i = 0u; i < stream.size; i++)
+    {
+        lines += (stream.text[i] == ':') ? 1u : 0u;
+    }
+
+    /* Row data never exceeds half of the text size */
+    capacity = (stream.size / 2u) + 1u;
+    image->rows = calloc((lines != 0u) ? lines : 1u, sizeof(Cyacd_Row));
+    image->storage = malloc(capacity);
+    if((image->rows == NULL) || (image->storage == NULL))
+    {
+        Cyacd_Close(&stream);
+        Cyacd_Free(image);
+        return (CYACD_ERR_MEMORY);
+    }
+
+    image->siliconId = stream.siliconId;
+    image->siliconRev = stream.siliconRev;
+    image->checksumType = stream.checksumType;
+
+    while((result = Cyacd_NextRow(&stream, &image->rows[image->rowCount], &image->storage[used],
+                                  capacity - used)) == CYACD_SUCCESS)
+    {
+        used += image->rows[image->rowCount].size;
+        image->rowCount++;
+    }
+
+    Cyacd_Close(&stream);
+    if(result != CYACD_END)
+    {
+        Cyacd_Free(image);
+        return (result);
+    }
+
+    return (CYACD_SUCCESS);
+}
+
+
+/*******************************************************************************
+* Function Name: Cyacd_Free
+********************************************************************************
+*
+* Summary:
+*  Releases the memory of a loaded image.
+*
+*******************************************************************************/
+void Cyacd_Free(Cyacd_Image *image)
+{
+    free(image->rows);
+    free(image->storage);
+    memset(image, 0, sizeof(*image));
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,73 @@
+/*******************************************************************************
+* File: cyacd.h
+*
+* Version: 1.0
+*
+* Description:
+*  Reader of the .cyacd bootloadable image files produced by PSoC Creator:
+*  either a stream that parses one row at a time from the memory-mapped file,
+*  or a whole image loaded in memory.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#if !defined(CYACD_H)
+#define CYACD_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CYACD_SUCCESS                   (0)
+#define CYACD_END                       (1)
+#define CYACD_ERR_FILE                  (-1)
+#define CYACD_ERR_FORMAT                (-2)
+#define CYACD_ERR_CHECKSUM              (-3)
+#define CYACD_ERR_MEMORY                (-4)
+#define CYACD_ERR_SIZE                  (-5)
+
+typedef struct
+{
+    uint8_t   arrayId;
+    uint16_t  row;
+    uint16_t  size;
+    uint8_t  *data;
+} Cyacd_Row;
+
+typedef struct
+{
+    uint32_t   siliconId;
+    uint8_t    siliconRev;
+    uint8_t    checksumType;
+    size_t     rowCount;
+    Cyacd_Row *rows;
+    uint8_t   *storage;
+} Cyacd_Image;
+
+typedef struct
+{
+    const char *text;                   /* mapped file, not terminated */
+    size_t      size;
+    size_t      offset;                 /* where the search for the next row starts */
+    uint32_t    siliconId;
+    uint8_t     siliconRev;
+    uint8_t     checksumType;
+} Cyacd_Stream;
+
+int  Cyacd_Open(const char *path, Cyacd_Stream *stream);
+int  Cyacd_NextRow(Cyacd_Stream *stream, Cyacd_Row *row, uint8_t *data, size_t dataSize);
+void Cyacd_Close(Cyacd_Stream *stream);
+
+int  Cyacd_Load(const char *path, Cyacd_Image *image);
+void Cyacd_Free(Cyacd_Image *image);
+
+#endif /* CYACD_H */
+
+
+/* [] END OF FILE */
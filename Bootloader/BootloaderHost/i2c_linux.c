@@ -0,0 +1,120 @@
+/*******************************************************************************
+* File: i2c_linux.c
+*
+* Version: 1.0
+*
+* Description:
+*  I2C transport of the bootloader host tools for Linux i2c-dev adapters. The
+*  bootloader does not service the bus while it programs a row, so NACKed
+*  transactions are retried for up to I2C_LINUX_BUSY_TIMEOUT_MS.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/i2c-dev.h>
+#include "i2c_linux.h"
+
+#define I2C_LINUX_RETRY_US      (200u)
+
+static int I2cLinux_Write(void *context, const uint8_t *data, size_t size)
+{
+    I2cLinux *device = (I2cLinux *) context;
+    unsigned waited;
+
+    for(waited = 0u; waited <= (I2C_LINUX_BUSY_TIMEOUT_MS * 1000u); waited += I2C_LINUX_RETRY_US)
+    {
+        if(write(device->fd, data, size) == (ssize_t) size)
+        {
+            return (0);
+        }
+        if((errno != EIO) && (errno != EREMOTEIO) && (errno != ENXIO) && (errno != EAGAIN))
+        {
+            break;
+        }
+        usleep(I2C_LINUX_RETRY_US);
+    }
+
+    return (-1);
+}
+
+static int I2cLinux_Read(void *context, uint8_t *data, size_t size)
+{
+    I2cLinux *device = (I2cLinux *) context;
+    unsigned waited;
+
+    for(waited = 0u; waited <= (I2C_LINUX_BUSY_TIMEOUT_MS * 1000u); waited += I2C_LINUX_RETRY_US)
+    {
+        if(read(device->fd, data, size) == (ssize_t) size)
+        {
+            return (0);
+        }
+        if((errno != EIO) && (errno != EREMOTEIO) && (errno != ENXIO) && (errno != EAGAIN))
+        {
+            break;
+        }
+        usleep(I2C_LINUX_RETRY_US);
+    }
+
+    return (-1);
+}
+
+
+/*******************************************************************************
+* Function Name: I2cLinux_Open
+********************************************************************************
+*
+* Summary:
+*  Opens an i2c-dev adapter (for example /dev/i2c-1) and selects the 7-bit
+*  slave address of the bootloader.
+*
+* Return:
+*  0 on success, -1 on error.
+*
+*******************************************************************************/
+int I2cLinux_Open(I2cLinux *device, const char *path, uint8_t address)
+{
+    device->address = address;
+    device->fd = open(path, O_RDWR);
+    if(device->fd < 0)
+    {
+        return (-1);
+    }
+    if(ioctl(device->fd, I2C_SLAVE, (unsigned long) address) < 0)
+    {
+        close(device->fd);
+        device->fd = -1;
+        return (-1);
+    }
+
+    return (0);
+}
+
+void I2cLinux_Close(I2cLinux *device)
+{
+    if(device->fd >= 0)
+    {
+        close(device->fd);
+        device->fd = -1;
+    }
+}
+
+void I2cLinux_Transport(I2cLinux *device, BtldrHost_Transport *transport)
+{
+    transport->context = device;
+    transport->write = &I2cLinux_Write;
+    transport->read = &I2cLinux_Read;
+}
+
+
+/* [] END OF FILE */
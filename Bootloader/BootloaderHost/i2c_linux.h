@@ -0,0 +1,40 @@
+/*******************************************************************************
+* File: i2c_linux.h
+*
+* Version: 1.0
+*
+* Description:
+*  I2C transport of the bootloader host tools for Linux i2c-dev adapters.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#if !defined(I2C_LINUX_H)
+#define I2C_LINUX_H
+
+#include "btldr_host.h"
+
+/* Time a NACKed transaction is retried, while the device programs a row */
+#define I2C_LINUX_BUSY_TIMEOUT_MS       (100u)
+
+typedef struct
+{
+    int     fd;
+    uint8_t address;
+} I2cLinux;
+
+int  I2cLinux_Open(I2cLinux *device, const char *path, uint8_t address);
+void I2cLinux_Close(I2cLinux *device);
+void I2cLinux_Transport(I2cLinux *device, BtldrHost_Transport *transport);
+
+#endif /* I2C_LINUX_H */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,253 @@
+/*******************************************************************************
+* File: btldr_crcbench.c
+*
+* Version: 1.0
+*
+* Description:
+*  Checks and times the CRC-32C engines. First checks that every engine of
+*  btldr_crc.c and BtldrExt_Crc32() of btldr_ext.c, as built here, give the
+*  same CRC over random blocks at random alignments, and the standard check
+*  value.
+*
+*  Then gives the cycles per byte of BtldrExt_Crc32() on the Cortex-M0 of the
+*  PSoC 4 for each table choice of btldr_ext.h, from a cycle model of the
+*  Thumb loops GCC builds from it: one cycle per ALU instruction, two per
+*  load, three per taken branch, and the flash wait states on every load
+*  from flash (the rows checked and a table kept in flash; instruction
+*  fetches are assumed hidden by the flash accelerator). The loop of the
+*  FNV-1a row hash that the CRC replaced and the summation checksum of the
+*  Bootloader component are given for comparison.
+*
+*  Last, measures the MB/s of each engine on the host.
+*
+*  Build: gcc -O2 -pthread -I. -Isim -I"../CE95281 - Bootloader Project with
+*         PSoC 4/CE95281.cydsn" -o btldr_crcbench sim/btldr_crcbench.c
+*         sim/btldr_sim.c btldr_host.c btldr_crc.c btldr_lz.c
+*         "../CE95281 - Bootloader Project with PSoC 4/CE95281.cydsn/btldr_ext.c"
+*         Add -DBTLDR_EXT_CRC_TABLE_SIZE=256u (or 0u) to check the other
+*         tables of the bootloader.
+*  Usage: btldr_crcbench [CPU clock, Hz] [flash wait states]
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "btldr_crc.h"
+#include "btldr_ext.h"
+
+#define CRCBENCH_BUFFER_SIZE    (1024u * 1024u)
+#define CRCBENCH_CHECKS         (20000u)
+#define CRCBENCH_MAX_BLOCK      (600u)
+#define CRCBENCH_MIN_TIME       (0.25)
+#define CRCBENCH_ROW_SIZE       (128u)
+#define CRCBENCH_IMAGE_ROWS     (256u)
+
+typedef uint32_t (*CrcBench_Engine)(uint32_t crc, const uint8_t *data, size_t size);
+
+/* One loop of the model: the cycles of an iteration without wait states and
+* the flash loads that add the wait states
+*/
+typedef struct
+{
+    const char *name;
+    const char *table;
+    double      bytes;                  /* bytes per iteration */
+    double      cycles;                 /* at zero wait states */
+    double      dataLoads;              /* loads of the bytes checked */
+    double      tableLoads;             /* lookups in a table kept in flash */
+} CrcBench_Loop;
+
+typedef struct
+{
+    const char     *name;
+    CrcBench_Engine update;
+} CrcBench_Host;
+
+static uint32_t CrcBench_Target(uint32_t crc, const uint8_t *data, size_t size)
+{
+    uint16_t block;
+
+    while(size != 0u)
+    {
+        block = (uint16_t)((size > 0x8000u) ? 0x8000u : size);
+        crc = BtldrExt_Crc32(crc, data, block);
+        data += block;
+        size -= block;
+    }
+
+    return (crc);
+}
+
+/* Keeps the CRCs of the timed loops alive */
+static volatile uint32_t CrcBench_sink;
+
+/* The FNV-1a row hash used before the CRC, for comparison */
+static uint32_t CrcBench_Fnv(const uint8_t *data, size_t size)
+{
+    uint32_t hash = 0x811C9DC5u;
+    size_t i;
+
+    for(i = 0u; i < size; i++)
+    {
+        hash = (hash ^ data[i]) * 0x01000193u;
+    }
+
+    return (hash);
+}
+
+static double CrcBench_Now(void)
+{
+    struct timespec now;
+
+    (void) clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return ((double) now.tv_sec + ((double) now.tv_nsec * 1e-9));
+}
+
+static int CrcBench_Check(const CrcBench_Host *engines, size_t engineCount, const uint8_t *buffer)
+{
+    static const uint8_t check[] = "123456789";
+    uint32_t seed = 12345u;
+    uint32_t expected;
+    uint32_t crc;
+    size_t offset;
+    size_t size;
+    size_t split;
+    size_t i;
+    size_t j;
+    int failed = 0;
+
+    for(j = 0u; j < engineCount; j++)
+    {
+        if(engines[j].update(BTLDR_CRC_INIT, check, 9u) != BTLDR_CRC_CHECK)
+        {
+            printf("  %s: wrong check value\n", engines[j].name);
+            failed = 1;
+        }
+    }
+
+    for(i = 0u; (i < CRCBENCH_CHECKS) && (failed == 0); i++)
+    {
+        seed = (seed * 1103515245u) + 12345u;
+        offset = (seed >> 8) % 64u;
+        size = (seed >> 14) % CRCBENCH_MAX_BLOCK;
+        split = (size != 0u) ? ((seed >> 4) % size) : 0u;
+
+        expected = BtldrCrc_UpdateBytes(BTLDR_CRC_INIT, &buffer[offset], size);
+        for(j = 0u; j < engineCount; j++)
+        {
+            /* In two blocks, so the CRC of the first must carry on */
+            crc = engines[j].update(BTLDR_CRC_INIT, &buffer[offset], split);
+            crc = engines[j].update(crc, &buffer[offset + split], size - split);
+            if(crc != expected)
+            {
+                printf("  %s: CRC %08X, expected %08X, %u bytes at offset %u\n", engines[j].name,
+                       (unsigned int) crc, (unsigned int) expected, (unsigned int) size, (unsigned int) offset);
+                failed = 1;
+            }
+        }
+    }
+
+    return (failed);
+}
+
+int main(int argc, char *argv[])
+{
+    static const CrcBench_Loop loops[] =
+    {
+        /* ldr word, eors; per lookup lsls, lsrs, ldr, lsrs, eors; adds, cmp, bne */
+        {"crc-32c, 256 entries", "flash 1024 B", 4.0, 32.0, 1.0, 4.0},
+        {"crc-32c, 256 entries", "ram 1024 B",   4.0, 32.0, 1.0, 0.0},
+        {"crc-32c, 16 entries",  "flash 64 B",   4.0, 56.0, 1.0, 8.0},
+        {"crc-32c, 16 entries",  "ram 64 B",     4.0, 56.0, 1.0, 0.0},
+        /* ldr word, eors; per byte movs; per bit lsls, asrs, ands, lsrs, eors, subs, bne */
+        {"crc-32c, no table",    "-",            4.0, 300.0, 1.0, 0.0},
+        /* ldrb, eors, muls, adds, cmp, bne */
+        {"fnv-1a",               "-",            1.0, 9.0, 1.0, 0.0},
+        /* ldrb, adds, adds, cmp, bne */
+        {"summation checksum",   "-",            1.0, 8.0, 1.0, 0.0},
+    };
+    static const CrcBench_Host engines[] =
+    {
+        {"BtldrExt_Crc32",         &CrcBench_Target},
+        {"BtldrCrc_UpdateBytes",   &BtldrCrc_UpdateBytes},
+        {"BtldrCrc_UpdateSliced",  &BtldrCrc_UpdateSliced},
+        {"BtldrCrc_UpdateHardware", &BtldrCrc_UpdateHardware},
+        {"BtldrCrc_Update",        &BtldrCrc_Update},
+    };
+    double clock = (argc > 1) ? atof(argv[1]) : 48e6;
+    double waitStates = (argc > 2) ? atof(argv[2]) : 1.0;
+    double perByte;
+    double start;
+    double elapsed;
+    uint32_t seed = 1u;
+    uint8_t *buffer;
+    size_t passes;
+    size_t i;
+
+    buffer = malloc(CRCBENCH_BUFFER_SIZE);
+    if(buffer == NULL)
+    {
+        return (1);
+    }
+    for(i = 0u; i < CRCBENCH_BUFFER_SIZE; i++)
+    {
+        seed = (seed * 1103515245u) + 12345u;
+        buffer[i] = (uint8_t)(seed >> 16);
+    }
+
+    printf("bootloader table of %u entries in %s, CRC32 instruction on the host: %s\n",
+           BTLDR_EXT_CRC_TABLE_SIZE, (BTLDR_EXT_CRC_TABLE_IN_RAM != 0u) ? "ram" : "flash",
+           (BtldrCrc_HasHardware() != 0) ? "yes" : "no");
+    if(CrcBench_Check(engines, sizeof(engines) / sizeof(engines[0]), buffer) != 0)
+    {
+        free(buffer);
+        return (1);
+    }
+    printf("all engines agree on %u random blocks\n", CRCBENCH_CHECKS);
+
+    printf("cortex-m0 at %.0f MHz, %.0f flash wait states\n", clock * 1e-6, waitStates);
+    for(i = 0u; i < (sizeof(loops) / sizeof(loops[0])); i++)
+    {
+        perByte = (loops[i].cycles + (waitStates * (loops[i].dataLoads + loops[i].tableLoads))) / loops[i].bytes;
+        printf("  %-21s %-13s %6.2f cycles/byte %8.1f us/row %8.2f ms/%u rows\n",
+               loops[i].name, loops[i].table, perByte, perByte * CRCBENCH_ROW_SIZE * 1e6 / clock,
+               perByte * CRCBENCH_ROW_SIZE * CRCBENCH_IMAGE_ROWS * 1e3 / clock, CRCBENCH_IMAGE_ROWS);
+    }
+
+    printf("host, %u kB blocks\n", CRCBENCH_BUFFER_SIZE / 1024u);
+    for(i = 0u; i <= (sizeof(engines) / sizeof(engines[0])); i++)
+    {
+        passes = 0u;
+        start = CrcBench_Now();
+        do
+        {
+            CrcBench_sink = (i < (sizeof(engines) / sizeof(engines[0]))) ?
+                            engines[i].update(BTLDR_CRC_INIT, buffer, CRCBENCH_BUFFER_SIZE) :
+                            CrcBench_Fnv(buffer, CRCBENCH_BUFFER_SIZE);
+            passes++;
+            elapsed = CrcBench_Now() - start;
+        }
+        while(elapsed < CRCBENCH_MIN_TIME);
+
+        printf("  %-24s %9.1f MB/s\n", (i < (sizeof(engines) / sizeof(engines[0]))) ? engines[i].name : "fnv-1a",
+               (double) passes * CRCBENCH_BUFFER_SIZE / elapsed * 1e-6);
+    }
+
+    free(buffer);
+
+    return (0);
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,742 @@
+/*******************************************************************************
+* File: btldr_sim.c
+*
+* Version: 1.0
+*
+* Description:
+*  Local stand-in for a CE95281 device on the I2C bus. BtldrExt_HostLink()
+*  runs in its own thread; the communication functions it calls exchange the
+*  packets with the transport used by the host tools. The two sides run in
+*  lock step: a write returns once the device has executed the packet and
+*  waits for the next one, and a read returns the response left by the
+*  device or fails as a NACK when there is none.
+*
+*  A virtual clock models the time the exchange would take on the bus. A
+*  transaction costs the adapter overhead plus nine bit times per byte,
+*  address included. After a write the device is busy for the time it takes
+*  to handle the received bytes and to erase and program the rows written by
+*  the command; a transaction that reaches it while it is busy is stretched
+*  until it is done, as the SCB stretches the clock while the CPU stalls on
+*  a flash write. A row written with the non-blocking write keeps the flash
+*  busy instead of the CPU: the device goes on receiving and is stalled only
+*  when it polls the write before it has completed.
+*
+*  BtldrSim_Boot() runs the start-up of the device with no host on the bus:
+*  CyBtldr_CheckLaunch() of the reset handler, which launches a scheduled
+*  bootloadable before main() and clears the run type on any reset but a
+*  software reset, then BtldrExt_Start() of main(), through every software
+*  reset, until an application is launched. Watchdog counter 0 keeps its
+*  configuration over the resets; the caller models its timeout.
+*
+*  Simplifications: the flash keeps its content from one BtldrSim_Open() to
+*  the next and is erased by BtldrSim_Erase() only. The bootloadable is
+*  reported valid when its metadata row and its first row, which holds the
+*  vector table, are not erased. Computing row hashes
+*  and the application checksum takes no virtual time. SysTick counts the
+*  virtual time of the device at CYDEV_BCLK__SYSCLK__HZ.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <pthread.h>
+#include <string.h>
+#include <project.h>
+#include "btldr_ext.h"
+#include "btldr_sim.h"
+
+/* Device thread states */
+#define BTLDR_SIM_BUSY          (0)     /* executing a packet */
+#define BTLDR_SIM_WAITING       (1)     /* in CyBtldrCommRead() */
+#define BTLDR_SIM_STOPPED       (2)     /* left the bootloader */
+
+/* The start-up ended in a software reset */
+#define BTLDR_SIM_RESET         (-1)
+
+/* Software resets and host polls after which a start-up is given up */
+#define BTLDR_SIM_MAX_STARTS    (8)
+#define BTLDR_SIM_MAX_POLLS     (1000u)
+
+uint8 BtldrSim_flash[CY_FLASH_NUMBER_ROWS * CY_FLASH_SIZEOF_ROW];
+uint8 BtldrSim_runType = Bootloader_START_BTLDR;
+uintptr_t BtldrSim_codeAddr;
+
+static pthread_mutex_t BtldrSim_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  BtldrSim_changed = PTHREAD_COND_INITIALIZER;
+static pthread_t BtldrSim_thread;
+static pthread_t BtldrSim_bootThread;    /* start-up of BtldrSim_Boot() */
+static int       BtldrSim_state;
+static int       BtldrSim_closing;
+static uint8     BtldrSim_packet[BTLDR_EXT_SIZEOF_PACKET];
+static uint16    BtldrSim_packetSize;
+static uint8     BtldrSim_response[BTLDR_EXT_SIZEOF_PACKET];
+static uint16    BtldrSim_responseSize;
+static BtldrSim_Timing BtldrSim_timing;
+static BtldrSim_Stats  BtldrSim_stats;
+static double    BtldrSim_busyUntil;     /* end of the work of the last packet */
+static double    BtldrSim_work;          /* device time spent on the current packet */
+static double    BtldrSim_flashUntil;    /* end of the background row write */
+static uint32    BtldrSim_tickReload;    /* SysTick reload value */
+static int       BtldrSim_hostless;      /* BtldrSim_Boot() runs: no host on the bus */
+static int       BtldrSim_launched;      /* how the start-up of BtldrSim_Boot() ended */
+static uint32    BtldrSim_polls;         /* host polls of the start-up */
+static double    BtldrSim_hostWait;      /* time the start-ups of BtldrSim_Boot() waited for a host */
+static uint32    BtldrSim_wdtEnabled;    /* watchdog counters enabled */
+static uint32    BtldrSim_wdtMode;       /* mode of watchdog counter 0 */
+static uint32    BtldrSim_wdtMatch;      /* match value of watchdog counter 0 */
+uint32           BtldrSim_nvicClear;
+uint32           BtldrSim_nvicClearPending;
+
+const int BtldrSim_backgroundWrite = (BTLDR_EXT_BACKGROUND_WRITE != 0u);
+
+/* CY8CKIT-049-42xx over a USB I2C adapter. Row erase and program times are
+* the maximum values of the PSoC 4200 datasheet.
+*/
+const BtldrSim_Timing BtldrSim_defaultTiming = {100000.0, 1000e-6, 13e-3, 7e-3, 0.25e-6};
+
+static void *BtldrSim_Device(void *argument)
+{
+    (void) argument;
+
+    /* Timeout 0: serve the host until it sends the Exit command */
+    BtldrExt_HostLink(0u);
+
+    return (NULL);
+}
+
+/* Leaves the device thread, as a device reset leaves the bootloader */
+static void BtldrSim_Stop(void)
+{
+    pthread_mutex_lock(&BtldrSim_lock);
+    BtldrSim_state = BTLDR_SIM_STOPPED;
+    pthread_cond_broadcast(&BtldrSim_changed);
+    pthread_mutex_unlock(&BtldrSim_lock);
+    pthread_exit(NULL);
+}
+
+/* Reports whether the caller is the firmware in a device thread */
+static int BtldrSim_OnDevice(void)
+{
+    return (((pthread_equal(pthread_self(), BtldrSim_thread) != 0) ||
+             (pthread_equal(pthread_self(), BtldrSim_bootThread) != 0)) ? 1 : 0);
+}
+
+/* main() of the bootloader, for BtldrSim_Boot() */
+static void *BtldrSim_Main(void *argument)
+{
+    (void) argument;
+
+    BtldrExt_Start();
+
+    /* Bootloader_Start() launches the scheduled bootloadable */
+    BtldrSim_launched = BTLDR_SIM_APP_A;
+    BtldrSim_Stop();
+
+    return (NULL);
+}
+
+
+/***************************************
+*        Device side
+***************************************/
+
+uint32 CySysFlashWriteRow(uint32 rowNum, const uint8 rowData[])
+{
+    memcpy(&BtldrSim_flash[rowNum * CY_FLASH_SIZEOF_ROW], rowData, CY_FLASH_SIZEOF_ROW);
+    BtldrSim_stats.rowWrites++;
+
+    /* The row is erased, then programmed; the CPU is stalled meanwhile */
+    BtldrSim_work += BtldrSim_timing.rowErase + BtldrSim_timing.rowProgram +
+                     ((double) CY_FLASH_SIZEOF_ROW * BtldrSim_timing.byteTime);
+    BtldrSim_stats.flashTime += BtldrSim_timing.rowErase + BtldrSim_timing.rowProgram;
+
+    return (CY_SYS_FLASH_SUCCESS);
+}
+
+uint32 CySysFlashStartWriteRow(uint32 rowNum, const uint8 rowData[])
+{
+    /* The content is only read back after the write has completed */
+    memcpy(&BtldrSim_flash[rowNum * CY_FLASH_SIZEOF_ROW], rowData, CY_FLASH_SIZEOF_ROW);
+    BtldrSim_stats.rowWrites++;
+
+    BtldrSim_work += (double) CY_FLASH_SIZEOF_ROW * BtldrSim_timing.byteTime;
+    BtldrSim_flashUntil = BtldrSim_stats.now + BtldrSim_work + BtldrSim_timing.rowErase +
+                          BtldrSim_timing.rowProgram;
+    BtldrSim_stats.flashTime += BtldrSim_timing.rowErase + BtldrSim_timing.rowProgram;
+
+    return (CY_SYS_FLASH_SUCCESS);
+}
+
+uint32 CySysFlashGetWriteRowStatus(void)
+{
+    /* The device polls until the write completes */
+    if((BtldrSim_stats.now + BtldrSim_work) < BtldrSim_flashUntil)
+    {
+        BtldrSim_work = BtldrSim_flashUntil - BtldrSim_stats.now;
+    }
+
+    return (CY_SYS_FLASH_SUCCESS);
+}
+
+/* Reports whether a row holds only zeros, as left by an erase */
+static int BtldrSim_RowErased(uint16 row)
+{
+    const uint8 *rowData = &BtldrSim_flash[row * CY_FLASH_SIZEOF_ROW];
+    uint16 i;
+
+    for(i = 0u; i < CY_FLASH_SIZEOF_ROW; i++)
+    {
+        if(rowData[i] != 0u)
+        {
+            return (0);
+        }
+    }
+
+    return (1);
+}
+
+cystatus Bootloader_ValidateBootloadable(uint8 appId)
+{
+    (void) appId;
+
+    return (((BtldrSim_RowErased(CY_FLASH_NUMBER_ROWS - 1u) == 0) &&
+             (BtldrSim_RowErased(BTLDR_EXT_FIRST_APP_ROW) == 0)) ? CYRET_SUCCESS : CYRET_TIMEOUT);
+}
+
+void Bootloader_Exit(uint8 appId)
+{
+    /* The launch is scheduled only for a bootloadable that passes */
+    if(Bootloader_ValidateBootloadable(appId) == CYRET_SUCCESS)
+    {
+        BtldrSim_runType = Bootloader_START_APP;
+    }
+    BtldrSim_Stop();
+}
+
+void CyBtldrCommStart(void)
+{
+}
+
+void CyBtldrCommStop(void)
+{
+}
+
+void CyDelayUs(uint16 microseconds)
+{
+    BtldrSim_work += (double) microseconds * 1e-6;
+}
+
+/* The bootloadable calls it outside the device thread: its reset is left
+* to the next BtldrSim_Boot(), which takes the run type set before it
+*/
+void CySoftwareReset(void)
+{
+    if(BtldrSim_OnDevice() != 0)
+    {
+        BtldrSim_Stop();
+    }
+}
+
+/* Called by the bootloadable, outside the device thread: the software reset
+* is left to the next BtldrSim_Boot(), which takes the run type set here
+*/
+void Bootloadable_Load(void)
+{
+    BtldrSim_runType = Bootloader_START_BTLDR;
+}
+
+/* Only the bootloader launches an application in place: slot B */
+void __set_MSP(uint32 topOfMainStack)
+{
+    (void) topOfMainStack;
+
+    BtldrSim_launched = BTLDR_SIM_APP_B;
+    BtldrSim_Stop();
+}
+
+void CySysTickEnable(void)
+{
+}
+
+void CySysTickStop(void)
+{
+}
+
+void CySysTickDisableInterrupt(void)
+{
+}
+
+void CySysTickSetClockSource(uint32 clockSource)
+{
+    (void) clockSource;
+}
+
+void CySysTickSetReload(uint32 value)
+{
+    BtldrSim_tickReload = value;
+}
+
+void CySysTickClear(void)
+{
+}
+
+uint32 CySysTickGetValue(void)
+{
+    /* Virtual time of the device; the host waits while the device runs */
+    uint64_t cycles = (uint64_t)((BtldrSim_stats.now + BtldrSim_work) * (double) CYDEV_BCLK__SYSCLK__HZ);
+
+    return (BtldrSim_tickReload - (uint32)(cycles % ((uint64_t) BtldrSim_tickReload + 1u)));
+}
+
+/* Watchdog counter 0 is configured, never counts; see BtldrSim_Watchdog() */
+void CySysWdtUnlock(void)
+{
+}
+
+void CySysWdtLock(void)
+{
+}
+
+void CySysWdtWriteMode(uint32 counterNum, uint32 mode)
+{
+    if(counterNum == CY_SYS_WDT_COUNTER0)
+    {
+        BtldrSim_wdtMode = mode;
+    }
+}
+
+void CySysWdtWriteMatch(uint32 counterNum, uint32 match)
+{
+    if(counterNum == CY_SYS_WDT_COUNTER0)
+    {
+        BtldrSim_wdtMatch = match;
+    }
+}
+
+void CySysWdtWriteClearOnMatch(uint32 counterNum, uint32 enable)
+{
+    (void) counterNum;
+    (void) enable;
+}
+
+void CySysWdtResetCounters(uint32 countersMask)
+{
+    (void) countersMask;
+}
+
+void CySysWdtEnable(uint32 counterMask)
+{
+    BtldrSim_wdtEnabled |= counterMask;
+}
+
+void CySysWdtDisable(uint32 counterMask)
+{
+    BtldrSim_wdtEnabled &= ~counterMask;
+}
+
+uint32 I2C_Slave_I2CSlaveStatus(void)
+{
+    uint32 status;
+
+    pthread_mutex_lock(&BtldrSim_lock);
+    status = ((BtldrSim_hostless == 0) && (BtldrSim_packetSize != 0u)) ? I2C_Slave_I2C_SSTAT_WR_CMPLT : 0u;
+    pthread_mutex_unlock(&BtldrSim_lock);
+
+    return (status);
+}
+
+cystatus CyBtldrCommRead(uint8 pData[], uint16 size, uint16 *count, uint8 timeOut)
+{
+    if(BtldrSim_hostless != 0)
+    {
+        /* No host writes: the read times out */
+        BtldrSim_work += (double) timeOut * 10e-3;
+        BtldrSim_hostWait += (double) timeOut * 10e-3;
+        BtldrSim_polls++;
+        if(BtldrSim_polls >= BTLDR_SIM_MAX_POLLS)
+        {
+            /* Waits for a host without a time limit */
+            BtldrSim_launched = BTLDR_SIM_BOOTLOADER;
+            BtldrSim_Stop();
+        }
+        return (CYRET_TIMEOUT);
+    }
+
+    pthread_mutex_lock(&BtldrSim_lock);
+    BtldrSim_state = BTLDR_SIM_WAITING;
+    pthread_cond_broadcast(&BtldrSim_changed);
+    while((BtldrSim_packetSize == 0u) && (BtldrSim_closing == 0))
+    {
+        pthread_cond_wait(&BtldrSim_changed, &BtldrSim_lock);
+    }
+    if(BtldrSim_closing != 0)
+    {
+        pthread_mutex_unlock(&BtldrSim_lock);
+        BtldrSim_Stop();
+    }
+
+    *count = (BtldrSim_packetSize < size) ? BtldrSim_packetSize : size;
+    memcpy(pData, BtldrSim_packet, *count);
+    BtldrSim_packetSize = 0u;
+    BtldrSim_state = BTLDR_SIM_BUSY;
+    pthread_mutex_unlock(&BtldrSim_lock);
+
+    return (CYRET_SUCCESS);
+}
+
+cystatus CyBtldrCommWrite(const uint8 pData[], uint16 size, uint16 *count, uint8 timeOut)
+{
+    (void) timeOut;
+
+    pthread_mutex_lock(&BtldrSim_lock);
+    memcpy(BtldrSim_response, pData, size);
+    BtldrSim_responseSize = size;
+    *count = size;
+    pthread_mutex_unlock(&BtldrSim_lock);
+
+    return (CYRET_SUCCESS);
+}
+
+
+/***************************************
+*        Host side
+***************************************/
+
+/* Advances the clock over one transaction of size bytes */
+static void BtldrSim_Transfer(size_t size)
+{
+    double busTime = ((double)(size + 1u) * 9.0) / BtldrSim_timing.bitRate;
+
+    if(BtldrSim_stats.now < BtldrSim_busyUntil)
+    {
+        BtldrSim_stats.stallTime += BtldrSim_busyUntil - BtldrSim_stats.now;
+        BtldrSim_stats.now = BtldrSim_busyUntil;
+    }
+    BtldrSim_stats.now += BtldrSim_timing.overhead + busTime;
+    BtldrSim_stats.busTime += busTime;
+    BtldrSim_stats.busBytes += (uint32_t)(size + 1u);
+    BtldrSim_stats.transactions++;
+}
+
+static int BtldrSim_Write(void *context, const uint8_t *data, size_t size)
+{
+    int result = 0;
+
+    (void) context;
+
+    pthread_mutex_lock(&BtldrSim_lock);
+    if((BtldrSim_state == BTLDR_SIM_STOPPED) || (size > sizeof(BtldrSim_packet)))
+    {
+        /* The application does not answer; the bus buffer is full */
+        BtldrSim_Transfer(0u);
+        result = -1;
+    }
+    else
+    {
+        BtldrSim_Transfer(size);
+        memcpy(BtldrSim_packet, data, size);
+        BtldrSim_packetSize = (uint16) size;
+        BtldrSim_responseSize = 0u;
+        BtldrSim_work = (double) size * BtldrSim_timing.byteTime;
+        BtldrSim_state = BTLDR_SIM_BUSY;
+        pthread_cond_broadcast(&BtldrSim_changed);
+        while(BtldrSim_state == BTLDR_SIM_BUSY)
+        {
+            pthread_cond_wait(&BtldrSim_changed, &BtldrSim_lock);
+        }
+        BtldrSim_busyUntil = BtldrSim_stats.now + BtldrSim_work;
+    }
+    pthread_mutex_unlock(&BtldrSim_lock);
+
+    return (result);
+}
+
+static int BtldrSim_Read(void *context, uint8_t *data, size_t size)
+{
+    int result = -1;
+
+    (void) context;
+
+    pthread_mutex_lock(&BtldrSim_lock);
+    BtldrSim_Transfer((BtldrSim_responseSize != 0u) ? size : 0u);
+    if(BtldrSim_responseSize != 0u)
+    {
+        /* The slave buffer reads as 0xFF past the response */
+        memset(data, 0xFF, size);
+        memcpy(data, BtldrSim_response, (BtldrSim_responseSize < size) ? BtldrSim_responseSize : size);
+        BtldrSim_responseSize = 0u;
+        result = 0;
+    }
+    pthread_mutex_unlock(&BtldrSim_lock);
+
+    return (result);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrSim_Open
+********************************************************************************
+*
+* Summary:
+*  Starts the bootloader, as after a device reset, and the virtual clock at
+*  zero.
+*
+* Parameters:
+*  timing: Timing model, NULL selects BtldrSim_defaultTiming.
+*
+* Return:
+*  0 on success.
+*
+*******************************************************************************/
+int BtldrSim_Open(const BtldrSim_Timing *timing)
+{
+    BtldrSim_timing = (timing != NULL) ? *timing : BtldrSim_defaultTiming;
+    memset(&BtldrSim_stats, 0, sizeof(BtldrSim_stats));
+    BtldrSim_busyUntil = 0.0;
+    BtldrSim_work = 0.0;
+    BtldrSim_flashUntil = 0.0;
+    BtldrSim_runType = Bootloader_START_BTLDR;
+    BtldrSim_state = BTLDR_SIM_BUSY;
+    BtldrSim_closing = 0;
+    BtldrSim_packetSize = 0u;
+    BtldrSim_responseSize = 0u;
+
+    if(pthread_create(&BtldrSim_thread, NULL, &BtldrSim_Device, NULL) != 0)
+    {
+        return (-1);
+    }
+
+    /* Let the bootloader reach its first read */
+    pthread_mutex_lock(&BtldrSim_lock);
+    while(BtldrSim_state == BTLDR_SIM_BUSY)
+    {
+        pthread_cond_wait(&BtldrSim_changed, &BtldrSim_lock);
+    }
+    pthread_mutex_unlock(&BtldrSim_lock);
+
+    return (0);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrSim_Boot
+********************************************************************************
+*
+* Summary:
+*  Starts the device with no host on the bus, as after a reset, and follows
+*  the software resets of the bootloader until an application is launched.
+*  Call it while the device is closed. The code address of the application
+*  launched is kept for AppSlot_Running().
+*
+* Parameters:
+*  runType: Run type left by the application for a software reset, for
+*           example Bootloader_START_BTLDR by Bootloadable_Load(), or 0
+*           for a power-on, external or watchdog reset, which clears it.
+*
+* Return:
+*  BTLDR_SIM_APP_A or BTLDR_SIM_APP_B for the application launched, or
+*  BTLDR_SIM_BOOTLOADER if the bootloader waits for a host without a time
+*  limit, or BTLDR_SIM_RESETS if the start-up does not settle.
+*
+*******************************************************************************/
+int BtldrSim_Boot(uint8 runType)
+{
+    int launched = BTLDR_SIM_RESET;
+    int starts;
+
+    BtldrSim_timing = BtldrSim_defaultTiming;
+    BtldrSim_runType = runType;
+    BtldrSim_hostless = 1;
+    BtldrSim_hostWait = 0.0;
+
+    for(starts = 0; (starts < BTLDR_SIM_MAX_STARTS) && (launched == BTLDR_SIM_RESET); starts++)
+    {
+        /* CyBtldr_CheckLaunch() of the reset handler */
+        if(BtldrSim_runType == Bootloader_START_APP)
+        {
+            BtldrSim_runType = 0u;
+            launched = BTLDR_SIM_APP_A;
+        }
+        else
+        {
+            BtldrSim_launched = BTLDR_SIM_RESET;
+            BtldrSim_polls = 0u;
+            if(pthread_create(&BtldrSim_bootThread, NULL, &BtldrSim_Main, NULL) != 0)
+            {
+                break;
+            }
+            pthread_join(BtldrSim_bootThread, NULL);
+            launched = BtldrSim_launched;
+        }
+    }
+
+    BtldrSim_hostless = 0;
+    BtldrSim_codeAddr = CY_FLASH_BASE + ((uintptr_t) ((launched == BTLDR_SIM_APP_B) ? BTLDR_EXT_SLOT_B_ROW :
+                                                      BTLDR_EXT_FIRST_APP_ROW) * CY_FLASH_SIZEOF_ROW);
+
+    return ((launched == BTLDR_SIM_RESET) ? BTLDR_SIM_RESETS : launched);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrSim_HostWait
+********************************************************************************
+*
+* Summary:
+*  Reads the time the start-ups of the last BtldrSim_Boot() waited for a
+*  host before they launched an application or gave up.
+*
+* Return:
+*  The wait in seconds of device time, 0 for a launch without a wait.
+*
+*******************************************************************************/
+double BtldrSim_HostWait(void)
+{
+    return (BtldrSim_hostWait);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrSim_Watchdog
+********************************************************************************
+*
+* Summary:
+*  Reads the configuration of watchdog counter 0.
+*
+* Return:
+*  The time after which the counter resets the device, in seconds on the
+*  nominal 32 kHz ILO, or 0 if it does not.
+*
+*******************************************************************************/
+double BtldrSim_Watchdog(void)
+{
+    return ((((BtldrSim_wdtEnabled & CY_SYS_WDT_COUNTER0_MASK) != 0u) &&
+             (BtldrSim_wdtMode == CY_SYS_WDT_MODE_RESET)) ? ((double) BtldrSim_wdtMatch / 32000.0) : 0.0);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrSim_Close
+********************************************************************************
+*
+* Summary:
+*  Stops the bootloader thread.
+*
+*******************************************************************************/
+void BtldrSim_Close(void)
+{
+    pthread_mutex_lock(&BtldrSim_lock);
+    BtldrSim_closing = 1;
+    pthread_cond_broadcast(&BtldrSim_changed);
+    pthread_mutex_unlock(&BtldrSim_lock);
+
+    pthread_join(BtldrSim_thread, NULL);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrSim_Transport
+********************************************************************************
+*
+* Summary:
+*  Fills in the transport that talks to the simulated device.
+*
+*******************************************************************************/
+void BtldrSim_Transport(BtldrHost_Transport *transport)
+{
+    transport->context = NULL;
+    transport->write = &BtldrSim_Write;
+    transport->read = &BtldrSim_Read;
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrSim_GetStats
+********************************************************************************
+*
+* Summary:
+*  Reads the clock and the counters since BtldrSim_Open(). The clock includes
+*  the work the device has still to finish after the last transaction and
+*  the row write still in progress.
+*
+*******************************************************************************/
+void BtldrSim_GetStats(BtldrSim_Stats *stats)
+{
+    pthread_mutex_lock(&BtldrSim_lock);
+    *stats = BtldrSim_stats;
+    if(stats->now < BtldrSim_busyUntil)
+    {
+        stats->now = BtldrSim_busyUntil;
+    }
+    if(stats->now < BtldrSim_flashUntil)
+    {
+        stats->now = BtldrSim_flashUntil;
+    }
+    pthread_mutex_unlock(&BtldrSim_lock);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrSim_Clock
+********************************************************************************
+*
+* Summary:
+*  Reads the clock as BtldrSim_GetStats() does. The context is not used, so
+*  the function can serve as the clock of BtldrTune_Probe().
+*
+*******************************************************************************/
+double BtldrSim_Clock(void *context)
+{
+    BtldrSim_Stats stats;
+
+    (void) context;
+    BtldrSim_GetStats(&stats);
+
+    return (stats.now);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrSim_Sync
+********************************************************************************
+*
+* Summary:
+*  Moves the clock forward to now, the time on a bus the device shares with
+*  other devices, and returns the clock.
+*
+*******************************************************************************/
+double BtldrSim_Sync(double now)
+{
+    pthread_mutex_lock(&BtldrSim_lock);
+    if(BtldrSim_stats.now < now)
+    {
+        BtldrSim_stats.now = now;
+    }
+    now = BtldrSim_stats.now;
+    pthread_mutex_unlock(&BtldrSim_lock);
+
+    return (now);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrSim_Erase
+********************************************************************************
+*
+* Summary:
+*  Erases the whole simulated flash. Call it while the device is closed.
+*
+*******************************************************************************/
+void BtldrSim_Erase(void)
+{
+    memset(BtldrSim_flash, 0, sizeof(BtldrSim_flash));
+}
+
+
+/* [] END OF FILE */
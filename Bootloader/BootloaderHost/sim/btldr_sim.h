@@ -0,0 +1,75 @@
+/*******************************************************************************
+* File: btldr_sim.h
+*
+* Version: 1.0
+*
+* Description:
+*  Local stand-in for a CE95281 device on the I2C bus. Runs the extended host
+*  link of btldr_ext.c on the host against simulated flash, so the host tools
+*  can be exercised without hardware, and keeps a virtual clock of the time
+*  the exchange would take on a real bus and device.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#if !defined(BTLDR_SIM_H)
+#define BTLDR_SIM_H
+
+#include "btldr_host.h"
+
+typedef struct
+{
+    double bitRate;                     /* SCL frequency, Hz */
+    double overhead;                    /* adapter cost per transaction, s */
+    double rowErase;                    /* flash row erase time, s */
+    double rowProgram;                  /* flash row program time, s */
+    double byteTime;                    /* device time per byte received or programmed, s */
+} BtldrSim_Timing;
+
+typedef struct
+{
+    double   now;                       /* virtual time since BtldrSim_Open(), s */
+    double   busTime;                   /* time the bus carried bytes */
+    double   stallTime;                 /* time transactions waited for the device */
+    double   flashTime;                 /* time spent erasing and programming */
+    uint32_t transactions;
+    uint32_t busBytes;                  /* bytes on the bus, addresses included */
+    uint32_t rowWrites;
+} BtldrSim_Stats;
+
+/* Applications launched by the start-up of BtldrSim_Boot() */
+#define BTLDR_SIM_APP_A         (0)     /* the bootloadable, from slot A */
+#define BTLDR_SIM_APP_B         (1)     /* the application of slot B */
+#define BTLDR_SIM_BOOTLOADER    (2)     /* none: the bootloader waits for a host */
+#define BTLDR_SIM_RESETS        (3)     /* none: the start-up resets over and over */
+
+extern const BtldrSim_Timing BtldrSim_defaultTiming;
+
+/* Nonzero when btldr_ext.c was built with BTLDR_EXT_BACKGROUND_WRITE */
+extern const int BtldrSim_backgroundWrite;
+
+/* The firmware keeps its state in static variables: there is one simulated
+* device per process.
+*/
+int  BtldrSim_Open(const BtldrSim_Timing *timing);
+void BtldrSim_Close(void);
+void BtldrSim_Transport(BtldrHost_Transport *transport);
+void BtldrSim_GetStats(BtldrSim_Stats *stats);
+double BtldrSim_Clock(void *context);
+double BtldrSim_Sync(double now);
+void BtldrSim_Erase(void);
+int  BtldrSim_Boot(uint8_t runType);
+double BtldrSim_HostWait(void);
+double BtldrSim_Watchdog(void);
+
+#endif /* BTLDR_SIM_H */
+
+
+/* [] END OF FILE */
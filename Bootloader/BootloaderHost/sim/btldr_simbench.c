@@ -0,0 +1,487 @@
+/*******************************************************************************
+* File: btldr_simbench.c
+*
+* Version: 1.0
+*
+* Description:
+*  Update throughput of the CE95281 bootloader measured on the simulated
+*  device: the host tool code and the command handling of btldr_ext.c run
+*  unmodified, and the virtual clock of btldr_sim.c gives the time the update
+*  would take on the bus and flash of the timing model. For several image
+*  sizes, reports the end-to-end update time, the rows programmed per second,
+*  the protocol overhead as bus bytes per byte of row data (below 1 when the
+*  rows are compressed) and the share of the time spent in flash writes.
+*  Then breaks the link halfway through an update and reports the time the
+*  next update takes to complete the image, starting over or resuming from
+*  the progress journal, against the time of an uninterrupted update.
+*  Last, updates several devices at once with btldr_fleet.c, on one or more
+*  simulated buses, and reports the aggregate throughput against updating
+*  the devices one at a time. Finally, at several bit rates, probes the link
+*  and chooses the packet size and the rows per burst with btldr_tune.c, and
+*  compares the update time of the choice with the best of a grid of sizes.
+*
+*  Build: gcc -O2 -pthread -I. -Isim -I"../CE95281 - Bootloader Project with
+*         PSoC 4/CE95281.cydsn" -o btldr_simbench sim/btldr_simbench.c
+*         sim/btldr_sim.c sim/btldr_simbus.c btldr_fleet.c btldr_image.c
+*         btldr_host.c btldr_crc.c btldr_tune.c btldr_lz.c cyacd.c
+*         "../CE95281 - Bootloader Project with PSoC 4/CE95281.cydsn/btldr_ext.c"
+*         Add -DBTLDR_EXT_BACKGROUND_WRITE=1 to measure the bootloader that
+*         programs the rows of a burst while it receives the next one.
+*  Usage: btldr_simbench [bit rate, Hz] [adapter overhead, us] [row erase, us]
+*                        [row program, us]
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "btldr_fleet.h"
+#include "btldr_simbus.h"
+#include "btldr_tune.h"
+
+#define SIMBENCH_ROW_SIZE       (128u)
+#define SIMBENCH_FIRST_ROW      (64u)
+#define SIMBENCH_META_ROW       (255u)
+#define SIMBENCH_SILICON_ID     (0x04C81193u)
+#define SIMBENCH_MAX_BUSES      (4u)
+#define SIMBENCH_MAX_DEVICES    (8u)
+
+typedef struct
+{
+    const char        *name;
+    BtldrImage_Options options;
+    int                changedRows;     /* 0: erased device, else rows changed since the last update */
+} SimBench_Case;
+
+typedef struct
+{
+    uint16_t buses;
+    uint16_t devicesPerBus;
+} SimBench_Fleet;
+
+/* Transport that fails every transaction after a given number, as a link
+* that drops or a device that loses power
+*/
+typedef struct
+{
+    BtldrHost_Transport device;
+    uint32_t            left;           /* transactions before the drop */
+} SimBench_Drop;
+
+/* Thumb-like code, then constant tables, then zero filled rows. The last
+* row is the metadata row of the bootloadable.
+*/
+static void SimBench_MakeImage(Cyacd_Image *image, uint8_t *storage, Cyacd_Row *rows, uint16_t appRows)
+{
+    static const uint8_t opcodes[] = {0x68u, 0x60u, 0x1Cu, 0x42u, 0xD0u, 0xD1u, 0xF0u, 0xF7u,
+                                      0x46u, 0x20u, 0x2Bu, 0x4Bu, 0xBDu, 0xB5u, 0x18u, 0x70u};
+    size_t size = (size_t) appRows * SIMBENCH_ROW_SIZE;
+    uint32_t seed = 12345u;
+    size_t codeEnd = (size * 5u) / 8u;
+    size_t tableEnd = (size * 7u) / 8u;
+    size_t i;
+
+    memset(storage, 0, size + SIMBENCH_ROW_SIZE);
+    for(i = 0u; i < codeEnd; i += 2u)
+    {
+        seed = (seed * 1103515245u) + 12345u;
+        storage[i] = (uint8_t)((seed >> 16) & 0x1Fu);
+        storage[i + 1u] = opcodes[(seed >> 24) & 0x0Fu];
+    }
+    for(i = codeEnd; i < tableEnd; i += 4u)
+    {
+        storage[i] = (uint8_t)((i - codeEnd) / 4u);
+        storage[i + 1u] = 0x10u;
+        storage[i + 2u] = 0x00u;
+        storage[i + 3u] = 0x20u;
+    }
+    memset(&storage[size], 0xA5, SIMBENCH_ROW_SIZE);
+
+    for(i = 0u; i <= appRows; i++)
+    {
+        rows[i].arrayId = 0u;
+        rows[i].row = (uint16_t)((i < appRows) ? (SIMBENCH_FIRST_ROW + i) : SIMBENCH_META_ROW);
+        rows[i].size = SIMBENCH_ROW_SIZE;
+        rows[i].data = &storage[i * SIMBENCH_ROW_SIZE];
+    }
+
+    memset(image, 0, sizeof(*image));
+    image->siliconId = SIMBENCH_SILICON_ID;
+    image->rowCount = (size_t) appRows + 1u;
+    image->rows = rows;
+    image->storage = storage;
+}
+
+static int SimBench_DropWrite(void *context, const uint8_t *data, size_t size)
+{
+    SimBench_Drop *drop = (SimBench_Drop *) context;
+
+    if(drop->left == 0u)
+    {
+        return (-1);
+    }
+    drop->left--;
+
+    return (drop->device.write(drop->device.context, data, size));
+}
+
+static int SimBench_DropRead(void *context, uint8_t *data, size_t size)
+{
+    SimBench_Drop *drop = (SimBench_Drop *) context;
+
+    if(drop->left == 0u)
+    {
+        return (-1);
+    }
+    drop->left--;
+
+    return (drop->device.read(drop->device.context, data, size));
+}
+
+/* One update session on the simulated device, from reset to Exit or to the
+* drop of the link after dropAfter transactions (0 never drops)
+*/
+static int SimBench_Update(const BtldrSim_Timing *timing, const Cyacd_Image *image,
+                           const BtldrImage_Options *options, BtldrImage_Stats *stats, BtldrSim_Stats *simStats,
+                           size_t packetSize, uint32_t dropAfter)
+{
+    BtldrHost_Transport transport;
+    SimBench_Drop drop;
+    BtldrHost_Link link;
+    int result;
+
+    if(BtldrSim_Open(timing) != 0)
+    {
+        return (BTLDR_HOST_ERR_COMM);
+    }
+    BtldrSim_Transport(&drop.device);
+    drop.left = (dropAfter != 0u) ? dropAfter : UINT32_MAX;
+    transport.context = &drop;
+    transport.write = &SimBench_DropWrite;
+    transport.read = &SimBench_DropRead;
+    link.transport = &transport;
+    link.packetSize = packetSize;
+    link.rowSize = SIMBENCH_ROW_SIZE;
+
+    result = BtldrImage_Update(&link, image, options, stats);
+    if(result == BTLDR_HOST_SUCCESS)
+    {
+        result = BtldrHost_Exit(&link);
+    }
+    BtldrSim_GetStats(simStats);
+    BtldrSim_Close();
+
+    return (result);
+}
+
+static void SimBench_Run(const BtldrSim_Timing *timing, const SimBench_Case *test, Cyacd_Image *image)
+{
+    BtldrImage_Options full = {16u, 0, 0, 0, 0};
+    BtldrImage_Stats stats;
+    BtldrSim_Stats simStats;
+    double payload;
+    int result;
+    int i;
+
+    BtldrSim_Erase();
+    if(test->changedRows != 0)
+    {
+        /* Install the image, then change rows spread over the code */
+        (void) SimBench_Update(timing, image, &full, &stats, &simStats, BTLDR_HOST_MAX_PACKET, 0u);
+        for(i = 0; i < test->changedRows; i++)
+        {
+            image->rows[((size_t) i * (image->rowCount - 1u)) / (size_t) test->changedRows].data[7] ^= 0x5Au;
+        }
+    }
+
+    result = SimBench_Update(timing, image, &test->options, &stats, &simStats, BTLDR_HOST_MAX_PACKET, 0u);
+    payload = (double) stats.rowsSent * SIMBENCH_ROW_SIZE;
+
+    printf("  %-21s%4zu rows sent %8.3f s %7.1f rows/s %5.2f bus bytes/byte %5.1f%% flash %6.2f transactions/row%s\n",
+           test->name, stats.rowsSent, simStats.now,
+           (simStats.now > 0.0) ? ((double) stats.rowsSent / simStats.now) : 0.0,
+           (payload > 0.0) ? ((double) simStats.busBytes / payload) : 0.0,
+           (simStats.now > 0.0) ? (100.0 * simStats.flashTime / simStats.now) : 0.0,
+           (stats.rowsSent != 0u) ? ((double) simStats.transactions / (double) stats.rowsSent) : 0.0,
+           (result == BTLDR_HOST_SUCCESS) ? "" : "  FAILED");
+}
+
+/* Breaks the link halfway through an update of an erased device, then
+* completes the image with a second update
+*/
+static void SimBench_Recover(const BtldrSim_Timing *timing, const SimBench_Case *test, const Cyacd_Image *image)
+{
+    BtldrImage_Stats stats;
+    BtldrSim_Stats simStats;
+    double whole;
+    int result;
+
+    BtldrSim_Erase();
+    result = SimBench_Update(timing, image, &test->options, &stats, &simStats, BTLDR_HOST_MAX_PACKET, 0u);
+    whole = simStats.now;
+
+    BtldrSim_Erase();
+    (void) SimBench_Update(timing, image, &test->options, &stats, &simStats, BTLDR_HOST_MAX_PACKET,
+                           simStats.transactions / 2u);
+    if(result == BTLDR_HOST_SUCCESS)
+    {
+        result = SimBench_Update(timing, image, &test->options, &stats, &simStats, BTLDR_HOST_MAX_PACKET, 0u);
+    }
+
+    printf("  %-21s%4zu rows sent %8.3f s, %3.0f%% of an uninterrupted update%s\n",
+           test->name, stats.rowsSent, simStats.now, (whole > 0.0) ? (100.0 * simStats.now / whole) : 0.0,
+           (result == BTLDR_HOST_SUCCESS) ? "" : "  FAILED");
+}
+
+/* Updates the erased devices of every bus at once. single is the time the
+* update of one device takes on its own.
+*/
+static void SimBench_RunFleet(const BtldrSim_Timing *timing, const SimBench_Fleet *fleet, const Cyacd_Image *image,
+                              const BtldrImage_Options *options, double single)
+{
+    BtldrSimBus buses[SIMBENCH_MAX_BUSES];
+    BtldrFleet_Bus fleetBuses[SIMBENCH_MAX_BUSES];
+    BtldrFleet_Target targets[SIMBENCH_MAX_BUSES * SIMBENCH_MAX_DEVICES];
+    BtldrHost_Transport transports[SIMBENCH_MAX_BUSES * SIMBENCH_MAX_DEVICES];
+    BtldrSim_Stats simStats;
+    uint16_t opened = 0u;
+    size_t devices = (size_t) fleet->buses * fleet->devicesPerBus;
+    size_t rowsSent = 0u;
+    size_t n = 0u;
+    double end = 0.0;
+    uint16_t b;
+    uint16_t d;
+    int result = BTLDR_HOST_ERR_COMM;
+
+    while((opened < fleet->buses) && (BtldrSimBus_Open(&buses[opened], fleet->devicesPerBus, timing) == 0))
+    {
+        fleetBuses[opened].targets = &targets[n];
+        fleetBuses[opened].targetCount = fleet->devicesPerBus;
+        fleetBuses[opened].clock = &BtldrSimBus_Clock;
+        fleetBuses[opened].clockContext = &buses[opened];
+        for(d = 0u; d < fleet->devicesPerBus; d++)
+        {
+            BtldrSimBus_Transport(&buses[opened], d, &transports[n]);
+            targets[n].link.transport = &transports[n];
+            targets[n].link.packetSize = BTLDR_HOST_MAX_PACKET;
+            targets[n].link.rowSize = SIMBENCH_ROW_SIZE;
+            targets[n].image = image;
+            n++;
+        }
+        opened++;
+    }
+
+    if(opened == fleet->buses)
+    {
+        result = BtldrFleet_Update(fleetBuses, fleet->buses, options, timing->rowErase + timing->rowProgram);
+    }
+
+    n = 0u;
+    for(b = 0u; b < opened; b++)
+    {
+        for(d = 0u; d < fleet->devicesPerBus; d++)
+        {
+            if((BtldrSimBus_GetStats(&buses[b], d, &simStats) == 0) && (simStats.now > end))
+            {
+                end = simStats.now;
+            }
+            rowsSent += targets[n++].stats.rowsSent;
+        }
+        BtldrSimBus_Close(&buses[b]);
+    }
+
+    printf("  %u bus%s x %u device%s %8.3f s %7.1f rows/s %5.2fx updating one at a time%s\n",
+           fleet->buses, (fleet->buses > 1u) ? "es" : "  ", fleet->devicesPerBus,
+           (fleet->devicesPerBus > 1u) ? "s" : " ", end, (end > 0.0) ? ((double) rowsSent / end) : 0.0,
+           (end > 0.0) ? (((double) devices * single) / end) : 0.0,
+           (result == BTLDR_HOST_SUCCESS) ? "" : "  FAILED");
+}
+
+/* Raw update of an erased device with a packet size and a burst size */
+static double SimBench_Time(const BtldrSim_Timing *timing, const Cyacd_Image *image, size_t packetSize,
+                            uint16_t rowsPerBurst)
+{
+    BtldrImage_Options options = {rowsPerBurst, 0, 0, 0, 0};
+    BtldrImage_Stats stats;
+    BtldrSim_Stats simStats;
+
+    BtldrSim_Erase();
+    if(SimBench_Update(timing, image, &options, &stats, &simStats, packetSize, 0u) != BTLDR_HOST_SUCCESS)
+    {
+        return (-1.0);
+    }
+
+    return (simStats.now);
+}
+
+/* Probes the simulated link, chooses the packet size and the rows per burst
+* from the model, and checks the choice against the sizes of a grid
+*/
+static void SimBench_Tune(const BtldrSim_Timing *timing, const Cyacd_Image *image)
+{
+    static const size_t packetSizes[] = {16u, 32u, 48u, 64u};
+    static const uint16_t bursts[] = {0u, 1u, 4u, 16u, 64u, 256u};
+    BtldrTune_Model model = BtldrTune_defaultModel;
+    BtldrTune_Choice choice;
+    BtldrHost_Transport transport;
+    BtldrHost_Link link;
+    double chosen;
+    double best = -1.0;
+    double time;
+    size_t bestPacket = 0u;
+    uint16_t bestBurst = 0u;
+    size_t i;
+    size_t j;
+    int result = BTLDR_HOST_ERR_COMM;
+
+    model.rowTime = timing->rowErase + timing->rowProgram;
+    model.background = BtldrSim_backgroundWrite;
+
+    BtldrSim_Erase();
+    if(BtldrSim_Open(timing) == 0)
+    {
+        BtldrSim_Transport(&transport);
+        link.transport = &transport;
+        link.packetSize = BTLDR_HOST_MAX_PACKET;
+        link.rowSize = SIMBENCH_ROW_SIZE;
+        result = BtldrTune_Probe(&link, &BtldrSim_Clock, NULL, &model);
+        BtldrSim_Close();
+    }
+    if(result != BTLDR_HOST_SUCCESS)
+    {
+        printf("  %7.0f Hz: probe FAILED (%d)\n", timing->bitRate, result);
+        return;
+    }
+
+    BtldrTune_Choose(&model, SIMBENCH_ROW_SIZE, image->rowCount, BTLDR_HOST_MAX_PACKET, &choice);
+    chosen = SimBench_Time(timing, image, choice.packetSize, choice.rowsPerBurst);
+
+    for(i = 0u; i < (sizeof(packetSizes) / sizeof(packetSizes[0])); i++)
+    {
+        for(j = 0u; j < (sizeof(bursts) / sizeof(bursts[0])); j++)
+        {
+            time = SimBench_Time(timing, image, packetSizes[i], bursts[j]);
+            if((time >= 0.0) && ((best < 0.0) || (time < best)))
+            {
+                best = time;
+                bestPacket = packetSizes[i];
+                bestBurst = bursts[j];
+            }
+        }
+    }
+
+    printf("  %7.0f Hz: probed %4.0f us + %5.1f us/byte, chose %2zu bytes x %3u rows: model %6.3f s, "
+           "measured %6.3f s; best of grid %2zu x %3u: %6.3f s%s\n",
+           timing->bitRate, model.overhead * 1e6, model.byteTime * 1e6, choice.packetSize,
+           choice.rowsPerBurst, choice.estimate, chosen, bestPacket, bestBurst, best,
+           ((chosen < 0.0) || (best < 0.0)) ? "  FAILED" : "");
+}
+
+int main(int argc, char *argv[])
+{
+    static const uint16_t sizes[] = {16u, 64u, 160u};
+    static const SimBench_Case cases[] =
+    {
+        {"one row per command",   {0u,  0, 0, 0, 0}, 0},
+        {"burst of 16 raw",       {16u, 0, 0, 0, 0}, 0},
+        {"burst of 16 lz",        {16u, 0, 1, 0, 0}, 0},
+        {"lz with journal",       {16u, 0, 1, 1, 0}, 0},
+        {"full, 4 rows changed",  {16u, 0, 1, 0, 0}, 4},
+        {"delta, 4 rows changed", {16u, 1, 1, 0, 0}, 4},
+    };
+    static const SimBench_Case recoveries[] =
+    {
+        {"start over",            {16u, 0, 1, 0, 0}, 0},
+        {"start over, delta",     {16u, 1, 1, 0, 0}, 0},
+        {"resume from journal",   {16u, 0, 1, 1, 0}, 0},
+        {"resume, delta",         {16u, 1, 1, 1, 0}, 0},
+    };
+    static const SimBench_Fleet fleets[] =
+    {
+        {1u, 1u}, {1u, 2u}, {1u, 4u}, {1u, 8u}, {2u, 4u}, {4u, 4u},
+    };
+    static const double bitRates[] = {100000.0, 400000.0, 1000000.0};
+    BtldrImage_Stats stats;
+    BtldrSim_Stats simStats;
+    BtldrSim_Timing timing = BtldrSim_defaultTiming;
+    BtldrSim_Timing tuned;
+    Cyacd_Image image;
+    Cyacd_Row *rows;
+    uint8_t *storage;
+    size_t i;
+    size_t j;
+
+    timing.bitRate = (argc > 1) ? atof(argv[1]) : timing.bitRate;
+    timing.overhead = (argc > 2) ? (atof(argv[2]) * 1e-6) : timing.overhead;
+    timing.rowErase = (argc > 3) ? (atof(argv[3]) * 1e-6) : timing.rowErase;
+    timing.rowProgram = (argc > 4) ? (atof(argv[4]) * 1e-6) : timing.rowProgram;
+
+    rows = calloc((size_t) sizes[2] + 1u, sizeof(Cyacd_Row));
+    storage = malloc(((size_t) sizes[2] + 1u) * SIMBENCH_ROW_SIZE);
+    if((rows == NULL) || (storage == NULL))
+    {
+        free(rows);
+        free(storage);
+        return (1);
+    }
+
+    printf("bus %.0f Hz, adapter overhead %.0f us, row erase %.0f us, row program %.0f us, packet %u bytes, "
+           "burst rows programmed %s\n", timing.bitRate, timing.overhead * 1e6, timing.rowErase * 1e6,
+           timing.rowProgram * 1e6, BTLDR_HOST_MAX_PACKET,
+           (BtldrSim_backgroundWrite != 0) ? "in the background" : "as they complete");
+    for(i = 0u; i < (sizeof(sizes) / sizeof(sizes[0])); i++)
+    {
+        printf("image of %u rows and the metadata row\n", sizes[i]);
+        for(j = 0u; j < (sizeof(cases) / sizeof(cases[0])); j++)
+        {
+            SimBench_MakeImage(&image, storage, rows, sizes[i]);
+            SimBench_Run(&timing, &cases[j], &image);
+        }
+    }
+
+    printf("recovery after the link drops halfway through the update\n");
+    for(i = 0u; i < (sizeof(sizes) / sizeof(sizes[0])); i++)
+    {
+        printf("image of %u rows and the metadata row\n", sizes[i]);
+        SimBench_MakeImage(&image, storage, rows, sizes[i]);
+        for(j = 0u; j < (sizeof(recoveries) / sizeof(recoveries[0])); j++)
+        {
+            SimBench_Recover(&timing, &recoveries[j], &image);
+        }
+    }
+
+    printf("several devices updated at once, image of %u rows and the metadata row, %s\n", sizes[2],
+           cases[2].name);
+    SimBench_MakeImage(&image, storage, rows, sizes[2]);
+    BtldrSim_Erase();
+    (void) SimBench_Update(&timing, &image, &cases[2].options, &stats, &simStats, BTLDR_HOST_MAX_PACKET, 0u);
+    for(i = 0u; i < (sizeof(fleets) / sizeof(fleets[0])); i++)
+    {
+        SimBench_RunFleet(&timing, &fleets[i], &image, &cases[2].options, simStats.now);
+    }
+
+    printf("packet size and rows per burst chosen from the probed model, image of %u rows and the metadata row, "
+           "raw\n", sizes[2]);
+    for(i = 0u; i < (sizeof(bitRates) / sizeof(bitRates[0])); i++)
+    {
+        tuned = timing;
+        tuned.bitRate = bitRates[i];
+        SimBench_Tune(&tuned, &image);
+    }
+
+    free(rows);
+    free(storage);
+
+    return (0);
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,322 @@
+/*******************************************************************************
+* File: btldr_simboot.c
+*
+* Version: 1.0
+*
+* Description:
+*  Checks the start-up of the bootloader of btldr_ext.c on the simulated
+*  device, with CyBtldr_CheckLaunch() of the reset handler modelled by
+*  BtldrSim_Boot(): which application each start launches, what slot A
+*  holds and whether the watchdog is armed for a probation.
+*
+*  With BTLDR_EXT_PROBATION_TIME set, a new image staged in slot B is
+*  swapped in and launched with the watchdog armed. One that confirms its
+*  health stays; one that never does is swapped back out at the start that
+*  follows the watchdog reset.
+*
+*  With BTLDR_EXT_MULTI_APP set, the application resident in slot B is
+*  started in place when the select record chooses it, and slot A when it
+*  does not or slot B holds no application.
+*
+*  The images are staged, selected and confirmed by app_slot.c of the
+*  CE95280 bootloadable, built for the simulated device.
+*
+*  A host that writes or erases a row without the Enter command must still
+*  drop the validity record, so a partly written image is not launched.
+*
+*  The host link must refuse a range of rows that runs over the record rows
+*  or past the last row, before it writes any row or reads any hash.
+*
+*  Build: gcc -O2 -pthread -I. -Isim -I"../CE95281 - Bootloader Project with
+*         PSoC 4/CE95281.cydsn" -I"../CE95280 - Bootloadable Project with
+*         PSoC 4/CE95280.cydsn" -o btldr_simboot sim/btldr_simboot.c
+*         sim/btldr_sim.c btldr_host.c btldr_crc.c btldr_tune.c btldr_lz.c
+*         "../CE95281 - Bootloader Project with PSoC 4/CE95281.cydsn/btldr_ext.c"
+*         "../CE95280 - Bootloadable Project with PSoC 4/CE95280.cydsn/app_slot.c"
+*         Add -DBTLDR_EXT_PROBATION_TIME=0u or -DBTLDR_EXT_MULTI_APP=1u to
+*         check the other start-ups.
+*  Usage: btldr_simboot
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <stdio.h>
+#include <string.h>
+#include "btldr_sim.h"
+#include "btldr_ext.h"
+#include "app_slot.h"
+
+#define SIMBOOT_IMAGE_ROWS      (16u)
+#define SIMBOOT_OLD_IMAGE       (1u)
+#define SIMBOOT_NEW_IMAGE       (2u)
+
+static const char *const SimBoot_apps[] = { "slot A", "slot B", "bootloader", "resets" };
+
+static unsigned SimBoot_failures;
+static BtldrHost_Transport SimBoot_transport;
+static BtldrHost_Link SimBoot_link;
+
+/* Row of a test image: every byte tells the image and the row */
+static void SimBoot_Row(uint8_t image, uint16_t row, uint8_t rowData[])
+{
+    uint16_t i;
+
+    for(i = 0u; i < CY_FLASH_SIZEOF_ROW; i++)
+    {
+        rowData[i] = (uint8_t) ((image * 61u) + (row * 7u) + i + 1u);
+    }
+}
+
+static void SimBoot_Write(uint16_t row, const uint8_t rowData[])
+{
+    memcpy(&BtldrSim_flash[row * CY_FLASH_SIZEOF_ROW], rowData, CY_FLASH_SIZEOF_ROW);
+}
+
+#if (BTLDR_EXT_MULTI_APP != 0u)
+static void SimBoot_Clear(uint16_t row)
+{
+    memset(&BtldrSim_flash[row * CY_FLASH_SIZEOF_ROW], 0, CY_FLASH_SIZEOF_ROW);
+}
+#endif /* (BTLDR_EXT_MULTI_APP != 0u) */
+
+/* Programs an image into slot A, as a host update leaves it */
+static void SimBoot_Install(uint8_t image)
+{
+    uint8_t rowData[CY_FLASH_SIZEOF_ROW];
+    uint16_t row;
+
+    for(row = 0u; row <= SIMBOOT_IMAGE_ROWS; row++)
+    {
+        SimBoot_Row(image, row, rowData);
+        SimBoot_Write((row < SIMBOOT_IMAGE_ROWS) ? (BTLDR_EXT_FIRST_APP_ROW + row) : BTLDR_EXT_META_ROW, rowData);
+    }
+}
+
+/* Reports whether a record row holds the record */
+static int SimBoot_HasRecord(uint16_t row, uint32_t magic)
+{
+    return ((*(const uint32_t *) &BtldrSim_flash[row * CY_FLASH_SIZEOF_ROW] == magic) ? 1 : 0);
+}
+
+/* Reports whether slot A holds the image */
+static int SimBoot_Holds(uint8_t image)
+{
+    uint8_t rowData[CY_FLASH_SIZEOF_ROW];
+    uint16_t row;
+    int holds = 1;
+
+    for(row = 0u; row <= SIMBOOT_IMAGE_ROWS; row++)
+    {
+        SimBoot_Row(image, row, rowData);
+        holds &= (memcmp(&BtldrSim_flash[((row < SIMBOOT_IMAGE_ROWS) ? (BTLDR_EXT_FIRST_APP_ROW + row) :
+                                          BTLDR_EXT_META_ROW) * CY_FLASH_SIZEOF_ROW],
+                         rowData, CY_FLASH_SIZEOF_ROW) == 0);
+    }
+
+    return (holds);
+}
+
+/* Starts the device and checks the application launched, the image of
+* slot A, 0 for neither image, and the watchdog
+*/
+static void SimBoot_Expect(const char *step, uint8_t runType, int app, uint8_t image, int armed)
+{
+    int launched = BtldrSim_Boot(runType);
+    double watchdog = BtldrSim_Watchdog();
+    uint8_t held = (SimBoot_Holds(SIMBOOT_NEW_IMAGE) != 0) ? SIMBOOT_NEW_IMAGE :
+                   ((SimBoot_Holds(SIMBOOT_OLD_IMAGE) != 0) ? SIMBOOT_OLD_IMAGE : 0u);
+    int pass = (launched == app) && (held == image) && ((watchdog != 0.0) == (armed != 0));
+
+    printf("  %-4s %-40s %-10s image %u, watchdog %s\n", (pass != 0) ? "ok" : "FAIL", step, SimBoot_apps[launched],
+           held, (watchdog != 0.0) ? "armed" : "off");
+    if(pass == 0)
+    {
+        SimBoot_failures++;
+    }
+}
+
+/* Reports the result of a host command */
+static void SimBoot_Check(const char *step, int result, int expected)
+{
+    printf("  %-4s %-40s status 0x%02X\n", (result == expected) ? "ok" : "FAIL", step, (unsigned) result);
+    if(result != expected)
+    {
+        SimBoot_failures++;
+    }
+}
+
+/* Receives an image into slot B through the slot API of the bootloadable */
+static void SimBoot_Stage(uint8_t image)
+{
+    uint8_t rowData[CY_FLASH_SIZEOF_ROW];
+    uint32_t hash = APP_SLOT_HASH_INIT;
+    uint16_t row;
+    uint8_t status;
+
+    status = AppSlot_Begin();
+    for(row = 0u; (row <= SIMBOOT_IMAGE_ROWS) && (status == APP_SLOT_SUCCESS); row++)
+    {
+        SimBoot_Row(image, row, rowData);
+#if (APP_SLOT_MULTI_APP != 0u)
+        /* A second application is linked to run in slot B */
+        status = AppSlot_WriteRow((row < SIMBOOT_IMAGE_ROWS) ? (BTLDR_EXT_SLOT_B_ROW + row) : BTLDR_EXT_META_ROW,
+                                  rowData);
+#else
+        status = AppSlot_WriteRow((row < SIMBOOT_IMAGE_ROWS) ? (BTLDR_EXT_FIRST_APP_ROW + row) : BTLDR_EXT_META_ROW,
+                                  rowData);
+#endif /* (APP_SLOT_MULTI_APP != 0u) */
+        hash = AppSlot_Hash(hash, rowData, CY_FLASH_SIZEOF_ROW);
+    }
+    if(status == APP_SLOT_SUCCESS)
+    {
+        status = AppSlot_Commit(SIMBOOT_IMAGE_ROWS, hash);
+    }
+
+    SimBoot_Check("AppSlot_Commit()", status, APP_SLOT_SUCCESS);
+}
+
+/* Starts the bootloader with a host on the bus */
+static void SimBoot_Open(void)
+{
+    (void) BtldrSim_Open(NULL);
+    BtldrSim_Transport(&SimBoot_transport);
+    SimBoot_link.transport = &SimBoot_transport;
+    SimBoot_link.packetSize = BTLDR_HOST_MAX_PACKET;
+    SimBoot_link.rowSize = CY_FLASH_SIZEOF_ROW;
+}
+
+/* Opens a burst and reads its status before any row data is sent */
+static int SimBoot_Burst(uint16_t firstRow, uint16_t rowCount)
+{
+    uint8_t data[6];
+    uint16_t rowsDone;
+    int result;
+
+    data[0] = 0u;
+    data[1] = (uint8_t) firstRow;
+    data[2] = (uint8_t) (firstRow >> 8);
+    data[3] = (uint8_t) rowCount;
+    data[4] = (uint8_t) (rowCount >> 8);
+    data[5] = BTLDR_HOST_ENCODING_RAW;
+
+    result = BtldrHost_Post(&SimBoot_link, BTLDR_HOST_CMD_PROGRAM_ROWS, data, sizeof(data));
+    if(result == BTLDR_HOST_SUCCESS)
+    {
+        result = BtldrHost_GetRowsDone(&SimBoot_link, &rowsDone);
+    }
+
+    return (result);
+}
+
+int main(void)
+{
+    uint32_t hashes[BTLDR_HOST_MAX_HASHES];
+    uint8_t rowData[CY_FLASH_SIZEOF_ROW];
+    uint8_t eraseData[3];
+
+    BtldrSim_Erase();
+    SimBoot_Install(SIMBOOT_OLD_IMAGE);
+
+    printf("cold start\n");
+    SimBoot_Expect("power on", 0u, BTLDR_SIM_APP_A, SIMBOOT_OLD_IMAGE, 0);
+    Bootloadable_Load();
+    SimBoot_Expect("Bootloadable_Load(), no host", Bootloader_GET_RUN_TYPE, BTLDR_SIM_APP_A, SIMBOOT_OLD_IMAGE, 0);
+    SimBoot_Check("waited for a host", (BtldrSim_HostWait() != 0.0) ? 0 : 1, 0);
+
+    printf("host link without Enter\n");
+    SimBoot_Open();
+    SimBoot_Row(SIMBOOT_NEW_IMAGE, 0u, rowData);
+    SimBoot_Check("PROGRAM_ROW of the first row",
+                  BtldrHost_ProgramRow(&SimBoot_link, 0u, BTLDR_EXT_FIRST_APP_ROW, rowData), BTLDR_HOST_SUCCESS);
+    BtldrSim_Close();
+    SimBoot_Check("validity record left", SimBoot_HasRecord(BTLDR_EXT_VALID_ROW, BTLDR_EXT_VALID_MAGIC), 0);
+    SimBoot_Open();
+    eraseData[0] = 0u;
+    eraseData[1] = (uint8_t) BTLDR_EXT_FIRST_APP_ROW;
+    eraseData[2] = (uint8_t) (BTLDR_EXT_FIRST_APP_ROW >> 8);
+    SimBoot_Check("ERASE_ROW of the first row",
+                  BtldrHost_Command(&SimBoot_link, BTLDR_HOST_CMD_ERASE_ROW, eraseData, sizeof(eraseData), NULL, 0u),
+                  BTLDR_HOST_SUCCESS);
+    BtldrSim_Close();
+    SimBoot_Expect("power on, first row erased", 0u, BTLDR_SIM_BOOTLOADER, 0u, 0);
+    SimBoot_Install(SIMBOOT_OLD_IMAGE);
+    SimBoot_Expect("power on, image programmed again", 0u, BTLDR_SIM_APP_A, SIMBOOT_OLD_IMAGE, 0);
+
+#if (BTLDR_EXT_MULTI_APP != 0u)
+    printf("application resident in slot B\n");
+    SimBoot_Stage(SIMBOOT_NEW_IMAGE);
+    SimBoot_Expect("power on, none selected", 0u, BTLDR_SIM_APP_A, SIMBOOT_OLD_IMAGE, 0);
+    SimBoot_Check("AppSlot_Select(APP_SLOT_APP_B)", AppSlot_Select(APP_SLOT_APP_B), APP_SLOT_SUCCESS);
+    SimBoot_Expect("software reset after the select", Bootloader_GET_RUN_TYPE, BTLDR_SIM_APP_B, SIMBOOT_OLD_IMAGE, 0);
+    SimBoot_Check("no wait for a host", (BtldrSim_HostWait() != 0.0) ? 1 : 0, 0);
+    SimBoot_Expect("power on", 0u, BTLDR_SIM_APP_B, SIMBOOT_OLD_IMAGE, 0);
+    SimBoot_Check("AppSlot_Running() from slot B", AppSlot_Running(), APP_SLOT_APP_B);
+    SimBoot_Check("AppSlot_Begin() from slot B", AppSlot_Begin(), APP_SLOT_ERR_APP);
+    SimBoot_Check("AppSlot_Select(APP_SLOT_APP_A)", AppSlot_Select(APP_SLOT_APP_A), APP_SLOT_SUCCESS);
+    SimBoot_Expect("software reset after the select", Bootloader_GET_RUN_TYPE, BTLDR_SIM_APP_A, SIMBOOT_OLD_IMAGE, 0);
+    SimBoot_Check("no wait for a host", (BtldrSim_HostWait() != 0.0) ? 1 : 0, 0);
+    SimBoot_Check("AppSlot_Select(APP_SLOT_APP_B)", AppSlot_Select(APP_SLOT_APP_B), APP_SLOT_SUCCESS);
+    /* As a host that programs a row of slot B leaves it */
+    SimBoot_Clear(BTLDR_EXT_SLOT_RECORD_ROW);
+    SimBoot_Expect("power on, slot B removed", 0u, BTLDR_SIM_APP_A, SIMBOOT_OLD_IMAGE, 0);
+#elif (BTLDR_EXT_PROBATION_TIME != 0u)
+    printf("probation of %u ms, new image never confirms\n", BTLDR_EXT_PROBATION_TIME);
+    SimBoot_Stage(SIMBOOT_NEW_IMAGE);
+    AppSlot_Install();
+    SimBoot_Expect("AppSlot_Install()", Bootloader_GET_RUN_TYPE, BTLDR_SIM_APP_A, SIMBOOT_NEW_IMAGE, 1);
+    SimBoot_Expect("watchdog reset", 0u, BTLDR_SIM_APP_A, SIMBOOT_OLD_IMAGE, 0);
+    SimBoot_Expect("power on", 0u, BTLDR_SIM_APP_A, SIMBOOT_OLD_IMAGE, 0);
+
+    printf("probation of %u ms, power lost before the new image ran\n", BTLDR_EXT_PROBATION_TIME);
+    SimBoot_Stage(SIMBOOT_NEW_IMAGE);
+    AppSlot_Install();
+    SimBoot_Expect("AppSlot_Install()", Bootloader_GET_RUN_TYPE, BTLDR_SIM_APP_A, SIMBOOT_NEW_IMAGE, 1);
+    SimBoot_Expect("power on", 0u, BTLDR_SIM_APP_A, SIMBOOT_OLD_IMAGE, 0);
+
+    printf("probation of %u ms, new image confirms\n", BTLDR_EXT_PROBATION_TIME);
+    SimBoot_Stage(SIMBOOT_NEW_IMAGE);
+    AppSlot_Install();
+    SimBoot_Expect("AppSlot_Install()", Bootloader_GET_RUN_TYPE, BTLDR_SIM_APP_A, SIMBOOT_NEW_IMAGE, 1);
+    SimBoot_Check("AppSlot_Confirm()", AppSlot_Confirm(), APP_SLOT_SUCCESS);
+    SimBoot_Expect("power on", 0u, BTLDR_SIM_APP_A, SIMBOOT_NEW_IMAGE, 0);
+#else
+    printf("staged image\n");
+    SimBoot_Stage(SIMBOOT_NEW_IMAGE);
+    AppSlot_Install();
+    SimBoot_Expect("AppSlot_Install()", Bootloader_GET_RUN_TYPE, BTLDR_SIM_APP_A, SIMBOOT_NEW_IMAGE, 0);
+    SimBoot_Expect("power on", 0u, BTLDR_SIM_APP_A, SIMBOOT_NEW_IMAGE, 0);
+#endif /* (BTLDR_EXT_MULTI_APP != 0u) */
+
+    printf("host link\n");
+    SimBoot_Open();
+    (void) BtldrHost_Enter(&SimBoot_link, NULL, NULL);
+    SimBoot_Check("burst of the application rows", SimBoot_Burst(BTLDR_EXT_FIRST_APP_ROW, 4u), BTLDR_HOST_SUCCESS);
+    SimBoot_Check("burst over the record rows",
+                  SimBoot_Burst(BTLDR_EXT_SLOT_META_ROW, (BTLDR_EXT_META_ROW - BTLDR_EXT_SLOT_META_ROW) + 1u),
+                  BTLDR_EXT_ERR_ROW);
+    SimBoot_Check("burst past the last row",
+                  SimBoot_Burst(BTLDR_EXT_META_ROW, (uint16_t) ((0x10000u + BTLDR_EXT_FIRST_APP_ROW + 1u) -
+                                                                BTLDR_EXT_META_ROW)),
+                  BTLDR_EXT_ERR_ROW);
+    SimBoot_Check("hashes of the application rows",
+                  BtldrHost_GetRowHashes(&SimBoot_link, 0u, BTLDR_EXT_FIRST_APP_ROW, 4u, hashes), BTLDR_HOST_SUCCESS);
+    SimBoot_Check("hashes over the record rows",
+                  BtldrHost_GetRowHashes(&SimBoot_link, 0u, BTLDR_EXT_SLOT_META_ROW,
+                                         (uint8_t) ((BTLDR_EXT_META_ROW - BTLDR_EXT_SLOT_META_ROW) + 1u), hashes),
+                  BTLDR_EXT_ERR_ROW);
+    BtldrSim_Close();
+
+    printf("%u failed\n", SimBoot_failures);
+
+    return ((SimBoot_failures != 0u) ? 1 : 0);
+}
+
+
+/* [] END OF FILE */
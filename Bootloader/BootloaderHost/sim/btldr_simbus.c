@@ -0,0 +1,340 @@
+/*******************************************************************************
+* File: btldr_simbus.c
+*
+* Version: 1.0
+*
+* Description:
+*  Several simulated CE95281 devices sharing one I2C bus. The firmware keeps
+*  its state in static variables, so every device is a btldr_sim.c device in
+*  a process of its own, forked when the bus is opened; the transports of the
+*  bus pass each transaction to it over a socket.
+*
+*  The bus keeps the virtual clock. A transaction takes the clock of the bus
+*  to the device, which moves its own clock forward to it, runs the
+*  transaction as btldr_sim.c does and returns the time the transaction
+*  ended. The devices work in parallel: a device programs its row while the
+*  bus carries the transactions of the others, and only a transaction that
+*  reaches a device still busy is stretched, holding the bus.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "btldr_simbus.h"
+
+/* Requests to the device process */
+#define BTLDR_SIMBUS_WRITE      (0u)
+#define BTLDR_SIMBUS_READ       (1u)
+#define BTLDR_SIMBUS_STATS      (2u)
+
+#define BTLDR_SIMBUS_MAX_DATA   (256u)
+
+typedef struct
+{
+    uint32_t op;
+    uint32_t size;                      /* of the transaction */
+    double   now;                       /* time on the bus */
+} BtldrSimBus_Request;
+
+typedef struct
+{
+    int32_t  result;
+    uint32_t size;                      /* of the data that follows */
+    double   now;                       /* time the transaction ended */
+} BtldrSimBus_Reply;
+
+static int BtldrSimBus_Send(int socket, const void *data, size_t size)
+{
+    const uint8_t *next = (const uint8_t *) data;
+    ssize_t sent;
+
+    while(size != 0u)
+    {
+        sent = send(socket, next, size, MSG_NOSIGNAL);
+        if(sent <= 0)
+        {
+            return (-1);
+        }
+        next += sent;
+        size -= (size_t) sent;
+    }
+
+    return (0);
+}
+
+static int BtldrSimBus_Receive(int socket, void *data, size_t size)
+{
+    uint8_t *next = (uint8_t *) data;
+    ssize_t received;
+
+    while(size != 0u)
+    {
+        received = recv(socket, next, size, 0);
+        if(received <= 0)
+        {
+            return (-1);
+        }
+        next += received;
+        size -= (size_t) received;
+    }
+
+    return (0);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrSimBus_Serve
+********************************************************************************
+*
+* Summary:
+*  Body of a device process: starts a simulated device with erased flash and
+*  runs the transactions received on the socket until the bus is closed.
+*
+*******************************************************************************/
+static void BtldrSimBus_Serve(int socket, const BtldrSim_Timing *timing)
+{
+    BtldrSimBus_Request request;
+    BtldrSimBus_Reply reply;
+    BtldrHost_Transport transport;
+    BtldrSim_Stats stats;
+    uint8_t data[BTLDR_SIMBUS_MAX_DATA];
+
+    BtldrSim_Erase();
+    if(BtldrSim_Open(timing) != 0)
+    {
+        _exit(1);
+    }
+    BtldrSim_Transport(&transport);
+
+    while((BtldrSimBus_Receive(socket, &request, sizeof(request)) == 0) && (request.size <= sizeof(data)))
+    {
+        (void) BtldrSim_Sync(request.now);
+        reply.size = 0u;
+
+        if(request.op == BTLDR_SIMBUS_WRITE)
+        {
+            if(BtldrSimBus_Receive(socket, data, request.size) != 0)
+            {
+                break;
+            }
+            reply.result = transport.write(transport.context, data, request.size);
+        }
+        else if(request.op == BTLDR_SIMBUS_READ)
+        {
+            reply.result = transport.read(transport.context, data, request.size);
+            reply.size = (reply.result == 0) ? request.size : 0u;
+        }
+        else
+        {
+            BtldrSim_GetStats(&stats);
+            memcpy(data, &stats, sizeof(stats));
+            reply.result = 0;
+            reply.size = sizeof(stats);
+        }
+
+        reply.now = BtldrSim_Sync(0.0);
+        if((BtldrSimBus_Send(socket, &reply, sizeof(reply)) != 0) ||
+           (BtldrSimBus_Send(socket, data, reply.size) != 0))
+        {
+            break;
+        }
+    }
+
+    _exit(0);
+}
+
+/* Runs a request on a device and moves the bus clock to its end */
+static int BtldrSimBus_Call(BtldrSimBus_Device *device, uint32_t op, const uint8_t *data, size_t size,
+                            void *out, size_t outSize)
+{
+    BtldrSimBus_Request request;
+    BtldrSimBus_Reply reply;
+
+    request.op = op;
+    request.size = (uint32_t) size;
+    request.now = device->bus->now;
+
+    if((size > BTLDR_SIMBUS_MAX_DATA) ||
+       (BtldrSimBus_Send(device->socket, &request, sizeof(request)) != 0) ||
+       ((op == BTLDR_SIMBUS_WRITE) && (BtldrSimBus_Send(device->socket, data, size) != 0)) ||
+       (BtldrSimBus_Receive(device->socket, &reply, sizeof(reply)) != 0) ||
+       (reply.size > outSize) ||
+       (BtldrSimBus_Receive(device->socket, out, reply.size) != 0))
+    {
+        return (-1);
+    }
+    device->bus->now = reply.now;
+
+    return (reply.result);
+}
+
+static int BtldrSimBus_Write(void *context, const uint8_t *data, size_t size)
+{
+    return (BtldrSimBus_Call((BtldrSimBus_Device *) context, BTLDR_SIMBUS_WRITE, data, size, NULL, 0u));
+}
+
+static int BtldrSimBus_Read(void *context, uint8_t *data, size_t size)
+{
+    return (BtldrSimBus_Call((BtldrSimBus_Device *) context, BTLDR_SIMBUS_READ, NULL, size, data, size));
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrSimBus_Open
+********************************************************************************
+*
+* Summary:
+*  Starts the devices of a bus, each with erased flash, and the bus clock at
+*  zero. Call it before the threads that will use the bus are started.
+*
+* Parameters:
+*  timing: Timing model of the bus and the devices, NULL selects
+*          BtldrSim_defaultTiming.
+*
+* Return:
+*  0 on success.
+*
+*******************************************************************************/
+int BtldrSimBus_Open(BtldrSimBus *bus, size_t deviceCount, const BtldrSim_Timing *timing)
+{
+    int sockets[2];
+    pid_t process;
+    size_t i;
+
+    bus->devices = calloc(deviceCount + 1u, sizeof(BtldrSimBus_Device));
+    bus->deviceCount = 0u;
+    bus->now = 0.0;
+    if(bus->devices == NULL)
+    {
+        return (-1);
+    }
+
+    for(i = 0u; i < deviceCount; i++)
+    {
+        if(socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+        {
+            break;
+        }
+        process = fork();
+        if(process == 0)
+        {
+            close(sockets[0]);
+            BtldrSimBus_Serve(sockets[1], timing);
+        }
+        close(sockets[1]);
+        if(process < 0)
+        {
+            close(sockets[0]);
+            break;
+        }
+
+        bus->devices[i].bus = bus;
+        bus->devices[i].socket = sockets[0];
+        bus->devices[i].process = (int) process;
+        bus->deviceCount++;
+    }
+
+    if(bus->deviceCount != deviceCount)
+    {
+        BtldrSimBus_Close(bus);
+        return (-1);
+    }
+
+    return (0);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrSimBus_Close
+********************************************************************************
+*
+* Summary:
+*  Stops the device processes.
+*
+*******************************************************************************/
+void BtldrSimBus_Close(BtldrSimBus *bus)
+{
+    size_t i;
+
+    for(i = 0u; i < bus->deviceCount; i++)
+    {
+        close(bus->devices[i].socket);
+        (void) kill((pid_t) bus->devices[i].process, SIGKILL);
+        (void) waitpid((pid_t) bus->devices[i].process, NULL, 0);
+    }
+
+    free(bus->devices);
+    bus->devices = NULL;
+    bus->deviceCount = 0u;
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrSimBus_Transport
+********************************************************************************
+*
+* Summary:
+*  Fills in the transport that talks to a device of the bus. The transports
+*  of one bus must be used from one thread at a time.
+*
+*******************************************************************************/
+void BtldrSimBus_Transport(BtldrSimBus *bus, size_t device, BtldrHost_Transport *transport)
+{
+    transport->context = &bus->devices[device];
+    transport->write = &BtldrSimBus_Write;
+    transport->read = &BtldrSimBus_Read;
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrSimBus_Clock
+********************************************************************************
+*
+* Summary:
+*  Reads the virtual time on the bus. The context is the bus, so the function
+*  can serve as the clock of a BtldrFleet_Bus.
+*
+*******************************************************************************/
+double BtldrSimBus_Clock(void *context)
+{
+    return (((const BtldrSimBus *) context)->now);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrSimBus_GetStats
+********************************************************************************
+*
+* Summary:
+*  Reads the counters of a device, as BtldrSim_GetStats() does. The clock of
+*  the device includes the work it has still to finish.
+*
+* Return:
+*  0 on success.
+*
+*******************************************************************************/
+int BtldrSimBus_GetStats(BtldrSimBus *bus, size_t device, BtldrSim_Stats *stats)
+{
+    double now = bus->now;
+    int result = BtldrSimBus_Call(&bus->devices[device], BTLDR_SIMBUS_STATS, NULL, 0u, stats, sizeof(*stats));
+
+    /* Reading the counters is not a transaction */
+    bus->now = now;
+
+    return (result);
+}
+
+
+/* [] END OF FILE */
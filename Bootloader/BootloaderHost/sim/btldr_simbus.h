@@ -0,0 +1,50 @@
+/*******************************************************************************
+* File: btldr_simbus.h
+*
+* Version: 1.0
+*
+* Description:
+*  Several simulated CE95281 devices sharing one I2C bus, each at its own
+*  slave address, with a common virtual clock for the bus.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#if !defined(BTLDR_SIMBUS_H)
+#define BTLDR_SIMBUS_H
+
+#include "btldr_sim.h"
+
+typedef struct BtldrSimBus BtldrSimBus;
+
+typedef struct
+{
+    BtldrSimBus *bus;
+    int          socket;                /* to the process of the device */
+    int          process;
+} BtldrSimBus_Device;
+
+struct BtldrSimBus
+{
+    BtldrSimBus_Device *devices;
+    size_t              deviceCount;
+    double              now;            /* virtual time on the bus, s */
+};
+
+int    BtldrSimBus_Open(BtldrSimBus *bus, size_t deviceCount, const BtldrSim_Timing *timing);
+void   BtldrSimBus_Close(BtldrSimBus *bus);
+void   BtldrSimBus_Transport(BtldrSimBus *bus, size_t device, BtldrHost_Transport *transport);
+double BtldrSimBus_Clock(void *context);
+int    BtldrSimBus_GetStats(BtldrSimBus *bus, size_t device, BtldrSim_Stats *stats);
+
+#endif /* BTLDR_SIMBUS_H */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,166 @@
+/*******************************************************************************
+* File: project.h
+*
+* Version: 1.0
+*
+* Description:
+*  Host stand-in for the project.h generated by PSoC Creator for the CE95281
+*  bootloader. Declares only the part of the generated API that btldr_ext.c
+*  uses, so the extended host link builds unchanged for the simulated device
+*  of btldr_sim.c, and the part that app_slot.c of the CE95280 bootloadable
+*  uses, so the slot API runs against the same flash.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#if !defined(PROJECT_H)
+#define PROJECT_H
+
+#include <stdint.h>
+
+
+/***************************************
+*        cytypes.h
+***************************************/
+
+typedef uint8_t     uint8;
+typedef uint16_t    uint16;
+typedef uint32_t    uint32;
+typedef int8_t      int8;
+typedef int16_t     int16;
+typedef int32_t     int32;
+typedef char        char8;
+typedef uint32      cystatus;
+
+#define CYRET_SUCCESS                   (0x00u)
+#define CYRET_TIMEOUT                   (0x10u)
+
+#define LO8(x)                          ((uint8)((x) & 0xFFu))
+#define HI8(x)                          ((uint8)((uint16)(x) >> 8))
+#define LO16(x)                         ((uint16)((x) & 0xFFFFu))
+#define HI16(x)                         ((uint16)((uint32)(x) >> 16))
+
+#define CyGlobalIntEnable
+#define CyGlobalIntDisable
+#define CY_NOINIT
+
+void CyDelayUs(uint16 microseconds);
+void CySoftwareReset(void);
+void __set_MSP(uint32 topOfMainStack);
+
+/* Interrupt clear-enable and clear-pending registers of the NVIC */
+extern uint32 BtldrSim_nvicClear;
+extern uint32 BtldrSim_nvicClearPending;
+
+#define CY_INT_CLEAR_REG                (BtldrSim_nvicClear)
+#define CY_INT_CLR_PEND_REG             (BtldrSim_nvicClearPending)
+
+/* SysTick of the Cortex-M0, counting down from its reload value */
+#define CYDEV_BCLK__SYSCLK__HZ          (24000000u)
+#define CY_SYS_SYST_CSR_CLK_SRC_SYSCLK  (1u)
+
+void   CySysTickEnable(void);
+void   CySysTickStop(void);
+void   CySysTickDisableInterrupt(void);
+void   CySysTickSetClockSource(uint32 clockSource);
+void   CySysTickSetReload(uint32 value);
+void   CySysTickClear(void);
+uint32 CySysTickGetValue(void);
+
+/* Watchdog counters of the PSoC 4 */
+#define CY_SYS_WDT_COUNTER0             (0x00u)
+#define CY_SYS_WDT_MODE_RESET           (0x02u)
+#define CY_SYS_WDT_COUNTER0_MASK        (0x01u)
+#define CY_SYS_WDT_COUNTER0_RESET       (0x01u)
+
+void CySysWdtUnlock(void);
+void CySysWdtLock(void);
+void CySysWdtWriteMode(uint32 counterNum, uint32 mode);
+void CySysWdtWriteMatch(uint32 counterNum, uint32 match);
+void CySysWdtWriteClearOnMatch(uint32 counterNum, uint32 enable);
+void CySysWdtResetCounters(uint32 countersMask);
+void CySysWdtEnable(uint32 counterMask);
+void CySysWdtDisable(uint32 counterMask);
+
+
+/***************************************
+*        cydevice_trm.h, CyFlash.h
+***************************************/
+
+/* CY8C4245AXI-483 of the CY8CKIT-049-42xx kit */
+#define CYDEV_CHIP_JTAG_ID              (0x04C81193u)
+#define CYDEV_CHIP_REVISION_USED        (0x11u)
+
+#define CY_FLASH_SIZEOF_ROW             (128u)
+#define CY_FLASH_NUMBER_ROWS            (256u)
+#define CY_FLASH_BASE                   ((uintptr_t) BtldrSim_flash)
+#define CY_SYS_FLASH_SUCCESS            (0x00u)
+#define CY_SYS_FLASH_IN_PROGRESS        (0x07u)
+
+extern uint8 BtldrSim_flash[];
+
+uint32 CySysFlashWriteRow(uint32 rowNum, const uint8 rowData[]);
+
+/* Non-blocking row write of the parts that have one */
+uint32 CySysFlashStartWriteRow(uint32 rowNum, const uint8 rowData[]);
+uint32 CySysFlashGetWriteRowStatus(void);
+
+
+/***************************************
+*        Bootloader component
+***************************************/
+
+extern uint8 BtldrSim_runType;
+
+#define Bootloader_START_APP            (0x80u)
+#define Bootloader_START_BTLDR          (0x40u)
+#define Bootloader_GET_RUN_TYPE         (BtldrSim_runType)
+#define Bootloader_SET_RUN_TYPE(x)      (BtldrSim_runType = (x))
+#define Bootloader_MD_BTLDB_ACTIVE_0    (0x00u)
+#define Bootloader_EXIT_TO_BTLDB        (0x00u)
+
+cystatus Bootloader_ValidateBootloadable(uint8 appId);
+void     Bootloader_Exit(uint8 appId);
+
+void     CyBtldrCommStart(void);
+void     CyBtldrCommStop(void);
+cystatus CyBtldrCommRead(uint8 pData[], uint16 size, uint16 *count, uint8 timeOut);
+cystatus CyBtldrCommWrite(const uint8 pData[], uint16 size, uint16 *count, uint8 timeOut);
+
+
+/***************************************
+*        Bootloadable component
+***************************************/
+
+/* Code address of the application that BtldrSim_Boot() launched last, for
+* AppSlot_Running()
+*/
+extern uintptr_t BtldrSim_codeAddr;
+
+#define APP_SLOT_CODE_ADDR              (BtldrSim_codeAddr)
+
+#define Bootloadable_SET_RUN_TYPE(x)    (BtldrSim_runType = (x))
+
+void Bootloadable_Load(void);
+
+
+/***************************************
+*        I2C_Slave (SCB) component
+***************************************/
+
+#define I2C_Slave_I2C_SSTAT_WR_CMPLT    (0x08u)
+#define I2C_Slave_I2C_SSTAT_WR_BUSY     (0x10u)
+
+uint32 I2C_Slave_I2CSlaveStatus(void);
+
+#endif /* PROJECT_H */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,210 @@
+/*******************************************************************************
+* File: app_entry.c
+*
+* Version: 1.0
+*
+* Description:
+*  This file implements the bootloader entry service of the bootloadable. With
+*  APP_ENTRY_I2C set, an I2C_Slave component, an SCB in I2C slave mode on the
+*  pins and at the slave address of the bootloader, receives the packets of
+*  the host while the application runs. When the host sends the Enter Bootloader
+*  command, the application calls AppEntry_Enter(): Bootloadable_Load()
+*  leaves the START_BTLDR run type, which survives the software reset, and
+*  resets the device. The CE95281 bootloader then serves the host at once
+*  instead of probing the bus or starting the application.
+*
+*  The service does not answer the Enter command. The host sends it again
+*  and the bootloader answers it, a few milliseconds after the request.
+*
+*  Without APP_ENTRY_I2C the service needs no component and does not hear
+*  the host: the request comes APP_ENTRY_WAIT_TIME after the start. The
+*  SysTick timer runs free on the system clock, as in the bootloader, and
+*  each poll adds the cycles elapsed since the previous one, so the time
+*  does not depend on how long the main loop takes. Poll at least every
+*  2^24 cycles, 0.35 s at 48 MHz, or the timer wraps unseen.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include "app_entry.h"
+
+/* The SysTick timer counts the cycles down over 24 bits */
+#define APP_ENTRY_CYCLE_MASK            (0x00FFFFFFu)
+#define APP_ENTRY_CYCLES_PER_MS         (CYDEV_BCLK__SYSCLK__HZ / 1000u)
+
+#if (APP_ENTRY_I2C != 0u)
+static uint8 AppEntry_writeBuffer[APP_ENTRY_SIZEOF_PACKET];
+static uint8 AppEntry_readBuffer[1u];
+
+static uint8 AppEntry_IsEnter(const uint8 packet[], uint32 size);
+#else
+static uint32 AppEntry_waited;          /* whole milliseconds since the start */
+static uint32 AppEntry_cycles;          /* cycles of the current millisecond */
+static uint32 AppEntry_tick;            /* SysTick value at the last poll */
+#endif /* (APP_ENTRY_I2C != 0u) */
+
+
+/*******************************************************************************
+* Function Name: AppEntry_Start
+********************************************************************************
+*
+* Summary:
+*  Starts listening for the host on the I2C_Slave component, or the wait
+*  without it. The wait takes the SysTick timer, free running without its
+*  interrupt.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void AppEntry_Start(void)
+{
+#if (APP_ENTRY_I2C != 0u)
+    AppEntry_readBuffer[0u] = 0xFFu;
+
+    I2C_Slave_I2CSlaveInitWriteBuf(AppEntry_writeBuffer, APP_ENTRY_SIZEOF_PACKET);
+    I2C_Slave_I2CSlaveInitReadBuf(AppEntry_readBuffer, sizeof(AppEntry_readBuffer));
+    I2C_Slave_Start();
+#else
+    CySysTickDisableInterrupt();
+    CySysTickSetClockSource(CY_SYS_SYST_CSR_CLK_SRC_SYSCLK);
+    CySysTickSetReload(APP_ENTRY_CYCLE_MASK);
+    CySysTickClear();
+    CySysTickEnable();
+
+    AppEntry_waited = 0u;
+    AppEntry_cycles = 0u;
+    AppEntry_tick = CySysTickGetValue();
+#endif /* (APP_ENTRY_I2C != 0u) */
+}
+
+
+/*******************************************************************************
+* Function Name: AppEntry_Poll
+********************************************************************************
+*
+* Summary:
+*  Checks the packet last written by the host, if any, and makes room for
+*  the next one. Without the I2C_Slave component, adds the time elapsed
+*  since the previous poll instead. Call it from the main loop.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Nonzero if the host asked for the bootloader.
+*
+*******************************************************************************/
+uint8 AppEntry_Poll(void)
+{
+    uint8 request = 0u;
+#if (APP_ENTRY_I2C == 0u)
+    uint32 tick;
+#endif /* (APP_ENTRY_I2C == 0u) */
+
+#if (APP_ENTRY_I2C != 0u)
+    if((I2C_Slave_I2CSlaveStatus() & I2C_Slave_I2C_SSTAT_WR_CMPLT) != 0u)
+    {
+        request = AppEntry_IsEnter(AppEntry_writeBuffer, I2C_Slave_I2CSlaveGetWriteBufSize());
+
+        I2C_Slave_I2CSlaveClearWriteBuf();
+        (void) I2C_Slave_I2CSlaveClearWriteStatus();
+    }
+#else
+    tick = CySysTickGetValue();
+    AppEntry_cycles += (AppEntry_tick - tick) & APP_ENTRY_CYCLE_MASK;
+    AppEntry_tick = tick;
+
+    AppEntry_waited += AppEntry_cycles / APP_ENTRY_CYCLES_PER_MS;
+    AppEntry_cycles %= APP_ENTRY_CYCLES_PER_MS;
+    request = (AppEntry_waited >= APP_ENTRY_WAIT_TIME) ? 1u : 0u;
+#endif /* (APP_ENTRY_I2C != 0u) */
+
+    return (request);
+}
+
+
+/*******************************************************************************
+* Function Name: AppEntry_Enter
+********************************************************************************
+*
+* Summary:
+*  Releases the bus and resets into the bootloader, which waits for the host.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None. Does not return.
+*
+*******************************************************************************/
+void AppEntry_Enter(void)
+{
+#if (APP_ENTRY_I2C != 0u)
+    I2C_Slave_Stop();
+#endif /* (APP_ENTRY_I2C != 0u) */
+
+    /* Sets the retained START_BTLDR run type and resets the device */
+    Bootloadable_Load();
+}
+
+
+#if (APP_ENTRY_I2C != 0u)
+/*******************************************************************************
+* Function Name: AppEntry_IsEnter
+********************************************************************************
+*
+* Summary:
+*  Checks the frame of a packet the way the bootloader does.
+*
+* Parameters:
+*  packet: Bytes written by the host.
+*  size:   Number of bytes.
+*
+* Return:
+*  Nonzero if the packet is a valid Enter Bootloader command.
+*
+*******************************************************************************/
+static uint8 AppEntry_IsEnter(const uint8 packet[], uint32 size)
+{
+    uint32 length;
+    uint16 sum = 0u;
+    uint32 i;
+
+    if((size < APP_ENTRY_SIZEOF_OVERHEAD) || (packet[0u] != APP_ENTRY_SOP) ||
+       (packet[1u] != APP_ENTRY_CMD_ENTER))
+    {
+        return (0u);
+    }
+
+    length = (uint32) packet[2u] | ((uint32) packet[3u] << 8u);
+    if(size < (length + APP_ENTRY_SIZEOF_OVERHEAD))
+    {
+        return (0u);
+    }
+
+    /* Two's complement of the 16-bit sum, as BtldrExt_PacketChecksum() */
+    for(i = 0u; i < (APP_ENTRY_SIZEOF_HEADER + length); i++)
+    {
+        sum += packet[i];
+    }
+    sum = (uint16)(1u + (uint16)(~sum));
+
+    return (((packet[APP_ENTRY_SIZEOF_HEADER + length] == LO8(sum)) &&
+             (packet[APP_ENTRY_SIZEOF_HEADER + length + 1u] == HI8(sum)) &&
+             (packet[APP_ENTRY_SIZEOF_HEADER + length + 2u] == APP_ENTRY_EOP)) ? 1u : 0u);
+}
+#endif /* (APP_ENTRY_I2C != 0u) */
+
+
+/* [] END OF FILE */
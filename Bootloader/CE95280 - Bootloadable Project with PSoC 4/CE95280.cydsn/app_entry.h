@@ -0,0 +1,76 @@
+/*******************************************************************************
+* File: app_entry.h
+*
+* Version: 1.0
+*
+* Description:
+*  Provides the API of the bootloader entry service: the bootloadable watches
+*  the I2C bus of the bootloader for the Enter Bootloader command of the host
+*  and resets into the bootloader on request. The request of the host is only
+*  seen with an I2C_Slave SCB component in the schematic and APP_ENTRY_I2C
+*  set. Without them the service ignores the host and resets into the
+*  bootloader a fixed time after the start.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#if !defined(APP_ENTRY_H)
+#define APP_ENTRY_H
+
+#include <project.h>
+
+
+/***************************************
+*        Configuration
+***************************************/
+
+/* Set to 1u once the schematic holds an I2C_Slave SCB component in I2C slave
+* mode, on the pins and at the slave address of the CE95281 bootloader. Both
+* are needed for the host to reach the bootloader on demand. The schematic
+* of this project has no such component, so by default the service has no
+* bus: the Enter command of the host goes unanswered while the application
+* runs, and the service requests the bootloader APP_ENTRY_WAIT_TIME after
+* the start, as this example did before the service was added.
+*/
+#if !defined(APP_ENTRY_I2C)
+    #define APP_ENTRY_I2C               (0u)
+#endif /* !defined(APP_ENTRY_I2C) */
+
+/* Time to the bootloader request without the I2C_Slave component, in ms,
+* measured on the SysTick timer
+*/
+#define APP_ENTRY_WAIT_TIME             (7000u)
+
+
+/***************************************
+*        Packet format
+***************************************/
+
+/* These values must match btldr_ext.h of the CE95281 project */
+#define APP_ENTRY_SIZEOF_PACKET         (64u)
+#define APP_ENTRY_SIZEOF_HEADER         (4u)
+#define APP_ENTRY_SIZEOF_OVERHEAD       (7u)
+#define APP_ENTRY_SOP                   (0x01u)
+#define APP_ENTRY_EOP                   (0x17u)
+#define APP_ENTRY_CMD_ENTER             (0x38u)
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+void  AppEntry_Start(void);
+uint8 AppEntry_Poll(void);
+void  AppEntry_Enter(void);
+
+#endif /* APP_ENTRY_H */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,395 @@
+/*******************************************************************************
+* File: app_slot.c
+*
+* Version: 1.0
+*
+* Description:
+*  This file implements the reception of a new image into slot B. The
+*  application passes the rows of the new .cyacd image as it receives them
+*  over its own interface and keeps running in between; every row write
+*  stalls the CPU only for the time of one flash row write. The image becomes
+*  active only after AppSlot_Commit() has verified it and AppSlot_Install()
+*  has reset the device into the bootloader, which copies it over slot A.
+*  With APP_SLOT_PROBATION set, the bootloader swaps the two slots instead
+*  and the new image must call AppSlot_Confirm() before the watchdog armed
+*  for its first start runs out; otherwise the previous image, kept in
+*  slot B, comes back at the next start.
+*
+*  With APP_SLOT_MULTI_APP set, the image received is the application of
+*  slot B, linked to run there, and it is not copied: AppSlot_Select()
+*  records which application the bootloader launches and resets into the
+*  bootloader, which starts it.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <string.h>
+#include "app_slot.h"
+
+static uint8 AppSlot_rowBuffer[CY_FLASH_SIZEOF_ROW];
+
+/* CRC-32C of each 4-bit value, the table of BtldrExt_Crc32() with
+* BTLDR_EXT_CRC_TABLE_SIZE of 16
+*/
+static const uint32 AppSlot_crcTable[16u] =
+{
+    0x00000000u, 0x105EC76Fu, 0x20BD8EDEu, 0x30E349B1u,
+    0x417B1DBCu, 0x5125DAD3u, 0x61C69362u, 0x7198540Du,
+    0x82F63B78u, 0x92A8FC17u, 0xA24BB5A6u, 0xB21572C9u,
+    0xC38D26C4u, 0xD3D3E1ABu, 0xE330A81Au, 0xF36E6F75u
+};
+
+static uint8 AppSlot_Program(uint16 row, const uint8 rowData[]);
+
+
+/*******************************************************************************
+* Function Name: AppSlot_Begin
+********************************************************************************
+*
+* Summary:
+*  Starts the reception of a new image. Clears the slot record so that a
+*  partly overwritten slot B is never installed. An application running
+*  from slot B cannot receive the image that replaces it. An image on
+*  probation is confirmed first: the previous image in slot B is about to
+*  be overwritten.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Status of the operation.
+*
+*******************************************************************************/
+uint8 AppSlot_Begin(void)
+{
+#if (APP_SLOT_MULTI_APP != 0u)
+    if(AppSlot_Running() == APP_SLOT_APP_B)
+    {
+        return (APP_SLOT_ERR_APP);
+    }
+#endif /* (APP_SLOT_MULTI_APP != 0u) */
+
+#if (APP_SLOT_PROBATION != 0u)
+    (void) AppSlot_Confirm();
+#endif /* (APP_SLOT_PROBATION != 0u) */
+
+    (void) memset(AppSlot_rowBuffer, 0, CY_FLASH_SIZEOF_ROW);
+
+    return (AppSlot_Program(BTLDR_EXT_SLOT_RECORD_ROW, AppSlot_rowBuffer));
+}
+
+
+/*******************************************************************************
+* Function Name: AppSlot_WriteRow
+********************************************************************************
+*
+* Summary:
+*  Stores one row of the new image in slot B. The rows may be written in any
+*  order.
+*
+* Parameters:
+*  row:     Row number of the row in the image, as given in the .cyacd file:
+*           a row of slot A, or of slot B with APP_SLOT_MULTI_APP set, or
+*           the metadata row.
+*  rowData: CY_FLASH_SIZEOF_ROW bytes.
+*
+* Return:
+*  Status of the operation.
+*
+*******************************************************************************/
+uint8 AppSlot_WriteRow(uint16 row, const uint8 rowData[])
+{
+    uint8 status = APP_SLOT_ERR_ROW;
+
+    if(row == BTLDR_EXT_META_ROW)
+    {
+        status = AppSlot_Program(BTLDR_EXT_SLOT_META_ROW, rowData);
+    }
+#if (APP_SLOT_MULTI_APP != 0u)
+    else if((row >= BTLDR_EXT_SLOT_B_ROW) && (row < BTLDR_EXT_SLOT_META_ROW) && (AppSlot_Running() == APP_SLOT_APP_A))
+    {
+        status = AppSlot_Program(row, rowData);
+    }
+#else
+    else if((row >= BTLDR_EXT_FIRST_APP_ROW) && (row < BTLDR_EXT_SLOT_B_ROW))
+    {
+        status = AppSlot_Program(row + BTLDR_EXT_SLOT_ROWS, rowData);
+    }
+#endif /* (APP_SLOT_MULTI_APP != 0u) */
+    else
+    {
+        /* The image does not fit in one slot */
+    }
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: AppSlot_Hash
+********************************************************************************
+*
+* Summary:
+*  Continues the CRC-32C of an image. The hash passed to
+*  AppSlot_Commit() starts from APP_SLOT_HASH_INIT and covers the rowCount
+*  rows from BTLDR_EXT_FIRST_APP_ROW followed by the metadata row.
+*
+* Parameters:
+*  hash: Hash of the preceding bytes.
+*  data: Next bytes of the image.
+*  size: Number of bytes.
+*
+* Return:
+*  The updated hash.
+*
+*******************************************************************************/
+uint32 AppSlot_Hash(uint32 hash, const uint8 data[], uint32 size)
+{
+    uint32 crc = ~hash;
+    uint32 i;
+
+    for(i = 0u; i < size; i++)
+    {
+        crc ^= data[i];
+        crc = (crc >> 4u) ^ AppSlot_crcTable[crc & 0x0Fu];
+        crc = (crc >> 4u) ^ AppSlot_crcTable[crc & 0x0Fu];
+    }
+
+    return (~crc);
+}
+
+
+/*******************************************************************************
+* Function Name: AppSlot_Commit
+********************************************************************************
+*
+* Summary:
+*  Verifies the staged image against the hash supplied by the sender and
+*  writes the slot record that makes the bootloader install it.
+*
+* Parameters:
+*  rowCount: Number of application rows of the image.
+*  hash:     Image hash, see AppSlot_Hash().
+*
+* Return:
+*  Status of the operation.
+*
+*******************************************************************************/
+uint8 AppSlot_Commit(uint16 rowCount, uint32 hash)
+{
+    BtldrExt_SlotRecord_T record;
+    uint32 staged = APP_SLOT_HASH_INIT;
+    uint16 i;
+    uint8 status = APP_SLOT_ERR_ROW;
+
+    if((rowCount != 0u) && (rowCount <= BTLDR_EXT_SLOT_ROWS))
+    {
+        for(i = 0u; i < rowCount; i++)
+        {
+            staged = AppSlot_Hash(staged, BTLDR_EXT_ROW_ADDR(BTLDR_EXT_SLOT_B_ROW + i), CY_FLASH_SIZEOF_ROW);
+        }
+        staged = AppSlot_Hash(staged, BTLDR_EXT_ROW_ADDR(BTLDR_EXT_SLOT_META_ROW), CY_FLASH_SIZEOF_ROW);
+
+        status = APP_SLOT_ERR_VERIFY;
+        if(staged == hash)
+        {
+            record.magic = BTLDR_EXT_SLOT_MAGIC;
+            record.rowCount = rowCount;
+            record.hash = hash;
+            record.check = ~(record.magic ^ record.rowCount ^ record.hash);
+
+            (void) memset(AppSlot_rowBuffer, 0, CY_FLASH_SIZEOF_ROW);
+            (void) memcpy(AppSlot_rowBuffer, &record, sizeof(record));
+            status = AppSlot_Program(BTLDR_EXT_SLOT_RECORD_ROW, AppSlot_rowBuffer);
+        }
+    }
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: AppSlot_IsStaged
+********************************************************************************
+*
+* Summary:
+*  Reports whether a verified image waits in slot B or, with
+*  APP_SLOT_MULTI_APP set, is resident there.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Nonzero if the slot record is present.
+*
+*******************************************************************************/
+uint8 AppSlot_IsStaged(void)
+{
+    const BtldrExt_SlotRecord_T *record = (const BtldrExt_SlotRecord_T *) BTLDR_EXT_ROW_ADDR(BTLDR_EXT_SLOT_RECORD_ROW);
+
+    return ((record->magic == BTLDR_EXT_SLOT_MAGIC) ? 1u : 0u);
+}
+
+
+/*******************************************************************************
+* Function Name: AppSlot_Install
+********************************************************************************
+*
+* Summary:
+*  Resets into the bootloader, which installs the staged image and launches
+*  it without waiting for a host.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None. Does not return.
+*
+*******************************************************************************/
+void AppSlot_Install(void)
+{
+    Bootloadable_Load();
+}
+
+#if (APP_SLOT_PROBATION != 0u)
+/*******************************************************************************
+* Function Name: AppSlot_Confirm
+********************************************************************************
+*
+* Summary:
+*  Ends the probation of a newly installed image: clears the probation
+*  record, so the bootloader keeps this image, and stops the watchdog that
+*  the bootloader armed for its first start. Call it once the start-up has
+*  shown the image healthy. Does nothing when the image is not on probation.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Status of the operation.
+*
+*******************************************************************************/
+uint8 AppSlot_Confirm(void)
+{
+    const BtldrExt_ProbationRecord_T *record =
+        (const BtldrExt_ProbationRecord_T *) BTLDR_EXT_ROW_ADDR(BTLDR_EXT_SLOT_RECORD_ROW);
+    uint8 status = APP_SLOT_SUCCESS;
+
+    if(record->magic == BTLDR_EXT_PROBATION_MAGIC)
+    {
+        (void) memset(AppSlot_rowBuffer, 0, CY_FLASH_SIZEOF_ROW);
+        status = AppSlot_Program(BTLDR_EXT_SLOT_RECORD_ROW, AppSlot_rowBuffer);
+
+        /* A watchdog reset from here on no longer rolls the image back */
+        if(status == APP_SLOT_SUCCESS)
+        {
+            CySysWdtUnlock();
+            CySysWdtDisable(CY_SYS_WDT_COUNTER0_MASK);
+            CySysWdtLock();
+        }
+    }
+
+    return (status);
+}
+#endif /* (APP_SLOT_PROBATION != 0u) */
+
+#if (APP_SLOT_MULTI_APP != 0u)
+/*******************************************************************************
+* Function Name: AppSlot_Running
+********************************************************************************
+*
+* Summary:
+*  Reports the slot this application runs from.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  APP_SLOT_APP_A or APP_SLOT_APP_B.
+*
+*******************************************************************************/
+uint8 AppSlot_Running(void)
+{
+    return ((APP_SLOT_CODE_ADDR >= (CY_FLASH_BASE + ((uint32) BTLDR_EXT_SLOT_B_ROW * CY_FLASH_SIZEOF_ROW))) ?
+            APP_SLOT_APP_B : APP_SLOT_APP_A);
+}
+
+
+/*******************************************************************************
+* Function Name: AppSlot_Select
+********************************************************************************
+*
+* Summary:
+*  Writes the select record and resets into the bootloader with the
+*  BTLDR_EXT_START_SELECT run type, and the bootloader starts the selected
+*  application at once. Bootloadable_Load() would make it wait
+*  BTLDR_EXT_WAIT_TIME for a host, and a scheduled launch would not do:
+*  CyBtldr_CheckLaunch() of the reset handler launches slot A before the
+*  bootloader reads the record.
+*
+* Parameters:
+*  app: APP_SLOT_APP_A or APP_SLOT_APP_B.
+*
+* Return:
+*  APP_SLOT_ERR_APP if no application is resident in slot B, or the status
+*  of the record write. Does not return otherwise.
+*
+*******************************************************************************/
+uint8 AppSlot_Select(uint8 app)
+{
+    BtldrExt_SelectRecord_T record;
+    uint8 status = APP_SLOT_ERR_APP;
+
+    if((app == APP_SLOT_APP_A) || ((app == APP_SLOT_APP_B) && (AppSlot_IsStaged() != 0u)))
+    {
+        record.magic = BTLDR_EXT_SELECT_MAGIC;
+        record.app = app;
+        record.check = ~(record.magic ^ record.app);
+
+        (void) memset(AppSlot_rowBuffer, 0, CY_FLASH_SIZEOF_ROW);
+        (void) memcpy(AppSlot_rowBuffer, &record, sizeof(record));
+        status = AppSlot_Program(BTLDR_EXT_SELECT_ROW, AppSlot_rowBuffer);
+    }
+
+    if(status == APP_SLOT_SUCCESS)
+    {
+        /* The run type is retained through the software reset */
+        Bootloadable_SET_RUN_TYPE(BTLDR_EXT_START_SELECT);
+        CySoftwareReset();
+    }
+
+    return (status);
+}
+#endif /* (APP_SLOT_MULTI_APP != 0u) */
+
+
+/*******************************************************************************
+* Function Name: AppSlot_Program
+********************************************************************************
+*
+* Summary:
+*  Programs one flash row.
+*
+* Parameters:
+*  row:     Absolute row number.
+*  rowData: CY_FLASH_SIZEOF_ROW bytes.
+*
+* Return:
+*  Status of the operation.
+*
+*******************************************************************************/
+static uint8 AppSlot_Program(uint16 row, const uint8 rowData[])
+{
+    return ((CySysFlashWriteRow((uint32) row, rowData) == CY_SYS_FLASH_SUCCESS) ?
+            APP_SLOT_SUCCESS : APP_SLOT_ERR_FLASH);
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,105 @@
+/*******************************************************************************
+* File: app_slot.h
+*
+* Version: 1.0
+*
+* Description:
+*  Provides the API for receiving a new image into the second application
+*  slot while this bootloadable keeps running. The CE95281 bootloader installs
+*  the staged image on the next reset or, in the multi-application mode,
+*  keeps it resident and launches the application selected. The rows arrive
+*  over an interface of the application; the CE95280 design has no
+*  communication component, so main.c does not receive images itself.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#if !defined(APP_SLOT_H)
+#define APP_SLOT_H
+
+#include <project.h>
+
+
+/***************************************
+*        Slot layout
+***************************************/
+
+/* The slot layout, the records and their configuration come from
+* btldr_slot.h of the CE95281 project, found through the include path of
+* this project, so the two sides cannot disagree. BTLDR_EXT_MULTI_APP and
+* BTLDR_EXT_PROBATION_TIME are set there, or on the command line of both
+* builds. This bootloadable runs from slot A and must not be larger than
+* BTLDR_EXT_SLOT_ROWS rows.
+*/
+#include "btldr_slot.h"
+
+/* Multi-application mode: the image committed to slot B is a second
+* application, for example diagnostics, that stays resident next to this
+* one, and AppSlot_Select() chooses the application launched after a reset.
+* It is built as a bootloadable placed at the first row of slot B.
+*/
+#define APP_SLOT_MULTI_APP              (BTLDR_EXT_MULTI_APP)
+
+/* The bootloader puts an installed image on probation: it swaps the image
+* in and rolls it back at the next start unless AppSlot_Confirm() is called
+* first.
+*/
+#define APP_SLOT_PROBATION              (BTLDR_EXT_PROBATION_TIME != 0u)
+
+/* Applications of the select record */
+#define APP_SLOT_APP_A                  (BTLDR_EXT_APP_A)
+#define APP_SLOT_APP_B                  (BTLDR_EXT_APP_B)
+
+/* The image hash is the CRC-32C of BtldrExt_Crc32() in the CE95281
+* project, started from APP_SLOT_HASH_INIT
+*/
+#define APP_SLOT_HASH_INIT              (BTLDR_EXT_CRC_INIT)
+
+/* Address of the code of this application, compared by AppSlot_Running()
+* with the start of slot B
+*/
+#if !defined(APP_SLOT_CODE_ADDR)
+    #define APP_SLOT_CODE_ADDR          ((uint32) &AppSlot_Running)
+#endif /* !defined(APP_SLOT_CODE_ADDR) */
+
+
+/***************************************
+*        Status codes
+***************************************/
+
+#define APP_SLOT_SUCCESS                (0x00u)
+#define APP_SLOT_ERR_ROW                (0x01u)
+#define APP_SLOT_ERR_FLASH              (0x02u)
+#define APP_SLOT_ERR_VERIFY             (0x03u)
+#define APP_SLOT_ERR_APP                (0x04u)
+
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+uint8  AppSlot_Begin(void);
+uint8  AppSlot_WriteRow(uint16 row, const uint8 rowData[]);
+uint32 AppSlot_Hash(uint32 hash, const uint8 data[], uint32 size);
+uint8  AppSlot_Commit(uint16 rowCount, uint32 hash);
+uint8  AppSlot_IsStaged(void);
+void   AppSlot_Install(void);
+#if (APP_SLOT_PROBATION != 0u)
+    uint8 AppSlot_Confirm(void);
+#endif /* (APP_SLOT_PROBATION != 0u) */
+#if (APP_SLOT_MULTI_APP != 0u)
+    uint8 AppSlot_Running(void);
+    uint8 AppSlot_Select(uint8 app);
+#endif /* (APP_SLOT_MULTI_APP != 0u) */
+
+#endif /* APP_SLOT_H */
+
+
+/* [] END OF FILE */
@@ -5,7 +5,15 @@
 *
 * Description:
 *  This example project demonstrates the basic operation of Bootloadable
-*  component.
+*  component. A new image received by the application into the second slot
+*  (app_slot.c) is switched to with a single reset. The application resets
+*  into the bootloader (app_entry.c) on the Enter Bootloader command of the
+*  host once an I2C_Slave SCB is added and APP_ENTRY_I2C is set, and 7 s
+*  after the start until then. In the
+*  multi-application mode the image stays resident in the second slot and
+*  AppSlot_Select() switches between the two applications with one reset.
+*  A newly installed image confirms itself once it has started; the
+*  bootloader rolls back one that resets before that.
 *
 ********************************************************************************
 * Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
@@ -18,6 +26,8 @@
 * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
 *******************************************************************************/
 #include <project.h>
+#include "app_entry.h"
+#include "app_slot.h"
 
 int main()
 {
@@ -28,15 +38,31 @@ int main()
     /* Turn on green LED */
     Bootloadable_Status_Write(0u);
 
-    /* Make a delay */
-    CyDelay(7000u);
+    /* Listen for the host on the bus of the bootloader (APP_ENTRY_I2C) */
+    AppEntry_Start();
 
-    /* Schedule bootloader application and execute software reseet */
-    Bootloadable_Load();
+#if ((APP_SLOT_MULTI_APP == 0u) && (APP_SLOT_PROBATION != 0u))
+    /* The start-up succeeded: keep this image if it is on probation */
+    (void) AppSlot_Confirm();
+#endif /* ((APP_SLOT_MULTI_APP == 0u) && (APP_SLOT_PROBATION != 0u)) */
 
     for(;;)
     {
-        /* Should never be here */
+        /* Place your application code here. */
+
+    #if (APP_SLOT_MULTI_APP == 0u)
+        if(AppSlot_IsStaged() != 0u)
+        {
+            /* The bootloader installs the staged image and launches it */
+            AppSlot_Install();
+        }
+    #endif /* (APP_SLOT_MULTI_APP == 0u) */
+
+        if(AppEntry_Poll() != 0u)
+        {
+            /* Schedule bootloader application and execute software reset */
+            AppEntry_Enter();
+        }
     }
 }
 
@@ -0,0 +1,2743 @@
+/*******************************************************************************
+* File: btldr_ext.c
+*
+* Version: 1.0
+*
+* Description:
+*  This file implements the extended host link of the bootloader. The link
+*  serves the standard programming commands of the Bootloader component over
+*  the I2C_Slave communication component and adds a multi-row burst that
+*  programs consecutive rows with a single acknowledge from the bootloader,
+*  optionally LZ compressed and decompressed as the packets arrive, and a row
+*  hash query used by the host for delta updates. It also installs an image
+*  staged in the second slot by the bootloadable, caches the result of the
+*  application checksum so that a normal start does not recompute it, and
+*  keeps a progress journal so that an interrupted update can be resumed.
+*  An image hash is added up as the rows are programmed, so the update is
+*  verified without another pass over the flash. Optionally, the rows of a
+*  burst are programmed in the background while the next row is received.
+*  Per-command counters of calls, cycles, flash writes and host waits are
+*  kept for the host to read. Optionally, the application in slot B stays
+*  resident next to slot A and a select record chooses which one runs.
+*  Otherwise the staged image is swapped in and put on probation: it is
+*  swapped back out unless it confirms its health on its first start.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "btldr_ext.h"
+
+/* Poll period of the communication component, in 10 ms units */
+#define BTLDR_EXT_READ_POLL             (1u)
+
+/* A second row buffer receives the next row while a row is programmed */
+#define BTLDR_EXT_ROW_BUFFERS           ((BTLDR_EXT_BACKGROUND_WRITE != 0u) ? 2u : 1u)
+
+/* Bits of the CRC consumed by one table lookup */
+#define BTLDR_EXT_CRC_TABLE_BITS        ((BTLDR_EXT_CRC_TABLE_SIZE == 256u) ? 8u : 4u)
+
+#define BTLDR_EXT_GET_WORD(p)           ((uint16)((uint16)(p)[0u] | ((uint16)(p)[1u] << 8u)))
+#define BTLDR_EXT_SET_WORD(p, w)        do { (p)[0u] = LO8(w); (p)[1u] = HI8(w); } while(0)
+#define BTLDR_EXT_SET_LONG(p, l)        do { BTLDR_EXT_SET_WORD((p), LO16(l)); \
+                                             BTLDR_EXT_SET_WORD(&(p)[2u], HI16(l)); } while(0)
+
+/* The SysTick timer counts the cycles down over 24 bits */
+#define BTLDR_EXT_CYCLE_MASK            (0x00FFFFFFu)
+
+/* No command was dispatched: a wait is not attributed to any */
+#define BTLDR_EXT_NO_COMMAND            (0xFFu)
+
+/* Images installed from slot B are swapped in and put on probation */
+#define BTLDR_EXT_PROBATION             (BTLDR_EXT_PROBATION_TIME != 0u)
+
+/* Watchdog counter 0 ticks of the probation time, on the 32 kHz ILO */
+#define BTLDR_EXT_PROBATION_TICKS       ((BTLDR_EXT_PROBATION_TIME * 32u) + 1u)
+
+/* Steps of the swap of one row, in order */
+#define BTLDR_EXT_SWAP_SAVE             (0u)
+#define BTLDR_EXT_SWAP_MOVE             (1u)
+#define BTLDR_EXT_SWAP_RESTORE          (2u)
+#define BTLDR_EXT_SWAP_DONE             (3u)
+
+/* States of the probation record */
+#define BTLDR_EXT_PROBATION_NEW         (0u)
+#define BTLDR_EXT_PROBATION_LAUNCHED    (1u)
+#define BTLDR_EXT_PROBATION_ROLLED      (2u)
+#define BTLDR_EXT_PROBATION_NONE        (0xFFu)
+
+/* Command handler. Returns the status for the response or
+* BTLDR_EXT_NO_RESPONSE when the command is not answered.
+*/
+typedef uint8 (*BtldrExt_Handler_T)(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength);
+
+typedef struct _BtldrExt_Command_T
+{
+    uint8               command;        /* command code */
+    uint8               minLength;      /* smallest data length accepted */
+    BtldrExt_Handler_T  handler;        /* function executing the command */
+} BtldrExt_Command_T;
+
+typedef struct _BtldrExt_Burst_T
+{
+    uint8   arrayId;                    /* flash array of the burst */
+    uint16  nextRow;                    /* row programmed when the buffer is full */
+    uint16  rowsLeft;                   /* rows not yet received */
+    uint16  rowsDone;                   /* rows committed to flash */
+    uint16  pendingRow;                 /* row started but not yet committed */
+    uint8   pending;                    /* pendingRow is valid */
+    uint8   sequence;                   /* expected sequence number of the next chunk */
+    uint8   encoding;                   /* BTLDR_EXT_ENCODING_RAW or _LZ */
+    uint8   status;                     /* first error of the burst */
+} BtldrExt_Burst_T;
+
+/* LZ decoder states */
+#define BTLDR_EXT_LZ_ITEM               (0u)
+#define BTLDR_EXT_LZ_LENGTH             (1u)
+
+typedef struct _BtldrExt_Lz_T
+{
+    uint8   flags;                      /* item types of the current group, LSB first */
+    uint8   flagsLeft;                  /* items left in the current group */
+    uint8   state;                      /* next byte is an item or a match length */
+    uint8   distance;                   /* distance minus one of the pending match */
+    uint8   position;                   /* next write position in the window */
+} BtldrExt_Lz_T;
+
+/* Head of the validity record row. Written once the application checksum
+* has passed; any host session or slot install clears it.
+*/
+typedef struct _BtldrExt_ValidRecord_T
+{
+    uint32  magic;                      /* BTLDR_EXT_VALID_MAGIC */
+    uint32  metaHash;                   /* BtldrExt_RowHash() of the metadata row */
+    uint32  check;                      /* ~(magic ^ metaHash) */
+} BtldrExt_ValidRecord_T;
+
+/* Rows programmed since ENTER and the sum of their BtldrExt_RowDigest()
+* values, the image hash checked by VERIFY_IMAGE
+*/
+typedef struct _BtldrExt_Session_T
+{
+    uint32  digest;                     /* sum of the digests of the rows */
+    uint16  rowCount;                   /* rows in the map */
+    uint8   rows[BTLDR_EXT_JOURNAL_MAP_SIZE]; /* one bit per row from BTLDR_EXT_FIRST_APP_ROW */
+} BtldrExt_Session_T;
+
+/* Performance counters of a command since ENTER */
+typedef struct _BtldrExt_Counter_T
+{
+    uint16  calls;                      /* saturates at 0xFFFF */
+    uint32  cycles;                     /* in the command, flash writes included */
+    uint32  maxCycles;                  /* of the longest call */
+    uint32  flashCycles;                /* writing rows and waiting for background writes */
+    uint32  waitCycles;                 /* waiting for the command and for the host to read the response */
+} BtldrExt_Counter_T;
+
+/* Head of the vector table of an application */
+typedef struct _BtldrExt_Vectors_T
+{
+    uint32  stackTop;                   /* initial main stack pointer */
+    void  (*reset)(void);               /* reset handler */
+} BtldrExt_Vectors_T;
+
+/* Row image of a record row. It backs the open journal, so writing any
+* record closes the journal.
+*/
+typedef union _BtldrExt_RecordRow_T
+{
+    uint8               row[CY_FLASH_SIZEOF_ROW];
+    BtldrExt_ValidRecord_T valid;
+    BtldrExt_SelectRecord_T select;
+    BtldrExt_SwapRecord_T swap;
+    BtldrExt_ProbationRecord_T probation;
+    BtldrExt_Journal_T  journal;
+} BtldrExt_RecordRow_T;
+
+static uint8  BtldrExt_packet[BTLDR_EXT_SIZEOF_PACKET];
+static uint8  BtldrExt_response[BTLDR_EXT_SIZEOF_PACKET];
+static uint8  BtldrExt_rowBuffers[BTLDR_EXT_ROW_BUFFERS][CY_FLASH_SIZEOF_ROW];
+static uint8 *BtldrExt_rowBuffer = BtldrExt_rowBuffers[0u];  /* buffer being filled */
+static uint8  BtldrExt_flashBusy;       /* a background row write is in progress */
+static uint16 BtldrExt_rowOffset;
+static BtldrExt_Burst_T BtldrExt_burst;
+static BtldrExt_Lz_T BtldrExt_lz;
+static uint8  BtldrExt_lzWindow[BTLDR_EXT_LZ_WINDOW];
+static uint16 BtldrExt_rowsSkipped;     /* rows already in flash since ENTER */
+static BtldrExt_RecordRow_T BtldrExt_record;
+static uint8  BtldrExt_journalOpen;     /* BtldrExt_record holds the journal */
+static uint8  BtldrExt_journalDirty;    /* rows committed since the journal was written */
+static uint8  BtldrExt_commStarted;     /* the bus probe left the communication started */
+static BtldrExt_Session_T BtldrExt_session;
+#if (BTLDR_EXT_PROBATION != 0u)
+    static uint16 BtldrExt_swapRecordRow; /* swap record row holding the latest swap record */
+#endif /* (BTLDR_EXT_PROBATION != 0u) */
+
+#if (BTLDR_EXT_PERF_COUNTERS != 0u)
+    static uint32 BtldrExt_flashCycles; /* running total of the flash cycles */
+    static uint32 BtldrExt_waitCycles;  /* waited for the command being received */
+    static uint8  BtldrExt_lastCommand = BTLDR_EXT_NO_COMMAND; /* index of the command last dispatched */
+#endif /* (BTLDR_EXT_PERF_COUNTERS != 0u) */
+
+#if (BTLDR_EXT_CRC_TABLE_SIZE != 0u)
+    #if (BTLDR_EXT_CRC_TABLE_IN_RAM != 0u)
+        static uint32 BtldrExt_crcTable[BTLDR_EXT_CRC_TABLE_SIZE];
+        static uint8  BtldrExt_crcReady;        /* BtldrExt_crcTable is filled */
+    #elif (BTLDR_EXT_CRC_TABLE_SIZE == 256u)
+        static const uint32 BtldrExt_crcTable[256u] =
+        {
+        0x00000000u, 0xF26B8303u, 0xE13B70F7u, 0x1350F3F4u,
+        0xC79A971Fu, 0x35F1141Cu, 0x26A1E7E8u, 0xD4CA64EBu,
+        0x8AD958CFu, 0x78B2DBCCu, 0x6BE22838u, 0x9989AB3Bu,
+        0x4D43CFD0u, 0xBF284CD3u, 0xAC78BF27u, 0x5E133C24u,
+        0x105EC76Fu, 0xE235446Cu, 0xF165B798u, 0x030E349Bu,
+        0xD7C45070u, 0x25AFD373u, 0x36FF2087u, 0xC494A384u,
+        0x9A879FA0u, 0x68EC1CA3u, 0x7BBCEF57u, 0x89D76C54u,
+        0x5D1D08BFu, 0xAF768BBCu, 0xBC267848u, 0x4E4DFB4Bu,
+        0x20BD8EDEu, 0xD2D60DDDu, 0xC186FE29u, 0x33ED7D2Au,
+        0xE72719C1u, 0x154C9AC2u, 0x061C6936u, 0xF477EA35u,
+        0xAA64D611u, 0x580F5512u, 0x4B5FA6E6u, 0xB93425E5u,
+        0x6DFE410Eu, 0x9F95C20Du, 0x8CC531F9u, 0x7EAEB2FAu,
+        0x30E349B1u, 0xC288CAB2u, 0xD1D83946u, 0x23B3BA45u,
+        0xF779DEAEu, 0x05125DADu, 0x1642AE59u, 0xE4292D5Au,
+        0xBA3A117Eu, 0x4851927Du, 0x5B016189u, 0xA96AE28Au,
+        0x7DA08661u, 0x8FCB0562u, 0x9C9BF696u, 0x6EF07595u,
+        0x417B1DBCu, 0xB3109EBFu, 0xA0406D4Bu, 0x522BEE48u,
+        0x86E18AA3u, 0x748A09A0u, 0x67DAFA54u, 0x95B17957u,
+        0xCBA24573u, 0x39C9C670u, 0x2A993584u, 0xD8F2B687u,
+        0x0C38D26Cu, 0xFE53516Fu, 0xED03A29Bu, 0x1F682198u,
+        0x5125DAD3u, 0xA34E59D0u, 0xB01EAA24u, 0x42752927u,
+        0x96BF4DCCu, 0x64D4CECFu, 0x77843D3Bu, 0x85EFBE38u,
+        0xDBFC821Cu, 0x2997011Fu, 0x3AC7F2EBu, 0xC8AC71E8u,
+        0x1C661503u, 0xEE0D9600u, 0xFD5D65F4u, 0x0F36E6F7u,
+        0x61C69362u, 0x93AD1061u, 0x80FDE395u, 0x72966096u,
+        0xA65C047Du, 0x5437877Eu, 0x4767748Au, 0xB50CF789u,
+        0xEB1FCBADu, 0x197448AEu, 0x0A24BB5Au, 0xF84F3859u,
+        0x2C855CB2u, 0xDEEEDFB1u, 0xCDBE2C45u, 0x3FD5AF46u,
+        0x7198540Du, 0x83F3D70Eu, 0x90A324FAu, 0x62C8A7F9u,
+        0xB602C312u, 0x44694011u, 0x5739B3E5u, 0xA55230E6u,
+        0xFB410CC2u, 0x092A8FC1u, 0x1A7A7C35u, 0xE811FF36u,
+        0x3CDB9BDDu, 0xCEB018DEu, 0xDDE0EB2Au, 0x2F8B6829u,
+        0x82F63B78u, 0x709DB87Bu, 0x63CD4B8Fu, 0x91A6C88Cu,
+        0x456CAC67u, 0xB7072F64u, 0xA457DC90u, 0x563C5F93u,
+        0x082F63B7u, 0xFA44E0B4u, 0xE9141340u, 0x1B7F9043u,
+        0xCFB5F4A8u, 0x3DDE77ABu, 0x2E8E845Fu, 0xDCE5075Cu,
+        0x92A8FC17u, 0x60C37F14u, 0x73938CE0u, 0x81F80FE3u,
+        0x55326B08u, 0xA759E80Bu, 0xB4091BFFu, 0x466298FCu,
+        0x1871A4D8u, 0xEA1A27DBu, 0xF94AD42Fu, 0x0B21572Cu,
+        0xDFEB33C7u, 0x2D80B0C4u, 0x3ED04330u, 0xCCBBC033u,
+        0xA24BB5A6u, 0x502036A5u, 0x4370C551u, 0xB11B4652u,
+        0x65D122B9u, 0x97BAA1BAu, 0x84EA524Eu, 0x7681D14Du,
+        0x2892ED69u, 0xDAF96E6Au, 0xC9A99D9Eu, 0x3BC21E9Du,
+        0xEF087A76u, 0x1D63F975u, 0x0E330A81u, 0xFC588982u,
+        0xB21572C9u, 0x407EF1CAu, 0x532E023Eu, 0xA145813Du,
+        0x758FE5D6u, 0x87E466D5u, 0x94B49521u, 0x66DF1622u,
+        0x38CC2A06u, 0xCAA7A905u, 0xD9F75AF1u, 0x2B9CD9F2u,
+        0xFF56BD19u, 0x0D3D3E1Au, 0x1E6DCDEEu, 0xEC064EEDu,
+        0xC38D26C4u, 0x31E6A5C7u, 0x22B65633u, 0xD0DDD530u,
+        0x0417B1DBu, 0xF67C32D8u, 0xE52CC12Cu, 0x1747422Fu,
+        0x49547E0Bu, 0xBB3FFD08u, 0xA86F0EFCu, 0x5A048DFFu,
+        0x8ECEE914u, 0x7CA56A17u, 0x6FF599E3u, 0x9D9E1AE0u,
+        0xD3D3E1ABu, 0x21B862A8u, 0x32E8915Cu, 0xC083125Fu,
+        0x144976B4u, 0xE622F5B7u, 0xF5720643u, 0x07198540u,
+        0x590AB964u, 0xAB613A67u, 0xB831C993u, 0x4A5A4A90u,
+        0x9E902E7Bu, 0x6CFBAD78u, 0x7FAB5E8Cu, 0x8DC0DD8Fu,
+        0xE330A81Au, 0x115B2B19u, 0x020BD8EDu, 0xF0605BEEu,
+        0x24AA3F05u, 0xD6C1BC06u, 0xC5914FF2u, 0x37FACCF1u,
+        0x69E9F0D5u, 0x9B8273D6u, 0x88D28022u, 0x7AB90321u,
+        0xAE7367CAu, 0x5C18E4C9u, 0x4F48173Du, 0xBD23943Eu,
+        0xF36E6F75u, 0x0105EC76u, 0x12551F82u, 0xE03E9C81u,
+        0x34F4F86Au, 0xC69F7B69u, 0xD5CF889Du, 0x27A40B9Eu,
+        0x79B737BAu, 0x8BDCB4B9u, 0x988C474Du, 0x6AE7C44Eu,
+        0xBE2DA0A5u, 0x4C4623A6u, 0x5F16D052u, 0xAD7D5351u
+        };
+    #else
+        static const uint32 BtldrExt_crcTable[16u] =
+        {
+        0x00000000u, 0x105EC76Fu, 0x20BD8EDEu, 0x30E349B1u,
+        0x417B1DBCu, 0x5125DAD3u, 0x61C69362u, 0x7198540Du,
+        0x82F63B78u, 0x92A8FC17u, 0xA24BB5A6u, 0xB21572C9u,
+        0xC38D26C4u, 0xD3D3E1ABu, 0xE330A81Au, 0xF36E6F75u
+        };
+    #endif /* (BTLDR_EXT_CRC_TABLE_IN_RAM != 0u) */
+#endif /* (BTLDR_EXT_CRC_TABLE_SIZE != 0u) */
+
+static void  BtldrExt_Launch(void);
+#if (BTLDR_EXT_MULTI_APP != 0u)
+    static uint8 BtldrExt_SlotResident(void);
+    static uint8 BtldrExt_SelectedApp(void);
+    static void  BtldrExt_LaunchSlotB(void);
+#endif /* (BTLDR_EXT_MULTI_APP != 0u) */
+static uint8 BtldrExt_HostPresent(void);
+static uint8 BtldrExt_CheckRow(uint8 arrayId, uint16 row);
+static uint8 BtldrExt_CheckRows(uint8 arrayId, uint16 firstRow, uint16 rowCount);
+static uint8 BtldrExt_WriteRow(uint8 arrayId, uint16 row, const uint8 rowData[], uint8 background);
+static uint8 BtldrExt_FlashWait(void);
+static uint32 BtldrExt_FlashWriteRow(uint32 row, const uint8 rowData[]);
+#if (BTLDR_EXT_PERF_COUNTERS != 0u)
+    static uint32 BtldrExt_Cycles(uint32 start);
+    static void   BtldrExt_Count(uint8 index, uint32 start, uint32 flashCycles);
+#endif /* (BTLDR_EXT_PERF_COUNTERS != 0u) */
+static void  BtldrExt_ResetState(void);
+static uint32 BtldrExt_CrcStep(uint32 crc);
+static uint32 BtldrExt_SlotHash(uint16 rowCount);
+#if (BTLDR_EXT_PROBATION != 0u)
+    static uint8 BtldrExt_SlotSwap(uint16 first, uint8 rollback, const BtldrExt_SwapRecord_T *resume);
+    static uint8 BtldrExt_SwapRow(uint16 index, uint8 rollback, const BtldrExt_SwapRecord_T *resume);
+    static uint8 BtldrExt_SwapRecord(uint16 index, uint32 hashA, uint32 hashB, uint8 rollback);
+    static const BtldrExt_SwapRecord_T *BtldrExt_SwapLatest(void);
+    static uint8 BtldrExt_ProbationState(void);
+    static void  BtldrExt_ProbationStart(void);
+#endif /* (BTLDR_EXT_PROBATION != 0u) */
+static uint8 BtldrExt_RecordValid(void);
+static void  BtldrExt_SessionAdd(uint16 row, uint32 digest);
+static void  BtldrExt_SessionDrop(uint16 row);
+static void  BtldrExt_ClearRecord(uint16 row, uint32 magic);
+static void  BtldrExt_JournalMark(uint16 row, uint8 committed);
+static void  BtldrExt_JournalWrite(void);
+static void  BtldrExt_BurstCommit(void);
+static void  BtldrExt_BurstWait(void);
+static void  BtldrExt_BurstPut(uint8 value);
+static void  BtldrExt_LzDecode(uint8 value);
+static uint8 BtldrExt_Dispatch(uint8 command, const uint8 data[], uint16 length, uint16 *rspLength);
+static void  BtldrExt_SendResponse(uint8 status, uint16 length);
+
+static uint8 BtldrExt_VerifyChecksum(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength);
+static uint8 BtldrExt_GetFlashSize(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength);
+static uint8 BtldrExt_EraseRow(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength);
+static uint8 BtldrExt_Sync(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength);
+static uint8 BtldrExt_SendData(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength);
+static uint8 BtldrExt_Enter(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength);
+static uint8 BtldrExt_ProgramRow(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength);
+static uint8 BtldrExt_VerifyRow(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength);
+static uint8 BtldrExt_Exit(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength);
+static uint8 BtldrExt_ProgramRows(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength);
+static uint8 BtldrExt_RowsData(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength);
+static uint8 BtldrExt_RowsStatus(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength);
+static uint8 BtldrExt_GetRowHashes(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength);
+static uint8 BtldrExt_OpenJournal(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength);
+static uint8 BtldrExt_VerifyImage(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength);
+#if (BTLDR_EXT_PERF_COUNTERS != 0u)
+    static uint8 BtldrExt_GetCounters(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength);
+#endif /* (BTLDR_EXT_PERF_COUNTERS != 0u) */
+#if (BTLDR_EXT_MULTI_APP != 0u)
+    static uint8 BtldrExt_SelectApp(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength);
+#endif /* (BTLDR_EXT_MULTI_APP != 0u) */
+
+static const BtldrExt_Command_T BtldrExt_commands[] =
+{
+    {BTLDR_EXT_CMD_VERIFY_CHECKSUM, 0u, &BtldrExt_VerifyChecksum},
+    {BTLDR_EXT_CMD_GET_FLASH_SIZE,  1u, &BtldrExt_GetFlashSize},
+    {BTLDR_EXT_CMD_ERASE_ROW,       3u, &BtldrExt_EraseRow},
+    {BTLDR_EXT_CMD_SYNC,            0u, &BtldrExt_Sync},
+    {BTLDR_EXT_CMD_SEND_DATA,       0u, &BtldrExt_SendData},
+    {BTLDR_EXT_CMD_ENTER,           0u, &BtldrExt_Enter},
+    {BTLDR_EXT_CMD_PROGRAM_ROW,     3u, &BtldrExt_ProgramRow},
+    {BTLDR_EXT_CMD_VERIFY_ROW,      3u, &BtldrExt_VerifyRow},
+    {BTLDR_EXT_CMD_EXIT,            0u, &BtldrExt_Exit},
+    {BTLDR_EXT_CMD_PROGRAM_ROWS,    5u, &BtldrExt_ProgramRows},
+    {BTLDR_EXT_CMD_ROWS_DATA,       1u, &BtldrExt_RowsData},
+    {BTLDR_EXT_CMD_ROWS_STATUS,     0u, &BtldrExt_RowsStatus},
+    {BTLDR_EXT_CMD_GET_ROW_HASHES,  4u, &BtldrExt_GetRowHashes},
+    {BTLDR_EXT_CMD_OPEN_JOURNAL,    4u, &BtldrExt_OpenJournal},
+    {BTLDR_EXT_CMD_VERIFY_IMAGE,    6u, &BtldrExt_VerifyImage},
+#if (BTLDR_EXT_PERF_COUNTERS != 0u)
+    {BTLDR_EXT_CMD_GET_COUNTERS,    1u, &BtldrExt_GetCounters},
+#endif /* (BTLDR_EXT_PERF_COUNTERS != 0u) */
+#if (BTLDR_EXT_MULTI_APP != 0u)
+    {BTLDR_EXT_CMD_SELECT_APP,      1u, &BtldrExt_SelectApp},
+#endif /* (BTLDR_EXT_MULTI_APP != 0u) */
+};
+
+#define BTLDR_EXT_NUMBER_OF_COMMANDS    (sizeof(BtldrExt_commands) / sizeof(BtldrExt_commands[0u]))
+
+#if (BTLDR_EXT_PERF_COUNTERS != 0u)
+    static BtldrExt_Counter_T BtldrExt_counters[BTLDR_EXT_NUMBER_OF_COMMANDS];
+#endif /* (BTLDR_EXT_PERF_COUNTERS != 0u) */
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_Start
+********************************************************************************
+*
+* Summary:
+*  Installs a staged image, if any, and launches it. Otherwise serves the
+*  extended host link unless the launch of the bootloadable was scheduled.
+*  On the device a scheduled launch never gets here: CyBtldr_CheckLaunch()
+*  of the reset handler starts the bootloadable before main().
+*  Waits for the host forever when the bootloadable is not valid. When it is
+*  valid, waits for BTLDR_EXT_WAIT_TIME only if the bootloadable requested
+*  the update (Bootloadable_Load() sets the START_BTLDR run type) or a host
+*  writes to the bus during the short probe of a cold boot; otherwise the
+*  bootloadable is started without waiting. If no host shows up, schedules
+*  the bootloadable and resets the device. With BTLDR_EXT_MULTI_APP set,
+*  nothing is installed: the bootloadable is the selected application, and
+*  BtldrExt_Launch() starts the one in slot B in place. A switch requested
+*  by AppSlot_Select() (the BTLDR_EXT_START_SELECT run type) launches it at
+*  once, as an install does.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None. Returns only when the launch of the bootloadable is already
+*  scheduled; Bootloader_Start() then launches it.
+*
+*******************************************************************************/
+void BtldrExt_Start(void)
+{
+    uint8 timeOut = 0u;
+    uint8 valid;
+
+#if (BTLDR_EXT_MULTI_APP == 0u)
+    #if (BTLDR_EXT_PROBATION != 0u)
+        /* A watchdog left armed for a probation must not reset the host link */
+        CySysWdtUnlock();
+        CySysWdtDisable(CY_SYS_WDT_COUNTER0_MASK);
+        CySysWdtLock();
+    #endif /* (BTLDR_EXT_PROBATION != 0u) */
+
+    /* A new image was received by the bootloadable, or the one on probation
+    * failed: switch at once
+    */
+    if((BtldrExt_SlotInstall() != 0u) && (BtldrExt_ValidateApp() != 0u))
+    {
+        BtldrExt_Launch();
+    }
+#endif /* (BTLDR_EXT_MULTI_APP == 0u) */
+
+    if(Bootloader_GET_RUN_TYPE != Bootloader_START_APP)
+    {
+    #if (BTLDR_EXT_MULTI_APP != 0u)
+        valid = (BtldrExt_SelectedApp() == BTLDR_EXT_APP_B) ? 1u : BtldrExt_AppValid();
+    #else
+        valid = BtldrExt_AppValid();
+    #endif /* (BTLDR_EXT_MULTI_APP != 0u) */
+
+        if(valid == 0u)
+        {
+            timeOut = 0u;
+        }
+    #if (BTLDR_EXT_MULTI_APP != 0u)
+        else if(Bootloader_GET_RUN_TYPE == BTLDR_EXT_START_SELECT)
+        {
+            /* The application asked for the switch, not for an update */
+            BtldrExt_Launch();
+        }
+    #endif /* (BTLDR_EXT_MULTI_APP != 0u) */
+        else if((Bootloader_GET_RUN_TYPE == Bootloader_START_BTLDR) || (BtldrExt_HostPresent() != 0u))
+        {
+            timeOut = BTLDR_EXT_WAIT_TIME;
+        }
+        else
+        {
+            /* Cold boot and a quiet bus: no update is coming */
+            BtldrExt_Launch();
+        }
+
+        BtldrExt_HostLink(timeOut);
+
+        /* No host within the wait time: run the bootloadable */
+        BtldrExt_Launch();
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_Launch
+********************************************************************************
+*
+* Summary:
+*  Schedules the bootloadable and resets the device. A new image on
+*  probation is marked launched and the watchdog is armed first: the start
+*  that runs it does not reach BtldrExt_Start(). With BTLDR_EXT_MULTI_APP
+*  set, the application of slot B is started in place when it is selected:
+*  CyBtldr_CheckLaunch() of the reset handler launches slot A only.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None. Does not return.
+*
+*******************************************************************************/
+static void BtldrExt_Launch(void)
+{
+#if (BTLDR_EXT_MULTI_APP != 0u)
+    if(BtldrExt_SelectedApp() == BTLDR_EXT_APP_B)
+    {
+        BtldrExt_LaunchSlotB();
+    }
+#endif /* (BTLDR_EXT_MULTI_APP != 0u) */
+
+#if (BTLDR_EXT_PROBATION != 0u)
+    BtldrExt_ProbationStart();
+#endif /* (BTLDR_EXT_PROBATION != 0u) */
+
+    Bootloader_Exit(Bootloader_EXIT_TO_BTLDB);
+}
+
+#if (BTLDR_EXT_MULTI_APP != 0u)
+/*******************************************************************************
+* Function Name: BtldrExt_SlotResident
+********************************************************************************
+*
+* Summary:
+*  Reports whether slot B holds a committed application. Its hash was
+*  verified when the slot record was written and any host write to slot B
+*  removes the record, so the record alone is checked.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Nonzero if the slot record is valid.
+*
+*******************************************************************************/
+static uint8 BtldrExt_SlotResident(void)
+{
+    const BtldrExt_SlotRecord_T *record =
+        (const BtldrExt_SlotRecord_T *) BTLDR_EXT_ROW_ADDR(BTLDR_EXT_SLOT_RECORD_ROW);
+
+    return (((record->magic == BTLDR_EXT_SLOT_MAGIC) &&
+             (record->check == ~(record->magic ^ record->rowCount ^ record->hash)) &&
+             (record->rowCount != 0u) && (record->rowCount <= BTLDR_EXT_SLOT_ROWS)) ? 1u : 0u);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_SelectedApp
+********************************************************************************
+*
+* Summary:
+*  Reads the select record.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  BTLDR_EXT_APP_B if the record selects slot B and an application is
+*  resident there, otherwise BTLDR_EXT_APP_A.
+*
+*******************************************************************************/
+static uint8 BtldrExt_SelectedApp(void)
+{
+    const BtldrExt_SelectRecord_T *record =
+        (const BtldrExt_SelectRecord_T *) BTLDR_EXT_ROW_ADDR(BTLDR_EXT_SELECT_ROW);
+
+    return (((record->magic == BTLDR_EXT_SELECT_MAGIC) && (record->check == ~(record->magic ^ record->app)) &&
+             (record->app == BTLDR_EXT_APP_B) && (BtldrExt_SlotResident() != 0u)) ? BTLDR_EXT_APP_B : BTLDR_EXT_APP_A);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_LaunchSlotB
+********************************************************************************
+*
+* Summary:
+*  Starts the application of slot B as Bootloader_LaunchApplication() starts
+*  slot A: with the stack pointer and the reset handler of its vector table.
+*  The communication component is stopped by then; the interrupts the
+*  bootloader used are disabled and cleared, so the application finds them
+*  as after a reset.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None. Does not return.
+*
+*******************************************************************************/
+static void BtldrExt_LaunchSlotB(void)
+{
+    const BtldrExt_Vectors_T *vectors = (const BtldrExt_Vectors_T *) BTLDR_EXT_ROW_ADDR(BTLDR_EXT_SLOT_B_ROW);
+
+    CyGlobalIntDisable;
+    CySysTickStop();
+    CY_INT_CLEAR_REG = 0xFFFFFFFFu;
+    CY_INT_CLR_PEND_REG = 0xFFFFFFFFu;
+    __set_MSP(vectors->stackTop);
+    vectors->reset();
+}
+#endif /* (BTLDR_EXT_MULTI_APP != 0u) */
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_HostPresent
+********************************************************************************
+*
+* Summary:
+*  Starts the communication component and watches the I2C slave for a host
+*  write for BTLDR_EXT_PROBE_TIME. A write found is left to the host link,
+*  which then does not restart the component.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Nonzero if a host is writing to the bootloader.
+*
+*******************************************************************************/
+static uint8 BtldrExt_HostPresent(void)
+{
+    uint16 waited;
+
+    CyBtldrCommStart();
+
+    for(waited = 0u; waited < BTLDR_EXT_PROBE_TIME; waited += BTLDR_EXT_PROBE_POLL)
+    {
+        if((I2C_Slave_I2CSlaveStatus() & (I2C_Slave_I2C_SSTAT_WR_BUSY | I2C_Slave_I2C_SSTAT_WR_CMPLT)) != 0u)
+        {
+            BtldrExt_commStarted = 1u;
+            return (1u);
+        }
+        CyDelayUs(BTLDR_EXT_PROBE_POLL);
+    }
+
+    CyBtldrCommStop();
+
+    return (0u);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_HostLink
+********************************************************************************
+*
+* Summary:
+*  Receives the host packets, executes the commands and sends the responses.
+*  Once the first valid packet is received, the wait time is no longer
+*  applied and the link runs until the host sends the Exit command.
+*
+* Parameters:
+*  timeOut: Time to wait for the first valid packet, in 10 ms units. Zero
+*           waits forever.
+*
+* Return:
+*  None. Returns only when the wait time expires.
+*
+*******************************************************************************/
+void BtldrExt_HostLink(uint8 timeOut)
+{
+    uint16 numberRead;
+    uint16 length;
+    uint16 rspLength;
+    uint16 waited = 0u;
+    uint8  hostActive = 0u;
+    uint8  status;
+    cystatus result;
+#if (BTLDR_EXT_PERF_COUNTERS != 0u)
+    uint32 start;
+#endif /* (BTLDR_EXT_PERF_COUNTERS != 0u) */
+
+    BtldrExt_ResetState();
+    if(BtldrExt_commStarted == 0u)
+    {
+        CyBtldrCommStart();
+    }
+    BtldrExt_commStarted = 0u;
+
+#if (BTLDR_EXT_PERF_COUNTERS != 0u)
+    /* Free running on the system clock, read without its interrupt */
+    CySysTickDisableInterrupt();
+    CySysTickSetClockSource(CY_SYS_SYST_CSR_CLK_SRC_SYSCLK);
+    CySysTickSetReload(BTLDR_EXT_CYCLE_MASK);
+    CySysTickClear();
+    CySysTickEnable();
+#endif /* (BTLDR_EXT_PERF_COUNTERS != 0u) */
+
+    for(;;)
+    {
+    #if (BTLDR_EXT_PERF_COUNTERS != 0u)
+        start = CySysTickGetValue();
+    #endif /* (BTLDR_EXT_PERF_COUNTERS != 0u) */
+        result = CyBtldrCommRead(BtldrExt_packet, BTLDR_EXT_SIZEOF_PACKET, &numberRead, BTLDR_EXT_READ_POLL);
+    #if (BTLDR_EXT_PERF_COUNTERS != 0u)
+        BtldrExt_waitCycles += BtldrExt_Cycles(start);
+    #endif /* (BTLDR_EXT_PERF_COUNTERS != 0u) */
+
+        if(result != CYRET_SUCCESS)
+        {
+            waited++;
+            if((hostActive == 0u) && (timeOut != 0u) && (waited >= timeOut))
+            {
+                break;
+            }
+            continue;
+        }
+
+        rspLength = 0u;
+        length = BTLDR_EXT_GET_WORD(&BtldrExt_packet[2u]);
+
+        if((numberRead < BTLDR_EXT_SIZEOF_OVERHEAD) || (BtldrExt_packet[0u] != BTLDR_EXT_SOP))
+        {
+            status = BTLDR_EXT_ERR_DATA;
+        }
+        else if((length > BTLDR_EXT_MAX_DATA_LENGTH) || (numberRead < (length + BTLDR_EXT_SIZEOF_OVERHEAD)))
+        {
+            status = BTLDR_EXT_ERR_LENGTH;
+        }
+        else if(BtldrExt_packet[BTLDR_EXT_SIZEOF_HEADER + length + 2u] != BTLDR_EXT_EOP)
+        {
+            status = BTLDR_EXT_ERR_DATA;
+        }
+        else if(BTLDR_EXT_GET_WORD(&BtldrExt_packet[BTLDR_EXT_SIZEOF_HEADER + length]) !=
+                BtldrExt_PacketChecksum(BtldrExt_packet, BTLDR_EXT_SIZEOF_HEADER + length))
+        {
+            status = BTLDR_EXT_ERR_CHECKSUM;
+        }
+        else
+        {
+            hostActive = 1u;
+            status = BtldrExt_Dispatch(BtldrExt_packet[1u], &BtldrExt_packet[BTLDR_EXT_SIZEOF_HEADER],
+                                       length, &rspLength);
+        }
+
+        /* The burst packets are never answered: the host is not reading. Keep
+        * the first error for the ROWS_STATUS command instead.
+        */
+        if((BtldrExt_packet[1u] == BTLDR_EXT_CMD_PROGRAM_ROWS) ||
+           (BtldrExt_packet[1u] == BTLDR_EXT_CMD_ROWS_DATA))
+        {
+            if((status != BTLDR_EXT_NO_RESPONSE) && (BtldrExt_burst.status == BTLDR_EXT_SUCCESS))
+            {
+                BtldrExt_burst.status = status;
+            }
+            status = BTLDR_EXT_NO_RESPONSE;
+        }
+
+        if(status != BTLDR_EXT_NO_RESPONSE)
+        {
+        #if (BTLDR_EXT_PERF_COUNTERS != 0u)
+            start = CySysTickGetValue();
+            BtldrExt_SendResponse(status, rspLength);
+            if(BtldrExt_lastCommand != BTLDR_EXT_NO_COMMAND)
+            {
+                BtldrExt_counters[BtldrExt_lastCommand].waitCycles += BtldrExt_Cycles(start);
+            }
+        #else
+            BtldrExt_SendResponse(status, rspLength);
+        #endif /* (BTLDR_EXT_PERF_COUNTERS != 0u) */
+        }
+    }
+
+    CyBtldrCommStop();
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_PacketChecksum
+********************************************************************************
+*
+* Summary:
+*  Computes the basic summation checksum of a packet: the two's complement of
+*  the 16-bit sum of all bytes from SOP to the end of the data.
+*
+* Parameters:
+*  buffer: Packet starting with SOP.
+*  size:   Number of bytes covered by the checksum.
+*
+* Return:
+*  The packet checksum.
+*
+*******************************************************************************/
+uint16 BtldrExt_PacketChecksum(const uint8 buffer[], uint16 size)
+{
+    uint16 sum = 0u;
+    uint16 i;
+
+    for(i = 0u; i < size; i++)
+    {
+        sum += buffer[i];
+    }
+
+    return ((uint16)(1u + (uint16)(~sum)));
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_RowHash
+********************************************************************************
+*
+* Summary:
+*  Computes the CRC-32C of one flash row. The host computes the same hash
+*  over the rows of the new image to find the rows that changed.
+*
+* Parameters:
+*  rowData: CY_FLASH_SIZEOF_ROW bytes.
+*
+* Return:
+*  The row hash.
+*
+*******************************************************************************/
+uint32 BtldrExt_RowHash(const uint8 rowData[])
+{
+    return (BtldrExt_Crc32(BTLDR_EXT_CRC_INIT, rowData, CY_FLASH_SIZEOF_ROW));
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_RowDigest
+********************************************************************************
+*
+* Summary:
+*  Computes the CRC-32C of the row number, LSB first, followed by the row
+*  data. The sum of the digests of the rows programmed is the image hash of
+*  the VERIFY_IMAGE command; the row number makes it depend on where each
+*  row went, not only on what was sent.
+*
+* Parameters:
+*  row:     Row number within the array.
+*  rowData: CY_FLASH_SIZEOF_ROW bytes.
+*
+* Return:
+*  The row digest.
+*
+*******************************************************************************/
+uint32 BtldrExt_RowDigest(uint16 row, const uint8 rowData[])
+{
+    uint8 rowId[2u];
+
+    BTLDR_EXT_SET_WORD(rowId, row);
+
+    return (BtldrExt_Crc32(BtldrExt_Crc32(BTLDR_EXT_CRC_INIT, rowId, 2u), rowData, CY_FLASH_SIZEOF_ROW));
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_Crc32
+********************************************************************************
+*
+* Summary:
+*  Continues a CRC-32C over a block of bytes. Word aligned data, as a flash
+*  row, is read a word at a time; the CPU is little endian, so the bytes of
+*  a word enter the reflected CRC in memory order. The host tools compute the
+*  same CRC with BtldrCrc_Update().
+*
+* Parameters:
+*  crc:  CRC of the previous bytes, BTLDR_EXT_CRC_INIT for the first block.
+*  data: Bytes to check.
+*  size: Number of bytes.
+*
+* Return:
+*  The updated CRC.
+*
+*******************************************************************************/
+uint32 BtldrExt_Crc32(uint32 crc, const uint8 data[], uint16 size)
+{
+    const uint8 *next = data;
+    uint16 left = size;
+#if ((BTLDR_EXT_CRC_TABLE_SIZE != 0u) && (BTLDR_EXT_CRC_TABLE_IN_RAM != 0u))
+    uint32 entry;
+    uint8 bit;
+    uint16 i;
+
+    if(BtldrExt_crcReady == 0u)
+    {
+        for(i = 0u; i < BTLDR_EXT_CRC_TABLE_SIZE; i++)
+        {
+            entry = i;
+            for(bit = 0u; bit < BTLDR_EXT_CRC_TABLE_BITS; bit++)
+            {
+                entry = (entry >> 1u) ^ (BTLDR_EXT_CRC_POLY & (0u - (entry & 1u)));
+            }
+            BtldrExt_crcTable[i] = entry;
+        }
+        BtldrExt_crcReady = 1u;
+    }
+#endif /* ((BTLDR_EXT_CRC_TABLE_SIZE != 0u) && (BTLDR_EXT_CRC_TABLE_IN_RAM != 0u)) */
+
+    crc = ~crc;
+
+    while((left != 0u) && ((((size_t) next) & 3u) != 0u))
+    {
+        crc = BtldrExt_CrcStep(crc ^ *next);
+        next++;
+        left--;
+    }
+
+    while(left >= 4u)
+    {
+        crc ^= *(const uint32 *)(const void *) next;
+        crc = BtldrExt_CrcStep(BtldrExt_CrcStep(BtldrExt_CrcStep(BtldrExt_CrcStep(crc))));
+        next += 4u;
+        left -= 4u;
+    }
+
+    while(left != 0u)
+    {
+        crc = BtldrExt_CrcStep(crc ^ *next);
+        next++;
+        left--;
+    }
+
+    return (~crc);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_CrcStep
+********************************************************************************
+*
+* Summary:
+*  Moves the CRC register past the eight bits in its low byte, with the
+*  table selected by BTLDR_EXT_CRC_TABLE_SIZE.
+*
+*******************************************************************************/
+static uint32 BtldrExt_CrcStep(uint32 crc)
+{
+#if (BTLDR_EXT_CRC_TABLE_SIZE == 256u)
+    crc = (crc >> 8u) ^ BtldrExt_crcTable[crc & 0xFFu];
+#elif (BTLDR_EXT_CRC_TABLE_SIZE == 16u)
+    crc = (crc >> 4u) ^ BtldrExt_crcTable[crc & 0x0Fu];
+    crc = (crc >> 4u) ^ BtldrExt_crcTable[crc & 0x0Fu];
+#else
+    uint8 bit;
+
+    for(bit = 0u; bit < 8u; bit++)
+    {
+        crc = (crc >> 1u) ^ (BTLDR_EXT_CRC_POLY & (0u - (crc & 1u)));
+    }
+#endif /* (BTLDR_EXT_CRC_TABLE_SIZE == 256u) */
+
+    return (crc);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_SlotInstall
+********************************************************************************
+*
+* Summary:
+*  Copies the image staged in slot B and its metadata row over slot A when
+*  the slot record is valid and the staged rows match its hash, then clears
+*  the record. A record that does not match is cleared without a copy. The
+*  copy is restarted from the beginning if it is interrupted by a reset.
+*  With BTLDR_EXT_PROBATION_TIME set, the slots are swapped instead and the
+*  new image is put on probation; an image on probation that was launched
+*  and has not confirmed its health is swapped back out, and an interrupted
+*  swap is resumed.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Nonzero if a staged image was installed or the previous one restored.
+*
+*******************************************************************************/
+uint8 BtldrExt_SlotInstall(void)
+{
+    const BtldrExt_SlotRecord_T *record =
+        (const BtldrExt_SlotRecord_T *) BTLDR_EXT_ROW_ADDR(BTLDR_EXT_SLOT_RECORD_ROW);
+    uint8 installed = 0u;
+#if (BTLDR_EXT_PROBATION != 0u)
+    const BtldrExt_SwapRecord_T *swap = BtldrExt_SwapLatest();
+    uint8 state = BtldrExt_ProbationState();
+
+    /* A probation record written after the last swap record ends the swap;
+    * only the start of a rollback leaves a launched image's record in place
+    */
+    if((swap != NULL) && (state != BTLDR_EXT_PROBATION_NONE) && (state != BTLDR_EXT_PROBATION_LAUNCHED))
+    {
+        BtldrExt_ClearRecord(BTLDR_EXT_SWAP_ROW, BTLDR_EXT_SWAP_MAGIC);
+        swap = NULL;
+    }
+
+    if(swap != NULL)
+    {
+        /* The reset interrupted a swap */
+        installed = BtldrExt_SlotSwap((uint16) swap->row, (uint8) swap->rollback, swap);
+    }
+    else if(state == BTLDR_EXT_PROBATION_LAUNCHED)
+    {
+        /* The new image did not confirm its health before this start */
+        installed = BtldrExt_SlotSwap(0u, 1u, NULL);
+    }
+    else if(state == BTLDR_EXT_PROBATION_ROLLED)
+    {
+        BtldrExt_ClearRecord(BTLDR_EXT_SLOT_RECORD_ROW, BTLDR_EXT_PROBATION_MAGIC);
+    }
+    else
+#else
+    uint16 i;
+#endif /* (BTLDR_EXT_PROBATION != 0u) */
+
+    if(record->magic == BTLDR_EXT_SLOT_MAGIC)
+    {
+        if((record->check != ~(record->magic ^ record->rowCount ^ record->hash)) ||
+           (record->rowCount == 0u) || (record->rowCount > BTLDR_EXT_SLOT_ROWS) ||
+           (BtldrExt_SlotHash((uint16) record->rowCount) != record->hash))
+        {
+            BtldrExt_ClearRecord(BTLDR_EXT_SLOT_RECORD_ROW, BTLDR_EXT_SLOT_MAGIC);
+        }
+        else
+        {
+            /* The cached checksum result and the progress of an update
+            * belong to the old image
+            */
+            BtldrExt_ClearRecord(BTLDR_EXT_VALID_ROW, BTLDR_EXT_VALID_MAGIC);
+            BtldrExt_ClearRecord(BTLDR_EXT_JOURNAL_ROW, BTLDR_EXT_JOURNAL_MAGIC);
+
+        #if (BTLDR_EXT_PROBATION != 0u)
+            installed = BtldrExt_SlotSwap(0u, 0u, NULL);
+        #else
+            installed = 1u;
+            for(i = 0u; (i <= record->rowCount) && (installed != 0u); i++)
+            {
+                /* The last step copies the metadata row */
+                if(i < record->rowCount)
+                {
+                    (void) memcpy(BtldrExt_rowBuffer, BTLDR_EXT_ROW_ADDR(BTLDR_EXT_SLOT_B_ROW + i),
+                                  CY_FLASH_SIZEOF_ROW);
+                    installed = (CySysFlashWriteRow((uint32) BTLDR_EXT_FIRST_APP_ROW + i, BtldrExt_rowBuffer) ==
+                                 CY_SYS_FLASH_SUCCESS) ? 1u : 0u;
+                }
+                else
+                {
+                    (void) memcpy(BtldrExt_rowBuffer, BTLDR_EXT_ROW_ADDR(BTLDR_EXT_SLOT_META_ROW),
+                                  CY_FLASH_SIZEOF_ROW);
+                    installed = (CySysFlashWriteRow((uint32) BTLDR_EXT_META_ROW, BtldrExt_rowBuffer) ==
+                                 CY_SYS_FLASH_SUCCESS) ? 1u : 0u;
+                }
+            }
+
+            /* A failed copy is retried on the next start */
+            if(installed != 0u)
+            {
+                BtldrExt_ClearRecord(BTLDR_EXT_SLOT_RECORD_ROW, BTLDR_EXT_SLOT_MAGIC);
+            }
+        #endif /* (BTLDR_EXT_PROBATION != 0u) */
+        }
+    }
+
+    return (installed);
+}
+
+#if (BTLDR_EXT_PROBATION != 0u)
+/*******************************************************************************
+* Function Name: BtldrExt_SlotSwap
+********************************************************************************
+*
+* Summary:
+*  Swaps the rows of slot A and slot B, the metadata rows last. Rows that
+*  are the same in both slots are skipped; each row that differs costs four
+*  row writes. The swap records alternate between the slot record row and
+*  BTLDR_EXT_SWAP_ROW, so a record torn by a reset leaves the one before it.
+*  Once the rows are swapped, the slot record row takes the probation record
+*  of the image swapped in, or of the rollback, and then the swap record
+*  that is left is cleared, followed by the probation record of a rollback.
+*
+* Parameters:
+*  first:    Row of the slot to start with, above BTLDR_EXT_SLOT_ROWS when
+*            only the final records are left.
+*  rollback: The swap restores the previous image.
+*  resume:   Latest swap record of a swap interrupted by a reset, or NULL.
+*
+* Return:
+*  Nonzero if the slots were swapped. A failed swap is resumed on the next
+*  start.
+*
+*******************************************************************************/
+static uint8 BtldrExt_SlotSwap(uint16 first, uint8 rollback, const BtldrExt_SwapRecord_T *resume)
+{
+    uint8 swapped = 1u;
+    uint16 i;
+
+    /* A new swap keeps the record that started it until its first record is
+    * written
+    */
+    if(resume == NULL)
+    {
+        BtldrExt_swapRecordRow = BTLDR_EXT_SLOT_RECORD_ROW;
+    }
+
+    for(i = first; (i <= BTLDR_EXT_SLOT_ROWS) && (swapped != 0u); i++)
+    {
+        swapped = BtldrExt_SwapRow(i, rollback, (i == first) ? resume : NULL);
+    }
+
+    /* The probation record must not overwrite the only swap record */
+    if((swapped != 0u) && (BtldrExt_swapRecordRow == BTLDR_EXT_SLOT_RECORD_ROW))
+    {
+        swapped = BtldrExt_SwapRecord(BTLDR_EXT_SLOT_ROWS + 1u, 0u, 0u, rollback);
+    }
+
+    if(swapped != 0u)
+    {
+        (void) memset(BtldrExt_record.row, 0, CY_FLASH_SIZEOF_ROW);
+        BtldrExt_record.probation.magic = BTLDR_EXT_PROBATION_MAGIC;
+        BtldrExt_record.probation.state = (rollback != 0u) ? BTLDR_EXT_PROBATION_ROLLED : BTLDR_EXT_PROBATION_NEW;
+        BtldrExt_record.probation.check = ~(BtldrExt_record.probation.magic ^ BtldrExt_record.probation.state);
+        swapped = (BtldrExt_FlashWriteRow((uint32) BTLDR_EXT_SLOT_RECORD_ROW, BtldrExt_record.row) ==
+                   CY_SYS_FLASH_SUCCESS) ? 1u : 0u;
+    }
+
+    if(swapped != 0u)
+    {
+        BtldrExt_ClearRecord(BTLDR_EXT_SWAP_ROW, BTLDR_EXT_SWAP_MAGIC);
+        if(rollback != 0u)
+        {
+            BtldrExt_ClearRecord(BTLDR_EXT_SLOT_RECORD_ROW, BTLDR_EXT_PROBATION_MAGIC);
+        }
+    }
+
+    return (swapped);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_SwapRow
+********************************************************************************
+*
+* Summary:
+*  Swaps one row of slot A with the same row of slot B: writes the swap
+*  record of the row, saves the slot A row to the validity record row,
+*  programs it from slot B and restores the saved row to slot B. When the
+*  swap of the row was interrupted, the hashes of the swap record tell the
+*  step to resume from.
+*
+* Parameters:
+*  index:    Row of the slot, BTLDR_EXT_SLOT_ROWS for the metadata row.
+*  rollback: Kept in the swap record.
+*  resume:   Swap record of this row left by a reset, or NULL.
+*
+* Return:
+*  Nonzero if the row was swapped.
+*
+*******************************************************************************/
+static uint8 BtldrExt_SwapRow(uint16 index, uint8 rollback, const BtldrExt_SwapRecord_T *resume)
+{
+    uint16 rowA = (index < BTLDR_EXT_SLOT_ROWS) ? (BTLDR_EXT_FIRST_APP_ROW + index) : BTLDR_EXT_META_ROW;
+    uint16 rowB = (index < BTLDR_EXT_SLOT_ROWS) ? (BTLDR_EXT_SLOT_B_ROW + index) : BTLDR_EXT_SLOT_META_ROW;
+    uint8 step = BTLDR_EXT_SWAP_SAVE;
+    uint8 done = 1u;
+
+    if(resume != NULL)
+    {
+        /* The row of slot A is written only once it is saved and the row of
+        * slot B only once slot A holds it
+        */
+        if(BtldrExt_RowHash(BTLDR_EXT_ROW_ADDR(rowA)) == resume->hashB)
+        {
+            step = BTLDR_EXT_SWAP_SAVE;
+        }
+        else if(BtldrExt_RowHash(BTLDR_EXT_ROW_ADDR(rowB)) == resume->hashB)
+        {
+            step = BTLDR_EXT_SWAP_DONE;
+        }
+        else if(BtldrExt_RowHash(BTLDR_EXT_ROW_ADDR(rowA)) == resume->hashA)
+        {
+            step = BTLDR_EXT_SWAP_RESTORE;
+        }
+        else
+        {
+            step = BTLDR_EXT_SWAP_MOVE;
+        }
+    }
+    else if(memcmp(BTLDR_EXT_ROW_ADDR(rowA), BTLDR_EXT_ROW_ADDR(rowB), CY_FLASH_SIZEOF_ROW) == 0)
+    {
+        step = BTLDR_EXT_SWAP_DONE;
+    }
+    else
+    {
+        /* Swap from the first step */
+    }
+
+    if(step == BTLDR_EXT_SWAP_SAVE)
+    {
+        done = BtldrExt_SwapRecord(index, BtldrExt_RowHash(BTLDR_EXT_ROW_ADDR(rowB)),
+                                   BtldrExt_RowHash(BTLDR_EXT_ROW_ADDR(rowA)), rollback);
+        if(done != 0u)
+        {
+            (void) memcpy(BtldrExt_rowBuffer, BTLDR_EXT_ROW_ADDR(rowA), CY_FLASH_SIZEOF_ROW);
+            done = (BtldrExt_FlashWriteRow((uint32) BTLDR_EXT_VALID_ROW, BtldrExt_rowBuffer) ==
+                    CY_SYS_FLASH_SUCCESS) ? 1u : 0u;
+        }
+    }
+
+    if((done != 0u) && (step <= BTLDR_EXT_SWAP_MOVE))
+    {
+        (void) memcpy(BtldrExt_rowBuffer, BTLDR_EXT_ROW_ADDR(rowB), CY_FLASH_SIZEOF_ROW);
+        done = (BtldrExt_FlashWriteRow((uint32) rowA, BtldrExt_rowBuffer) == CY_SYS_FLASH_SUCCESS) ? 1u : 0u;
+    }
+
+    if((done != 0u) && (step <= BTLDR_EXT_SWAP_RESTORE))
+    {
+        (void) memcpy(BtldrExt_rowBuffer, BTLDR_EXT_ROW_ADDR(BTLDR_EXT_VALID_ROW), CY_FLASH_SIZEOF_ROW);
+        done = (BtldrExt_FlashWriteRow((uint32) rowB, BtldrExt_rowBuffer) == CY_SYS_FLASH_SUCCESS) ? 1u : 0u;
+    }
+
+    return (done);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_SwapRecord
+********************************************************************************
+*
+* Summary:
+*  Writes a swap record to the one of the two swap record rows that does
+*  not hold the latest.
+*
+* Parameters:
+*  index:    Row of the slot being swapped.
+*  hashA:    BtldrExt_RowHash() of the row going to slot A.
+*  hashB:    BtldrExt_RowHash() of the row going to slot B.
+*  rollback: The swap restores the previous image.
+*
+* Return:
+*  Nonzero if the record was written.
+*
+*******************************************************************************/
+static uint8 BtldrExt_SwapRecord(uint16 index, uint32 hashA, uint32 hashB, uint8 rollback)
+{
+    uint16 row = (BtldrExt_swapRecordRow == BTLDR_EXT_SLOT_RECORD_ROW) ? BTLDR_EXT_SWAP_ROW :
+                                                                         BTLDR_EXT_SLOT_RECORD_ROW;
+    uint8 written = 0u;
+
+    BtldrExt_journalOpen = 0u;
+    (void) memset(BtldrExt_record.row, 0, CY_FLASH_SIZEOF_ROW);
+    BtldrExt_record.swap.magic = BTLDR_EXT_SWAP_MAGIC;
+    BtldrExt_record.swap.row = index;
+    BtldrExt_record.swap.hashA = hashA;
+    BtldrExt_record.swap.hashB = hashB;
+    BtldrExt_record.swap.rollback = rollback;
+    BtldrExt_record.swap.check = BtldrExt_Crc32(BTLDR_EXT_CRC_INIT, BtldrExt_record.row,
+                                                (uint16) offsetof(BtldrExt_SwapRecord_T, check));
+
+    if(BtldrExt_FlashWriteRow((uint32) row, BtldrExt_record.row) == CY_SYS_FLASH_SUCCESS)
+    {
+        BtldrExt_swapRecordRow = row;
+        written = 1u;
+    }
+
+    return (written);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_SwapLatest
+********************************************************************************
+*
+* Summary:
+*  Finds the latest valid swap record: the one of the two swap record rows
+*  that names the later row of the slot.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The swap record, or NULL when neither row holds one.
+*
+*******************************************************************************/
+static const BtldrExt_SwapRecord_T *BtldrExt_SwapLatest(void)
+{
+    const BtldrExt_SwapRecord_T *latest = NULL;
+    const BtldrExt_SwapRecord_T *record;
+    uint16 row = BTLDR_EXT_SLOT_RECORD_ROW;
+    uint8 i;
+
+    for(i = 0u; i < 2u; i++)
+    {
+        record = (const BtldrExt_SwapRecord_T *) BTLDR_EXT_ROW_ADDR(row);
+        if((record->magic == BTLDR_EXT_SWAP_MAGIC) &&
+           (record->check == BtldrExt_Crc32(BTLDR_EXT_CRC_INIT, (const uint8 *) record,
+                                            (uint16) offsetof(BtldrExt_SwapRecord_T, check))) &&
+           ((latest == NULL) || (record->row > latest->row)))
+        {
+            latest = record;
+            BtldrExt_swapRecordRow = row;
+        }
+        row = BTLDR_EXT_SWAP_ROW;
+    }
+
+    return (latest);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_ProbationState
+********************************************************************************
+*
+* Summary:
+*  Reads the probation record from the slot record row.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The state of the probation record, or BTLDR_EXT_PROBATION_NONE.
+*
+*******************************************************************************/
+static uint8 BtldrExt_ProbationState(void)
+{
+    const BtldrExt_ProbationRecord_T *record =
+        (const BtldrExt_ProbationRecord_T *) BTLDR_EXT_ROW_ADDR(BTLDR_EXT_SLOT_RECORD_ROW);
+
+    return (((record->magic == BTLDR_EXT_PROBATION_MAGIC) && (record->check == ~(record->magic ^ record->state)) &&
+             (record->state <= BTLDR_EXT_PROBATION_ROLLED)) ? (uint8) record->state : BTLDR_EXT_PROBATION_NONE);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_ProbationStart
+********************************************************************************
+*
+* Summary:
+*  Marks a new image on probation as launched and arms watchdog counter 0 to
+*  reset the device after BTLDR_EXT_PROBATION_TIME. Called right before the
+*  launch is scheduled; the watchdog keeps counting through the software
+*  reset that launches the image. The image stops the watchdog when it
+*  confirms its health; the next start of a launched image that did not
+*  confirm, including one cut short by a power loss before the image ran,
+*  rolls it back.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void BtldrExt_ProbationStart(void)
+{
+    if(BtldrExt_ProbationState() == BTLDR_EXT_PROBATION_NEW)
+    {
+        BtldrExt_journalOpen = 0u;
+        (void) memset(BtldrExt_record.row, 0, CY_FLASH_SIZEOF_ROW);
+        BtldrExt_record.probation.magic = BTLDR_EXT_PROBATION_MAGIC;
+        BtldrExt_record.probation.state = BTLDR_EXT_PROBATION_LAUNCHED;
+        BtldrExt_record.probation.check = ~(BtldrExt_record.probation.magic ^ BtldrExt_record.probation.state);
+        (void) BtldrExt_FlashWriteRow((uint32) BTLDR_EXT_SLOT_RECORD_ROW, BtldrExt_record.row);
+
+        CySysWdtUnlock();
+        CySysWdtWriteMode(CY_SYS_WDT_COUNTER0, CY_SYS_WDT_MODE_RESET);
+        CySysWdtWriteMatch(CY_SYS_WDT_COUNTER0, BTLDR_EXT_PROBATION_TICKS);
+        CySysWdtWriteClearOnMatch(CY_SYS_WDT_COUNTER0, 1u);
+        CySysWdtResetCounters(CY_SYS_WDT_COUNTER0_RESET);
+        CySysWdtEnable(CY_SYS_WDT_COUNTER0_MASK);
+        CySysWdtLock();
+    }
+}
+#endif /* (BTLDR_EXT_PROBATION != 0u) */
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_SlotHash
+********************************************************************************
+*
+* Summary:
+*  Computes the CRC-32C of the rows staged in slot B followed by the
+*  staged metadata row.
+*
+* Parameters:
+*  rowCount: Number of application rows staged.
+*
+* Return:
+*  The image hash.
+*
+*******************************************************************************/
+static uint32 BtldrExt_SlotHash(uint16 rowCount)
+{
+    const uint8 *rowData;
+    uint32 hash = BTLDR_EXT_CRC_INIT;
+    uint16 row;
+
+    for(row = 0u; row <= rowCount; row++)
+    {
+        rowData = (row < rowCount) ? BTLDR_EXT_ROW_ADDR(BTLDR_EXT_SLOT_B_ROW + row) :
+                                     BTLDR_EXT_ROW_ADDR(BTLDR_EXT_SLOT_META_ROW);
+        hash = BtldrExt_Crc32(hash, rowData, CY_FLASH_SIZEOF_ROW);
+    }
+
+    return (hash);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_ClearRecord
+********************************************************************************
+*
+* Summary:
+*  Erases a record row if it holds a record. Closes the journal.
+*
+* Parameters:
+*  row:   Record row.
+*  magic: Magic number of the record.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void BtldrExt_ClearRecord(uint16 row, uint32 magic)
+{
+    if(*(const uint32 *) BTLDR_EXT_ROW_ADDR(row) == magic)
+    {
+        BtldrExt_journalOpen = 0u;
+        (void) memset(BtldrExt_record.row, 0, CY_FLASH_SIZEOF_ROW);
+        (void) BtldrExt_FlashWriteRow((uint32) row, BtldrExt_record.row);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_AppValid
+********************************************************************************
+*
+* Summary:
+*  Reports whether the bootloadable is valid. A validity record that matches
+*  the metadata row is trusted, so a normal start costs one row hash instead
+*  of the checksum of the whole application. Without a matching record the
+*  full check of BtldrExt_ValidateApp() runs.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Nonzero if the bootloadable is valid.
+*
+*******************************************************************************/
+uint8 BtldrExt_AppValid(void)
+{
+    const BtldrExt_ValidRecord_T *record =
+        (const BtldrExt_ValidRecord_T *) BTLDR_EXT_ROW_ADDR(BTLDR_EXT_VALID_ROW);
+    uint8 valid;
+
+    if((record->magic == BTLDR_EXT_VALID_MAGIC) && (record->check == ~(record->magic ^ record->metaHash)) &&
+       (record->metaHash == BtldrExt_RowHash(BTLDR_EXT_ROW_ADDR(BTLDR_EXT_META_ROW))))
+    {
+        valid = 1u;
+    }
+    else
+    {
+        valid = BtldrExt_ValidateApp();
+    }
+
+    return (valid);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_ValidateApp
+********************************************************************************
+*
+* Summary:
+*  Validates the checksum of the whole bootloadable and, when it passes,
+*  writes the validity record unless it is already current. The record
+*  replaces the progress journal of the update that installed the image.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  Nonzero if the bootloadable is valid.
+*
+*******************************************************************************/
+uint8 BtldrExt_ValidateApp(void)
+{
+    uint8 valid = 0u;
+
+    BtldrExt_journalOpen = 0u;
+
+    if(Bootloader_ValidateBootloadable(Bootloader_MD_BTLDB_ACTIVE_0) == CYRET_SUCCESS)
+    {
+        valid = BtldrExt_RecordValid();
+    }
+
+    return (valid);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_RecordValid
+********************************************************************************
+*
+* Summary:
+*  Writes the validity record of the bootloadable, once it has been
+*  validated, unless the record is already current.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  1u, the bootloadable is valid.
+*
+*******************************************************************************/
+static uint8 BtldrExt_RecordValid(void)
+{
+    const BtldrExt_ValidRecord_T *record =
+        (const BtldrExt_ValidRecord_T *) BTLDR_EXT_ROW_ADDR(BTLDR_EXT_VALID_ROW);
+    BtldrExt_ValidRecord_T update;
+
+    BtldrExt_journalOpen = 0u;
+
+    update.magic = BTLDR_EXT_VALID_MAGIC;
+    update.metaHash = BtldrExt_RowHash(BTLDR_EXT_ROW_ADDR(BTLDR_EXT_META_ROW));
+    update.check = ~(update.magic ^ update.metaHash);
+
+    if((record->magic != update.magic) || (record->metaHash != update.metaHash) ||
+       (record->check != update.check))
+    {
+        (void) memset(BtldrExt_record.row, 0, CY_FLASH_SIZEOF_ROW);
+        BtldrExt_record.valid = update;
+        (void) BtldrExt_FlashWriteRow((uint32) BTLDR_EXT_VALID_ROW, BtldrExt_record.row);
+    }
+
+    return (1u);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_Dispatch
+********************************************************************************
+*
+* Summary:
+*  Looks up the command in the command table and executes it. Every command
+*  but ROWS_DATA first waits for the row of the burst still being programmed,
+*  so that it sees the flash as written. The wait is counted in the cycles of
+*  the command.
+*
+* Parameters:
+*  command:   Command code of the packet.
+*  data:      Packet data.
+*  length:    Packet data length.
+*  rspLength: Length of the response data written by the handler.
+*
+* Return:
+*  Status for the response or BTLDR_EXT_NO_RESPONSE.
+*
+*******************************************************************************/
+static uint8 BtldrExt_Dispatch(uint8 command, const uint8 data[], uint16 length, uint16 *rspLength)
+{
+    uint8 status = BTLDR_EXT_ERR_CMD;
+    uint8 i;
+#if (BTLDR_EXT_PERF_COUNTERS != 0u)
+    uint32 start = CySysTickGetValue();
+    uint32 flashCycles = BtldrExt_flashCycles;
+
+    BtldrExt_lastCommand = BTLDR_EXT_NO_COMMAND;
+#endif /* (BTLDR_EXT_PERF_COUNTERS != 0u) */
+
+    if(command != BTLDR_EXT_CMD_ROWS_DATA)
+    {
+        BtldrExt_BurstWait();
+    }
+
+    for(i = 0u; i < BTLDR_EXT_NUMBER_OF_COMMANDS; i++)
+    {
+        if(BtldrExt_commands[i].command == command)
+        {
+            if(length < BtldrExt_commands[i].minLength)
+            {
+                status = BTLDR_EXT_ERR_LENGTH;
+            }
+            else
+            {
+                status = BtldrExt_commands[i].handler(data, length,
+                                                      &BtldrExt_response[BTLDR_EXT_SIZEOF_HEADER], rspLength);
+            }
+        #if (BTLDR_EXT_PERF_COUNTERS != 0u)
+            BtldrExt_Count(i, start, flashCycles);
+        #endif /* (BTLDR_EXT_PERF_COUNTERS != 0u) */
+            break;
+        }
+    }
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_SendResponse
+********************************************************************************
+*
+* Summary:
+*  Frames the response data already placed in the response buffer and hands it
+*  to the communication component.
+*
+* Parameters:
+*  status: Status byte of the response.
+*  length: Response data length.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void BtldrExt_SendResponse(uint8 status, uint16 length)
+{
+    uint16 checksum;
+    uint16 numberWritten;
+
+    BtldrExt_response[0u] = BTLDR_EXT_SOP;
+    BtldrExt_response[1u] = status;
+    BTLDR_EXT_SET_WORD(&BtldrExt_response[2u], length);
+
+    checksum = BtldrExt_PacketChecksum(BtldrExt_response, BTLDR_EXT_SIZEOF_HEADER + length);
+    BTLDR_EXT_SET_WORD(&BtldrExt_response[BTLDR_EXT_SIZEOF_HEADER + length], checksum);
+    BtldrExt_response[BTLDR_EXT_SIZEOF_HEADER + length + 2u] = BTLDR_EXT_EOP;
+
+    (void) CyBtldrCommWrite(BtldrExt_response, length + BTLDR_EXT_SIZEOF_OVERHEAD, &numberWritten,
+                            BTLDR_EXT_RESPONSE_TIMEOUT);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_ResetState
+********************************************************************************
+*
+* Summary:
+*  Drops the staged row data and any open burst.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void BtldrExt_ResetState(void)
+{
+    BtldrExt_rowOffset = 0u;
+    BtldrExt_burst.rowsLeft = 0u;
+    BtldrExt_burst.rowsDone = 0u;
+    BtldrExt_burst.pending = 0u;
+    BtldrExt_burst.sequence = 0u;
+    BtldrExt_burst.encoding = BTLDR_EXT_ENCODING_RAW;
+    BtldrExt_burst.status = BTLDR_EXT_SUCCESS;
+
+    BtldrExt_lz.flagsLeft = 0u;
+    BtldrExt_lz.state = BTLDR_EXT_LZ_ITEM;
+    BtldrExt_lz.position = 0u;
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_BurstCommit
+********************************************************************************
+*
+* Summary:
+*  Programs the completed row buffer to the next row of the burst, in the
+*  background when BTLDR_EXT_BACKGROUND_WRITE is set. The previous row is
+*  committed first.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void BtldrExt_BurstCommit(void)
+{
+    BtldrExt_BurstWait();
+
+    if(BtldrExt_burst.status == BTLDR_EXT_SUCCESS)
+    {
+        BtldrExt_burst.status = BtldrExt_WriteRow(BtldrExt_burst.arrayId, BtldrExt_burst.nextRow,
+                                                  BtldrExt_rowBuffer, 1u);
+    }
+    if(BtldrExt_burst.status == BTLDR_EXT_SUCCESS)
+    {
+        BtldrExt_burst.pendingRow = BtldrExt_burst.nextRow;
+        BtldrExt_burst.pending = 1u;
+        BtldrExt_burst.nextRow++;
+        BtldrExt_burst.rowsLeft--;
+    }
+    BtldrExt_rowOffset = 0u;
+
+    /* Without a background write the row is already programmed */
+    if(BtldrExt_flashBusy == 0u)
+    {
+        BtldrExt_BurstWait();
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_BurstWait
+********************************************************************************
+*
+* Summary:
+*  Waits until the last row started by the burst is programmed and commits
+*  it: the row is counted and recorded in the journal only once it is in
+*  flash.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void BtldrExt_BurstWait(void)
+{
+    uint8 status = BtldrExt_FlashWait();
+
+    if(BtldrExt_burst.pending != 0u)
+    {
+        BtldrExt_burst.pending = 0u;
+        if(status != BTLDR_EXT_SUCCESS)
+        {
+            BtldrExt_burst.status = status;
+        }
+        else
+        {
+            BtldrExt_JournalMark(BtldrExt_burst.pendingRow, 1u);
+            BtldrExt_burst.rowsDone++;
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_BurstPut
+********************************************************************************
+*
+* Summary:
+*  Appends one decoded byte to the row buffer of the burst and programs the
+*  row when it is complete.
+*
+* Parameters:
+*  value: Decoded byte.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void BtldrExt_BurstPut(uint8 value)
+{
+    if(BtldrExt_burst.rowsLeft == 0u)
+    {
+        /* More data than announced by PROGRAM_ROWS */
+        BtldrExt_burst.status = BTLDR_EXT_ERR_LENGTH;
+    }
+    else
+    {
+        BtldrExt_rowBuffer[BtldrExt_rowOffset] = value;
+        BtldrExt_rowOffset++;
+        if(BtldrExt_rowOffset == CY_FLASH_SIZEOF_ROW)
+        {
+            BtldrExt_BurstCommit();
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_LzDecode
+********************************************************************************
+*
+* Summary:
+*  Feeds one byte of an LZ encoded row stream to the decoder. The decoded
+*  bytes are kept in the window and passed to BtldrExt_BurstPut().
+*
+* Parameters:
+*  value: Next byte of the encoded stream.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void BtldrExt_LzDecode(uint8 value)
+{
+    uint16 count;
+    uint8 from;
+
+    if(BtldrExt_lz.flagsLeft == 0u)
+    {
+        BtldrExt_lz.flags = value;
+        BtldrExt_lz.flagsLeft = 8u;
+    }
+    else if(BtldrExt_lz.state == BTLDR_EXT_LZ_LENGTH)
+    {
+        /* The copy may overlap the bytes it produces */
+        from = (uint8)(BtldrExt_lz.position - BtldrExt_lz.distance - 1u);
+        for(count = (uint16) value + BTLDR_EXT_LZ_MIN_MATCH;
+            (count != 0u) && (BtldrExt_burst.status == BTLDR_EXT_SUCCESS); count--)
+        {
+            BtldrExt_lzWindow[BtldrExt_lz.position] = BtldrExt_lzWindow[from];
+            BtldrExt_BurstPut(BtldrExt_lzWindow[from]);
+            BtldrExt_lz.position++;
+            from++;
+        }
+
+        BtldrExt_lz.state = BTLDR_EXT_LZ_ITEM;
+        BtldrExt_lz.flags >>= 1u;
+        BtldrExt_lz.flagsLeft--;
+    }
+    else if((BtldrExt_lz.flags & 0x01u) != 0u)
+    {
+        BtldrExt_lzWindow[BtldrExt_lz.position] = value;
+        BtldrExt_lz.position++;
+        BtldrExt_BurstPut(value);
+
+        BtldrExt_lz.flags >>= 1u;
+        BtldrExt_lz.flagsLeft--;
+    }
+    else
+    {
+        BtldrExt_lz.distance = value;
+        BtldrExt_lz.state = BTLDR_EXT_LZ_LENGTH;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_CheckRow
+********************************************************************************
+*
+* Summary:
+*  Checks that a row belongs to the bootloadable.
+*
+* Parameters:
+*  arrayId: Flash array ID.
+*  row:     Row number within the array.
+*
+* Return:
+*  BTLDR_EXT_SUCCESS, BTLDR_EXT_ERR_ARRAY or BTLDR_EXT_ERR_ROW.
+*
+*******************************************************************************/
+static uint8 BtldrExt_CheckRow(uint8 arrayId, uint16 row)
+{
+    uint8 status = BTLDR_EXT_SUCCESS;
+
+    if(arrayId != 0u)
+    {
+        status = BTLDR_EXT_ERR_ARRAY;
+    }
+    else if((row < BTLDR_EXT_FIRST_APP_ROW) || (row >= CY_FLASH_NUMBER_ROWS) ||
+            (row == BTLDR_EXT_SLOT_RECORD_ROW) || (row == BTLDR_EXT_VALID_ROW) ||
+            ((BTLDR_EXT_RECORD_ROWS > 3u) && (row == BTLDR_EXT_SELECT_ROW)))
+    {
+        status = BTLDR_EXT_ERR_ROW;
+    }
+    else
+    {
+        /* Row is writable */
+    }
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_CheckRows
+********************************************************************************
+*
+* Summary:
+*  Checks that every row of a range belongs to the bootloadable. The record
+*  rows lie between the rows of the bootloadable, so checking both ends of
+*  the range is not enough.
+*
+* Parameters:
+*  arrayId:  Flash array ID.
+*  firstRow: First row of the range.
+*  rowCount: Rows in the range, at least 1.
+*
+* Return:
+*  BTLDR_EXT_SUCCESS, BTLDR_EXT_ERR_ARRAY or BTLDR_EXT_ERR_ROW.
+*
+*******************************************************************************/
+static uint8 BtldrExt_CheckRows(uint8 arrayId, uint16 firstRow, uint16 rowCount)
+{
+    uint32 end = (uint32) firstRow + rowCount;
+    uint32 row;
+    uint8 status = BTLDR_EXT_SUCCESS;
+
+    /* Computed on 32 bits: a range past the last row must not wrap to row 0 */
+    if(end > CY_FLASH_NUMBER_ROWS)
+    {
+        status = BTLDR_EXT_ERR_ROW;
+    }
+
+    for(row = firstRow; (status == BTLDR_EXT_SUCCESS) && (row < end); row++)
+    {
+        status = BtldrExt_CheckRow(arrayId, (uint16) row);
+    }
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_WriteRow
+********************************************************************************
+*
+* Summary:
+*  Programs one flash row of the bootloadable. A row that already holds the
+*  data is left alone: rewriting it would cost the full erase and program
+*  time and wear the flash for nothing. The validity record is dropped
+*  before the first row is written, whether or not the host sent the Enter
+*  command, so a partly written image is checked in full at the next start.
+*  A journal left in flash by an earlier update is dropped before a row is
+*  written outside of an open journal, as the rows it records no longer hold
+*  its image.
+*
+* Parameters:
+*  arrayId:    Flash array ID.
+*  row:        Row number within the array.
+*  rowData:    CY_FLASH_SIZEOF_ROW bytes to program.
+*  background: Nonzero to return while the row is programmed when
+*              BTLDR_EXT_BACKGROUND_WRITE is set. rowData must be
+*              BtldrExt_rowBuffer, which then moves to the other buffer;
+*              BtldrExt_FlashWait() returns the result of the write.
+*
+* Return:
+*  Status of the operation.
+*
+*******************************************************************************/
+static uint8 BtldrExt_WriteRow(uint8 arrayId, uint16 row, const uint8 rowData[], uint8 background)
+{
+    uint8 status = BtldrExt_CheckRow(arrayId, row);
+    uint32 digest = 0u;
+
+    /* The steps below read the flash and may write it: the background write
+    * of the previous row must be done
+    */
+    if(status == BTLDR_EXT_SUCCESS)
+    {
+        status = BtldrExt_FlashWait();
+    }
+
+    if(status == BTLDR_EXT_SUCCESS)
+    {
+        /* Only found when no journal is open: the two share the row */
+        BtldrExt_ClearRecord(BTLDR_EXT_VALID_ROW, BTLDR_EXT_VALID_MAGIC);
+        if(BtldrExt_journalOpen == 0u)
+        {
+            BtldrExt_ClearRecord(BTLDR_EXT_JOURNAL_ROW, BTLDR_EXT_JOURNAL_MAGIC);
+        }
+    }
+
+#if (BTLDR_EXT_MULTI_APP != 0u)
+    /* The resident application of slot B is no longer intact */
+    if((status == BTLDR_EXT_SUCCESS) && (row >= BTLDR_EXT_SLOT_B_ROW) && (row <= BTLDR_EXT_SLOT_META_ROW))
+    {
+        BtldrExt_ClearRecord(BTLDR_EXT_SLOT_RECORD_ROW, BTLDR_EXT_SLOT_MAGIC);
+    }
+#endif /* (BTLDR_EXT_MULTI_APP != 0u) */
+
+    if(status == BTLDR_EXT_SUCCESS)
+    {
+        BtldrExt_SessionDrop(row);
+
+        /* Taken before the row is programmed: the digest reads the CRC table,
+        * which is in flash unless BTLDR_EXT_CRC_TABLE_IN_RAM is set
+        */
+        digest = BtldrExt_RowDigest(row, rowData);
+
+        if(memcmp(BTLDR_EXT_ROW_ADDR(row), rowData, CY_FLASH_SIZEOF_ROW) == 0)
+        {
+            BtldrExt_rowsSkipped++;
+        }
+    #if (BTLDR_EXT_BACKGROUND_WRITE != 0u)
+        else if(background != 0u)
+        {
+            if(CySysFlashStartWriteRow((uint32) row, rowData) != CY_SYS_FLASH_SUCCESS)
+            {
+                status = BTLDR_EXT_ERR_ROW;
+            }
+            else
+            {
+                BtldrExt_flashBusy = 1u;
+                BtldrExt_rowBuffer = (BtldrExt_rowBuffer == BtldrExt_rowBuffers[0u]) ?
+                                     BtldrExt_rowBuffers[1u] : BtldrExt_rowBuffers[0u];
+            }
+        }
+    #endif /* (BTLDR_EXT_BACKGROUND_WRITE != 0u) */
+        else if(BtldrExt_FlashWriteRow((uint32) row, rowData) != CY_SYS_FLASH_SUCCESS)
+        {
+            status = BTLDR_EXT_ERR_ROW;
+        }
+        else
+        {
+            /* Row programmed */
+        }
+    }
+
+    if(status == BTLDR_EXT_SUCCESS)
+    {
+        BtldrExt_SessionAdd(row, digest);
+    }
+
+    (void) background;
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_FlashWait
+********************************************************************************
+*
+* Summary:
+*  Waits for the background row write, if any, to complete.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  BTLDR_EXT_SUCCESS or BTLDR_EXT_ERR_ROW if the write failed.
+*
+*******************************************************************************/
+static uint8 BtldrExt_FlashWait(void)
+{
+    uint8 status = BTLDR_EXT_SUCCESS;
+
+#if (BTLDR_EXT_BACKGROUND_WRITE != 0u)
+    uint32 result;
+#if (BTLDR_EXT_PERF_COUNTERS != 0u)
+    uint32 start = CySysTickGetValue();
+#endif /* (BTLDR_EXT_PERF_COUNTERS != 0u) */
+
+    if(BtldrExt_flashBusy != 0u)
+    {
+        do
+        {
+            result = CySysFlashGetWriteRowStatus();
+        }
+        while(result == CY_SYS_FLASH_IN_PROGRESS);
+
+    #if (BTLDR_EXT_PERF_COUNTERS != 0u)
+        BtldrExt_flashCycles += BtldrExt_Cycles(start);
+    #endif /* (BTLDR_EXT_PERF_COUNTERS != 0u) */
+
+        BtldrExt_flashBusy = 0u;
+        if(result != CY_SYS_FLASH_SUCCESS)
+        {
+            status = BTLDR_EXT_ERR_ROW;
+        }
+    }
+#endif /* (BTLDR_EXT_BACKGROUND_WRITE != 0u) */
+
+    return (status);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_FlashWriteRow
+********************************************************************************
+*
+* Summary:
+*  Erases and programs a row in the foreground, counting the cycles it takes.
+*
+* Parameters:
+*  row:     Row number.
+*  rowData: CY_FLASH_SIZEOF_ROW bytes to program.
+*
+* Return:
+*  Result of CySysFlashWriteRow().
+*
+*******************************************************************************/
+static uint32 BtldrExt_FlashWriteRow(uint32 row, const uint8 rowData[])
+{
+    uint32 result;
+#if (BTLDR_EXT_PERF_COUNTERS != 0u)
+    uint32 start = CySysTickGetValue();
+
+    result = CySysFlashWriteRow(row, rowData);
+    BtldrExt_flashCycles += BtldrExt_Cycles(start);
+#else
+    result = CySysFlashWriteRow(row, rowData);
+#endif /* (BTLDR_EXT_PERF_COUNTERS != 0u) */
+
+    return (result);
+}
+
+
+#if (BTLDR_EXT_PERF_COUNTERS != 0u)
+/*******************************************************************************
+* Function Name: BtldrExt_Cycles
+********************************************************************************
+*
+* Summary:
+*  Cycles elapsed since a SysTick value was read, less than 2^24.
+*
+* Parameters:
+*  start: Value of CySysTickGetValue() at the start of the period.
+*
+* Return:
+*  Number of system clock cycles.
+*
+*******************************************************************************/
+static uint32 BtldrExt_Cycles(uint32 start)
+{
+    return ((start - CySysTickGetValue()) & BTLDR_EXT_CYCLE_MASK);
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_Count
+********************************************************************************
+*
+* Summary:
+*  Adds a call of a command to its counters, with the wait for its packet.
+*
+* Parameters:
+*  index:       Index of the command in the command table.
+*  start:       Value of CySysTickGetValue() when the command was dispatched.
+*  flashCycles: Value of BtldrExt_flashCycles when the command was dispatched.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void BtldrExt_Count(uint8 index, uint32 start, uint32 flashCycles)
+{
+    BtldrExt_Counter_T *counter = &BtldrExt_counters[index];
+    uint32 cycles = BtldrExt_Cycles(start);
+
+    if(counter->calls != 0xFFFFu)
+    {
+        counter->calls++;
+    }
+    counter->cycles += cycles;
+    if(cycles > counter->maxCycles)
+    {
+        counter->maxCycles = cycles;
+    }
+    counter->flashCycles += BtldrExt_flashCycles - flashCycles;
+    counter->waitCycles += BtldrExt_waitCycles;
+
+    BtldrExt_waitCycles = 0u;
+    BtldrExt_lastCommand = index;
+}
+#endif /* (BTLDR_EXT_PERF_COUNTERS != 0u) */
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_SessionAdd
+********************************************************************************
+*
+* Summary:
+*  Adds a row written since ENTER to the image hash of the session.
+*
+* Parameters:
+*  row:    Row number, already checked by BtldrExt_CheckRow().
+*  digest: BtldrExt_RowDigest() of the data the row is programmed with.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void BtldrExt_SessionAdd(uint16 row, uint32 digest)
+{
+    uint16 bit = row - BTLDR_EXT_FIRST_APP_ROW;
+
+    BtldrExt_session.rows[bit >> 3u] |= (uint8)(1u << (bit & 0x07u));
+    BtldrExt_session.digest += digest;
+    BtldrExt_session.rowCount++;
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_SessionDrop
+********************************************************************************
+*
+* Summary:
+*  Takes a row out of the image hash of the session before it is written
+*  again or erased. The digest removed is that of the data the row holds, the
+*  data it was added with.
+*
+* Parameters:
+*  row: Row number, already checked by BtldrExt_CheckRow().
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void BtldrExt_SessionDrop(uint16 row)
+{
+    uint16 bit = row - BTLDR_EXT_FIRST_APP_ROW;
+    uint8 mask = (uint8)(1u << (bit & 0x07u));
+
+    if((BtldrExt_session.rows[bit >> 3u] & mask) != 0u)
+    {
+        BtldrExt_session.rows[bit >> 3u] &= (uint8) ~mask;
+        BtldrExt_session.digest -= BtldrExt_RowDigest(row, BTLDR_EXT_ROW_ADDR(row));
+        BtldrExt_session.rowCount--;
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_JournalMark
+********************************************************************************
+*
+* Summary:
+*  Records in the open journal that a row now holds, or no longer holds, the
+*  data of the image. Committed rows are written back to flash every
+*  BTLDR_EXT_JOURNAL_INTERVAL rows; a row that is no longer committed is
+*  written back at once, as the journal must never claim a row that was not
+*  programmed.
+*
+* Parameters:
+*  row:       Row number, already checked by BtldrExt_CheckRow().
+*  committed: Nonzero if the row holds the image data.
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void BtldrExt_JournalMark(uint16 row, uint8 committed)
+{
+    uint16 bit = row - BTLDR_EXT_FIRST_APP_ROW;
+    uint8 mask = (uint8)(1u << (bit & 0x07u));
+    uint8 *map;
+
+    if(BtldrExt_journalOpen != 0u)
+    {
+        map = &BtldrExt_record.journal.committed[bit >> 3u];
+        if((committed != 0u) && ((*map & mask) == 0u))
+        {
+            *map |= mask;
+            BtldrExt_journalDirty++;
+            if(BtldrExt_journalDirty >= BTLDR_EXT_JOURNAL_INTERVAL)
+            {
+                BtldrExt_JournalWrite();
+            }
+        }
+        else if((committed == 0u) && ((*map & mask) != 0u))
+        {
+            *map &= (uint8) ~mask;
+            BtldrExt_JournalWrite();
+        }
+        else
+        {
+            /* No change */
+        }
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: BtldrExt_JournalWrite
+********************************************************************************
+*
+* Summary:
+*  Writes the open journal back to its flash row.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+static void BtldrExt_JournalWrite(void)
+{
+    BtldrExt_record.journal.check = BtldrExt_Crc32(BTLDR_EXT_CRC_INIT, BtldrExt_record.row,
+                                                   (uint16) offsetof(BtldrExt_Journal_T, check));
+    (void) BtldrExt_FlashWriteRow((uint32) BTLDR_EXT_JOURNAL_ROW, BtldrExt_record.row);
+    BtldrExt_journalDirty = 0u;
+}
+
+
+/*******************************************************************************
+* Command handlers
+********************************************************************************
+*
+* Summary:
+*  Each handler executes one command of the BtldrExt_commands table. The
+*  parameters are the same for every handler.
+*
+* Parameters:
+*  data:      Packet data.
+*  length:    Packet data length, at least the minLength of the table entry.
+*  rsp:       Buffer for the response data.
+*  rspLength: Length of the response data, zero unless set by the handler.
+*
+* Return:
+*  Status for the response or BTLDR_EXT_NO_RESPONSE.
+*
+*******************************************************************************/
+static uint8 BtldrExt_VerifyChecksum(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength)
+{
+    (void) data;
+    (void) length;
+
+    rsp[0u] = BtldrExt_ValidateApp();
+    *rspLength = 1u;
+
+    /* Resuming the update of an image that fails would fail again */
+    if(rsp[0u] == 0u)
+    {
+        BtldrExt_ClearRecord(BTLDR_EXT_JOURNAL_ROW, BTLDR_EXT_JOURNAL_MAGIC);
+    }
+
+    return (BTLDR_EXT_SUCCESS);
+}
+
+static uint8 BtldrExt_GetFlashSize(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength)
+{
+    uint8 status = BTLDR_EXT_ERR_ARRAY;
+
+    (void) length;
+
+    if(data[0u] == 0u)
+    {
+        BTLDR_EXT_SET_WORD(&rsp[0u], BTLDR_EXT_FIRST_APP_ROW);
+        BTLDR_EXT_SET_WORD(&rsp[2u], CY_FLASH_NUMBER_ROWS - 1u);
+        *rspLength = 4u;
+        status = BTLDR_EXT_SUCCESS;
+    }
+
+    return (status);
+}
+
+static uint8 BtldrExt_EraseRow(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength)
+{
+    uint16 row = BTLDR_EXT_GET_WORD(&data[1u]);
+    uint8 status;
+
+    (void) length;
+    (void) rsp;
+    (void) rspLength;
+
+    /* Flash is erased by programming a row of zeros */
+    (void) memset(BtldrExt_rowBuffer, 0, CY_FLASH_SIZEOF_ROW);
+    BtldrExt_rowOffset = 0u;
+
+    status = BtldrExt_WriteRow(data[0u], row, BtldrExt_rowBuffer, 0u);
+    if(status == BTLDR_EXT_SUCCESS)
+    {
+        /* An erased row is not part of the image */
+        BtldrExt_SessionDrop(row);
+        BtldrExt_JournalMark(row, 0u);
+    }
+
+    return (status);
+}
+
+static uint8 BtldrExt_Sync(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength)
+{
+    (void) data;
+    (void) length;
+    (void) rsp;
+    (void) rspLength;
+
+    BtldrExt_ResetState();
+
+    return (BTLDR_EXT_NO_RESPONSE);
+}
+
+static uint8 BtldrExt_SendData(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength)
+{
+    uint8 status = BTLDR_EXT_SUCCESS;
+
+    (void) rsp;
+    (void) rspLength;
+
+    if((BtldrExt_rowOffset + length) > CY_FLASH_SIZEOF_ROW)
+    {
+        BtldrExt_rowOffset = 0u;
+        status = BTLDR_EXT_ERR_LENGTH;
+    }
+    else
+    {
+        (void) memcpy(&BtldrExt_rowBuffer[BtldrExt_rowOffset], data, length);
+        BtldrExt_rowOffset += length;
+    }
+
+    return (status);
+}
+
+static uint8 BtldrExt_Enter(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength)
+{
+    (void) data;
+    (void) length;
+
+    BtldrExt_ResetState();
+    BtldrExt_rowsSkipped = 0u;
+    BtldrExt_journalOpen = 0u;
+    (void) memset(&BtldrExt_session, 0, sizeof(BtldrExt_session));
+#if (BTLDR_EXT_PERF_COUNTERS != 0u)
+    (void) memset(BtldrExt_counters, 0, sizeof(BtldrExt_counters));
+#endif /* (BTLDR_EXT_PERF_COUNTERS != 0u) */
+
+    /* The host may overwrite slot B and the application: drop an image staged
+    * there, the probation of the previous one kept there and the cached
+    * checksum result. A resident application of slot B is only dropped when
+    * the host writes to it.
+    */
+#if (BTLDR_EXT_MULTI_APP == 0u)
+    BtldrExt_ClearRecord(BTLDR_EXT_SLOT_RECORD_ROW, BTLDR_EXT_SLOT_MAGIC);
+    #if (BTLDR_EXT_PROBATION != 0u)
+        BtldrExt_ClearRecord(BTLDR_EXT_SLOT_RECORD_ROW, BTLDR_EXT_PROBATION_MAGIC);
+    #endif /* (BTLDR_EXT_PROBATION != 0u) */
+#endif /* (BTLDR_EXT_MULTI_APP == 0u) */
+    BtldrExt_ClearRecord(BTLDR_EXT_VALID_ROW, BTLDR_EXT_VALID_MAGIC);
+
+    rsp[0u] = LO8(LO16(CYDEV_CHIP_JTAG_ID));
+    rsp[1u] = HI8(LO16(CYDEV_CHIP_JTAG_ID));
+    rsp[2u] = LO8(HI16(CYDEV_CHIP_JTAG_ID));
+    rsp[3u] = HI8(HI16(CYDEV_CHIP_JTAG_ID));
+    rsp[4u] = CYDEV_CHIP_REVISION_USED;
+    rsp[5u] = BTLDR_EXT_VERSION_PATCH;
+    rsp[6u] = BTLDR_EXT_VERSION_MINOR;
+    rsp[7u] = BTLDR_EXT_VERSION_MAJOR;
+    *rspLength = 8u;
+
+    return (BTLDR_EXT_SUCCESS);
+}
+
+static uint8 BtldrExt_ProgramRow(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength)
+{
+    uint8 status;
+
+    (void) rsp;
+    (void) rspLength;
+
+    /* The last part of the row follows the array ID and the row number */
+    status = BtldrExt_SendData(&data[3u], length - 3u, rsp, rspLength);
+
+    if(status == BTLDR_EXT_SUCCESS)
+    {
+        if(BtldrExt_rowOffset != CY_FLASH_SIZEOF_ROW)
+        {
+            status = BTLDR_EXT_ERR_LENGTH;
+        }
+        else
+        {
+            status = BtldrExt_WriteRow(data[0u], BTLDR_EXT_GET_WORD(&data[1u]), BtldrExt_rowBuffer, 0u);
+        }
+        if(status == BTLDR_EXT_SUCCESS)
+        {
+            BtldrExt_JournalMark(BTLDR_EXT_GET_WORD(&data[1u]), 1u);
+        }
+    }
+    BtldrExt_rowOffset = 0u;
+
+    return (status);
+}
+
+static uint8 BtldrExt_VerifyRow(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength)
+{
+    uint16 row = BTLDR_EXT_GET_WORD(&data[1u]);
+    const uint8 *rowData;
+    uint8 sum = 0u;
+    uint8 status;
+    uint16 i;
+
+    (void) length;
+
+    status = BtldrExt_CheckRow(data[0u], row);
+    if(status == BTLDR_EXT_SUCCESS)
+    {
+        rowData = BTLDR_EXT_ROW_ADDR(row);
+        for(i = 0u; i < CY_FLASH_SIZEOF_ROW; i++)
+        {
+            sum += rowData[i];
+        }
+        rsp[0u] = (uint8)(1u + (uint8)(~sum));
+        *rspLength = 1u;
+    }
+
+    return (status);
+}
+
+static uint8 BtldrExt_Exit(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength)
+{
+    (void) data;
+    (void) length;
+    (void) rsp;
+    (void) rspLength;
+
+    CyBtldrCommStop();
+
+    /* Schedule the bootloadable and reset the device */
+    BtldrExt_Launch();
+
+    return (BTLDR_EXT_NO_RESPONSE);
+}
+
+static uint8 BtldrExt_ProgramRows(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength)
+{
+    uint16 firstRow = BTLDR_EXT_GET_WORD(&data[1u]);
+    uint16 rowCount = BTLDR_EXT_GET_WORD(&data[3u]);
+
+    (void) rsp;
+    (void) rspLength;
+
+    BtldrExt_ResetState();
+
+    BtldrExt_burst.arrayId = data[0u];
+    BtldrExt_burst.nextRow = firstRow;
+    BtldrExt_burst.rowsLeft = rowCount;
+    if(length > 5u)
+    {
+        BtldrExt_burst.encoding = data[5u];
+    }
+
+    if(rowCount == 0u)
+    {
+        BtldrExt_burst.status = BTLDR_EXT_ERR_LENGTH;
+    }
+    else if(BtldrExt_burst.encoding > BTLDR_EXT_ENCODING_LZ)
+    {
+        BtldrExt_burst.status = BTLDR_EXT_ERR_DATA;
+    }
+    else
+    {
+        /* The whole range must be writable before any row is touched */
+        BtldrExt_burst.status = BtldrExt_CheckRows(data[0u], firstRow, rowCount);
+    }
+
+    return (BTLDR_EXT_NO_RESPONSE);
+}
+
+static uint8 BtldrExt_RowsData(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength)
+{
+    uint16 chunk;
+    uint16 i = 1u;
+
+    (void) rsp;
+    (void) rspLength;
+
+    if(BtldrExt_burst.status == BTLDR_EXT_SUCCESS)
+    {
+        if(data[0u] != BtldrExt_burst.sequence)
+        {
+            BtldrExt_burst.status = BTLDR_EXT_ERR_SEQUENCE;
+        }
+        else
+        {
+            BtldrExt_burst.sequence++;
+        }
+    }
+
+    if(BtldrExt_burst.encoding == BTLDR_EXT_ENCODING_LZ)
+    {
+        for(i = 1u; (BtldrExt_burst.status == BTLDR_EXT_SUCCESS) && (i < length); i++)
+        {
+            BtldrExt_LzDecode(data[i]);
+        }
+    }
+
+    while((BtldrExt_burst.encoding == BTLDR_EXT_ENCODING_RAW) &&
+          (BtldrExt_burst.status == BTLDR_EXT_SUCCESS) && (i < length))
+    {
+        if(BtldrExt_burst.rowsLeft == 0u)
+        {
+            /* More data than announced by PROGRAM_ROWS */
+            BtldrExt_burst.status = BTLDR_EXT_ERR_LENGTH;
+        }
+        else
+        {
+            chunk = CY_FLASH_SIZEOF_ROW - BtldrExt_rowOffset;
+            if(chunk > (length - i))
+            {
+                chunk = length - i;
+            }
+
+            (void) memcpy(&BtldrExt_rowBuffer[BtldrExt_rowOffset], &data[i], chunk);
+            BtldrExt_rowOffset += chunk;
+            i += chunk;
+
+            if(BtldrExt_rowOffset == CY_FLASH_SIZEOF_ROW)
+            {
+                BtldrExt_BurstCommit();
+            }
+        }
+    }
+
+    return (BTLDR_EXT_NO_RESPONSE);
+}
+
+static uint8 BtldrExt_RowsStatus(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength)
+{
+    (void) data;
+
+    BTLDR_EXT_SET_WORD(&rsp[0u], BtldrExt_burst.rowsDone);
+    rsp[2u] = BtldrExt_burst.sequence;
+    *rspLength = 3u;
+
+    /* The first version of the command had no data and no skip count */
+    if(length != 0u)
+    {
+        BTLDR_EXT_SET_WORD(&rsp[3u], BtldrExt_rowsSkipped);
+        *rspLength = 5u;
+    }
+
+    return (BtldrExt_burst.status);
+}
+
+static uint8 BtldrExt_GetRowHashes(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength)
+{
+    uint16 row = BTLDR_EXT_GET_WORD(&data[1u]);
+    uint8 count = data[3u];
+    uint8 status;
+    uint32 hash;
+    uint8 i;
+
+    (void) length;
+
+    if((count == 0u) || (count > BTLDR_EXT_MAX_HASHES))
+    {
+        status = BTLDR_EXT_ERR_LENGTH;
+    }
+    else
+    {
+        status = BtldrExt_CheckRows(data[0u], row, count);
+    }
+
+    if(status == BTLDR_EXT_SUCCESS)
+    {
+        for(i = 0u; i < count; i++)
+        {
+            hash = BtldrExt_RowHash(BTLDR_EXT_ROW_ADDR(row + i));
+            BTLDR_EXT_SET_WORD(&rsp[4u * i], LO16(hash));
+            BTLDR_EXT_SET_WORD(&rsp[(4u * i) + 2u], HI16(hash));
+        }
+        *rspLength = 4u * (uint16) count;
+    }
+
+    return (status);
+}
+
+static uint8 BtldrExt_OpenJournal(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength)
+{
+    const BtldrExt_Journal_T *journal = (const BtldrExt_Journal_T *) BTLDR_EXT_ROW_ADDR(BTLDR_EXT_JOURNAL_ROW);
+    uint32 imageId = (uint32) BTLDR_EXT_GET_WORD(&data[0u]) | ((uint32) BTLDR_EXT_GET_WORD(&data[2u]) << 16u);
+
+    (void) length;
+
+    if((journal->magic == BTLDR_EXT_JOURNAL_MAGIC) && (journal->imageId == imageId) &&
+       (journal->check == BtldrExt_Crc32(BTLDR_EXT_CRC_INIT, (const uint8 *) journal,
+                                         (uint16) offsetof(BtldrExt_Journal_T, check))))
+    {
+        (void) memcpy(BtldrExt_record.row, journal, CY_FLASH_SIZEOF_ROW);
+        rsp[0u] = 1u;
+    }
+    else
+    {
+        /* The rows recorded by a journal of another image are about to be
+        * overwritten: drop it before the first row is written. Without a
+        * preceding Enter the row may still hold the validity record.
+        */
+        BtldrExt_ClearRecord(BTLDR_EXT_JOURNAL_ROW, BTLDR_EXT_JOURNAL_MAGIC);
+        BtldrExt_ClearRecord(BTLDR_EXT_VALID_ROW, BTLDR_EXT_VALID_MAGIC);
+
+        (void) memset(BtldrExt_record.row, 0, CY_FLASH_SIZEOF_ROW);
+        BtldrExt_record.journal.magic = BTLDR_EXT_JOURNAL_MAGIC;
+        BtldrExt_record.journal.imageId = imageId;
+        rsp[0u] = 0u;
+    }
+    BtldrExt_journalOpen = 1u;
+    BtldrExt_journalDirty = 0u;
+
+    (void) memcpy(&rsp[1u], BtldrExt_record.journal.committed, BTLDR_EXT_JOURNAL_MAP_SIZE);
+    *rspLength = 1u + BTLDR_EXT_JOURNAL_MAP_SIZE;
+
+    return (BTLDR_EXT_SUCCESS);
+}
+
+static uint8 BtldrExt_VerifyImage(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength)
+{
+    uint32 digest = (uint32) BTLDR_EXT_GET_WORD(&data[0u]) | ((uint32) BTLDR_EXT_GET_WORD(&data[2u]) << 16u);
+    uint32 programmed = BtldrExt_session.digest;
+    uint8 readBack = ((length > 6u) && ((data[6u] & BTLDR_EXT_VERIFY_READ_BACK) != 0u)) ? 1u : 0u;
+    uint16 bit;
+
+    /* Paranoid mode: trust the flash, not the sum kept while programming */
+    if(readBack != 0u)
+    {
+        programmed = 0u;
+        for(bit = 0u; bit < (CY_FLASH_NUMBER_ROWS - BTLDR_EXT_FIRST_APP_ROW); bit++)
+        {
+            if((BtldrExt_session.rows[bit >> 3u] & (uint8)(1u << (bit & 0x07u))) != 0u)
+            {
+                programmed += BtldrExt_RowDigest(BTLDR_EXT_FIRST_APP_ROW + bit,
+                                                 BTLDR_EXT_ROW_ADDR(BTLDR_EXT_FIRST_APP_ROW + bit));
+            }
+        }
+    }
+
+    rsp[0u] = 0u;
+    if((programmed == digest) && (BtldrExt_session.rowCount == BTLDR_EXT_GET_WORD(&data[4u])))
+    {
+        rsp[0u] = (readBack != 0u) ? BtldrExt_ValidateApp() : BtldrExt_RecordValid();
+    }
+    *rspLength = 1u;
+
+    /* Resuming the update of an image that fails would fail again */
+    if(rsp[0u] == 0u)
+    {
+        BtldrExt_ClearRecord(BTLDR_EXT_JOURNAL_ROW, BTLDR_EXT_JOURNAL_MAGIC);
+    }
+
+    return (BTLDR_EXT_SUCCESS);
+}
+
+#if (BTLDR_EXT_PERF_COUNTERS != 0u)
+static uint8 BtldrExt_GetCounters(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength)
+{
+    const BtldrExt_Counter_T *counter;
+    uint8 *entry = &rsp[5u];
+    uint8 i;
+
+    (void) length;
+
+    (void) memset(rsp, 0, BTLDR_EXT_SIZEOF_COUNTERS_RSP);
+    rsp[0u] = (uint8) BTLDR_EXT_NUMBER_OF_COMMANDS;
+    BTLDR_EXT_SET_LONG(&rsp[1u], CYDEV_BCLK__SYSCLK__HZ);
+
+    for(i = data[0u]; (i < BTLDR_EXT_NUMBER_OF_COMMANDS) && ((uint8)(i - data[0u]) < BTLDR_EXT_COUNTERS_PER_RSP); i++)
+    {
+        counter = &BtldrExt_counters[i];
+        entry[0u] = BtldrExt_commands[i].command;
+        BTLDR_EXT_SET_WORD(&entry[1u], counter->calls);
+        BTLDR_EXT_SET_LONG(&entry[3u], counter->cycles);
+        BTLDR_EXT_SET_LONG(&entry[7u], counter->maxCycles);
+        BTLDR_EXT_SET_LONG(&entry[11u], counter->flashCycles);
+        BTLDR_EXT_SET_LONG(&entry[15u], counter->waitCycles);
+        entry = &entry[BTLDR_EXT_SIZEOF_COUNTER];
+    }
+    *rspLength = BTLDR_EXT_SIZEOF_COUNTERS_RSP;
+
+    return (BTLDR_EXT_SUCCESS);
+}
+#endif /* (BTLDR_EXT_PERF_COUNTERS != 0u) */
+
+#if (BTLDR_EXT_MULTI_APP != 0u)
+static uint8 BtldrExt_SelectApp(const uint8 data[], uint16 length, uint8 rsp[], uint16 *rspLength)
+{
+    uint8 status = BTLDR_EXT_SUCCESS;
+
+    (void) length;
+    (void) rsp;
+    (void) rspLength;
+
+    if((data[0u] > BTLDR_EXT_APP_B) || ((data[0u] == BTLDR_EXT_APP_B) && (BtldrExt_SlotResident() == 0u)))
+    {
+        status = BTLDR_EXT_ERR_APP;
+    }
+    else
+    {
+        /* The record row backs the journal */
+        BtldrExt_journalOpen = 0u;
+
+        (void) memset(BtldrExt_record.row, 0, CY_FLASH_SIZEOF_ROW);
+        BtldrExt_record.select.magic = BTLDR_EXT_SELECT_MAGIC;
+        BtldrExt_record.select.app = data[0u];
+        BtldrExt_record.select.check = ~(BtldrExt_record.select.magic ^ BtldrExt_record.select.app);
+        if(BtldrExt_FlashWriteRow((uint32) BTLDR_EXT_SELECT_ROW, BtldrExt_record.row) != CY_SYS_FLASH_SUCCESS)
+        {
+            status = BTLDR_EXT_ERR_ROW;
+        }
+    }
+
+    return (status);
+}
+#endif /* (BTLDR_EXT_MULTI_APP != 0u) */
+
+
+/* [] END OF FILE */
@@ -0,0 +1,290 @@
+/*******************************************************************************
+* File: btldr_ext.h
+*
+* Version: 1.0
+*
+* Description:
+*  Provides the API and the protocol constants for the extended host link of
+*  the bootloader. The link uses the same packet format as the Bootloader
+*  component and adds the commands that the component does not provide.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#if !defined(BTLDR_EXT_H)
+#define BTLDR_EXT_H
+
+#include <project.h>
+#include "btldr_slot.h"
+
+
+/***************************************
+*        Link configuration
+***************************************/
+
+/* Largest packet accepted by the I2C_Slave bootloader buffers */
+#define BTLDR_EXT_SIZEOF_PACKET         (64u)
+
+/* Time to wait for the first host command, in 10 ms units, when the
+* bootloadable requested an update or the bus probe found a host
+*/
+#define BTLDR_EXT_WAIT_TIME             (200u)
+
+/* Bus probe of a cold boot with a valid bootloadable: the time the I2C
+* slave is watched for a host write, and the poll period, in microseconds.
+* A host that wants the bootloader after a power-on keeps sending the Enter
+* command until it is answered; the probe must span its retry period.
+*/
+#define BTLDR_EXT_PROBE_TIME            (500u)
+#define BTLDR_EXT_PROBE_POLL            (10u)
+
+/* Time allowed for the host to collect a response, in 10 ms units */
+#define BTLDR_EXT_RESPONSE_TIMEOUT      (10u)
+
+/* Program the rows of a burst in the background. A completed row is handed
+* to the non-blocking row write of the flash API and the next row is
+* received into a second row buffer meanwhile; the device waits for the
+* write only when the next row is complete or another command needs the
+* flash. Non-blocking row writes (CySysFlashStartWrite() of cy_boot) exist
+* only on the PSoC 4000S, 4100S, 4100S Plus and 4100PS families and the PSoC
+* Analog Coprocessor. The PSoC 4000, 4100, 4200 and 4200L families, with the
+* CY8C4245 of the kit, stall the CPU for the whole write, so this is off by
+* default and the rows are programmed as they complete. The flash cannot be
+* read while a row is programmed. On the parts that have the non-blocking
+* write, the code that runs meanwhile must be placed in SRAM with the
+* linker script, together with the constants it reads: the I2C_Slave
+* interrupt, BtldrExt_HostLink() with the receive path of a burst, and
+* BtldrExt_commands. The row digest, which reads the CRC table, is taken
+* before the write starts.
+*/
+#if !defined(BTLDR_EXT_BACKGROUND_WRITE)
+    #define BTLDR_EXT_BACKGROUND_WRITE  (0u)
+#endif /* !defined(BTLDR_EXT_BACKGROUND_WRITE) */
+
+/* Table of the CRC-32C engine: 256 entries (1 KB, one lookup per byte), 16
+* entries (64 bytes, two lookups per byte) or 0 for no table (one step per
+* bit). The table is a constant in flash, or with BTLDR_EXT_CRC_TABLE_IN_RAM
+* set it is computed into RAM on first use, which saves the flash wait
+* states of the lookups at the cost of the RAM. sim/btldr_crcbench.c of the
+* host tools reports the cycles per byte of each choice.
+*/
+#if !defined(BTLDR_EXT_CRC_TABLE_SIZE)
+    #define BTLDR_EXT_CRC_TABLE_SIZE    (16u)
+#endif /* !defined(BTLDR_EXT_CRC_TABLE_SIZE) */
+
+#if !defined(BTLDR_EXT_CRC_TABLE_IN_RAM)
+    #define BTLDR_EXT_CRC_TABLE_IN_RAM  (0u)
+#endif /* !defined(BTLDR_EXT_CRC_TABLE_IN_RAM) */
+
+/* Count, for each command, the calls, the cycles spent in it, the longest
+* call, the cycles of flash writes and the cycles waited for the host, and
+* answer GET_COUNTERS. The SysTick timer runs free on the system clock to
+* count the cycles, without its interrupt; one measured period must stay
+* below 2^24 cycles. Takes 20 bytes of RAM per command.
+*/
+#if !defined(BTLDR_EXT_PERF_COUNTERS)
+    #define BTLDR_EXT_PERF_COUNTERS     (1u)
+#endif /* !defined(BTLDR_EXT_PERF_COUNTERS) */
+
+/* Bootloader version reported by the Enter Bootloader command */
+#define BTLDR_EXT_VERSION_MAJOR         (0x01u)
+#define BTLDR_EXT_VERSION_MINOR         (0x00u)
+#define BTLDR_EXT_VERSION_PATCH         (0x01u)
+
+
+/***************************************
+*        Packet format
+***************************************/
+
+#define BTLDR_EXT_SOP                   (0x01u)
+#define BTLDR_EXT_EOP                   (0x17u)
+
+/* SOP, command or status, 16-bit data length */
+#define BTLDR_EXT_SIZEOF_HEADER         (4u)
+
+/* 16-bit checksum, EOP */
+#define BTLDR_EXT_SIZEOF_FOOTER         (3u)
+
+#define BTLDR_EXT_SIZEOF_OVERHEAD       (BTLDR_EXT_SIZEOF_HEADER + BTLDR_EXT_SIZEOF_FOOTER)
+#define BTLDR_EXT_MAX_DATA_LENGTH       (BTLDR_EXT_SIZEOF_PACKET - BTLDR_EXT_SIZEOF_OVERHEAD)
+
+
+/***************************************
+*        Commands
+***************************************/
+
+/* Commands shared with the Bootloader component */
+#define BTLDR_EXT_CMD_VERIFY_CHECKSUM   (0x31u)
+#define BTLDR_EXT_CMD_GET_FLASH_SIZE    (0x32u)
+#define BTLDR_EXT_CMD_ERASE_ROW         (0x34u)
+#define BTLDR_EXT_CMD_SYNC              (0x35u)
+#define BTLDR_EXT_CMD_SEND_DATA         (0x37u)
+#define BTLDR_EXT_CMD_ENTER             (0x38u)
+#define BTLDR_EXT_CMD_PROGRAM_ROW       (0x39u)
+#define BTLDR_EXT_CMD_VERIFY_ROW        (0x3Au)
+#define BTLDR_EXT_CMD_EXIT              (0x3Bu)
+
+/* Multi-row burst. PROGRAM_ROWS opens the burst with the array ID, the
+* 16-bit first row, the 16-bit row count and an optional encoding byte.
+* ROWS_DATA packets carry an 8-bit sequence number followed by the next bytes
+* of the row stream, and the rows are programmed as soon as they are
+* complete. Neither command is answered; ROWS_STATUS acknowledges the whole
+* burst with the number of rows committed and the next expected sequence
+* number. When ROWS_STATUS carries a data byte, the response also holds the
+* 16-bit number of rows found identical in flash, and so not programmed,
+* since ENTER.
+*/
+#define BTLDR_EXT_CMD_PROGRAM_ROWS      (0x40u)
+#define BTLDR_EXT_CMD_ROWS_DATA         (0x41u)
+#define BTLDR_EXT_CMD_ROWS_STATUS       (0x42u)
+
+/* Encoding of the row stream of a burst */
+#define BTLDR_EXT_ENCODING_RAW          (0x00u)
+#define BTLDR_EXT_ENCODING_LZ           (0x01u)
+
+/* LZ stream: groups of a flag byte followed by eight items, the flag bits
+* taken LSB first. A set bit is one literal byte; a clear bit is a match of
+* two bytes, the distance minus one and the length minus
+* BTLDR_EXT_LZ_MIN_MATCH, copied from the last BTLDR_EXT_LZ_WINDOW bytes of
+* the burst. The window is indexed by an 8-bit position and must stay 256.
+*/
+#define BTLDR_EXT_LZ_WINDOW             (256u)
+#define BTLDR_EXT_LZ_MIN_MATCH          (3u)
+
+/* Row hashes of the installed image. Takes the array ID, the 16-bit first
+* row and an 8-bit row count and returns one 32-bit BtldrExt_RowHash() value
+* per row, so the host can send only the rows that differ.
+*/
+#define BTLDR_EXT_CMD_GET_ROW_HASHES    (0x43u)
+#define BTLDR_EXT_MAX_HASHES            (BTLDR_EXT_MAX_DATA_LENGTH / 4u)
+
+/* Progress journal of a resumable update. Takes a 32-bit image ID chosen by
+* the host. If the journal kept in flash belongs to the same image, it is
+* reopened and the response is 1 followed by its bitmap of committed rows;
+* otherwise a new empty journal is started and the response is 0 followed by
+* an empty bitmap. The bitmap has one bit per row from
+* BTLDR_EXT_FIRST_APP_ROW, LSB first, and BTLDR_EXT_JOURNAL_MAP_SIZE bytes.
+*/
+#define BTLDR_EXT_CMD_OPEN_JOURNAL      (0x44u)
+
+/* Verify of the rows programmed since ENTER. Takes the 32-bit sum of the
+* BtldrExt_RowDigest() of the rows the host sent, the 16-bit number of those
+* rows and an optional mode byte. The bootloader adds up the same sum while
+* the rows are programmed, so the image is verified by one comparison. With
+* BTLDR_EXT_VERIFY_READ_BACK in the mode byte, the sum is computed again
+* from flash and the checksum of the whole bootloadable is validated as
+* well. The response is 1 and the validity record is written when the image
+* passes, otherwise 0.
+*/
+#define BTLDR_EXT_CMD_VERIFY_IMAGE      (0x45u)
+#define BTLDR_EXT_VERIFY_READ_BACK      (0x01u)
+
+/* Read of the performance counters kept since ENTER, with
+* BTLDR_EXT_PERF_COUNTERS set. Takes the index of the first command to
+* report. The response holds the number of commands counted, the cycle
+* clock in Hz, LSB first, and BTLDR_EXT_COUNTERS_PER_RSP entries of the
+* command code, the 16-bit calls and the 32-bit handler, longest call,
+* flash and host wait cycles. Entries past the last command are zero.
+*/
+#define BTLDR_EXT_CMD_GET_COUNTERS      (0x46u)
+#define BTLDR_EXT_COUNTERS_PER_RSP      (2u)
+#define BTLDR_EXT_SIZEOF_COUNTER        (19u)
+#define BTLDR_EXT_SIZEOF_COUNTERS_RSP   (5u + (BTLDR_EXT_COUNTERS_PER_RSP * BTLDR_EXT_SIZEOF_COUNTER))
+
+/* Selection of the application launched, with BTLDR_EXT_MULTI_APP set.
+* Takes BTLDR_EXT_APP_A or BTLDR_EXT_APP_B and writes the select record; the
+* selection takes effect with the EXIT command. BTLDR_EXT_ERR_APP if slot B
+* holds no committed application.
+*/
+#define BTLDR_EXT_CMD_SELECT_APP        (0x47u)
+
+
+/***************************************
+*        Status codes
+***************************************/
+
+#define BTLDR_EXT_SUCCESS               (0x00u)
+#define BTLDR_EXT_ERR_VERIFY            (0x02u)
+#define BTLDR_EXT_ERR_LENGTH            (0x03u)
+#define BTLDR_EXT_ERR_DATA              (0x04u)
+#define BTLDR_EXT_ERR_CMD               (0x05u)
+#define BTLDR_EXT_ERR_CHECKSUM          (0x08u)
+#define BTLDR_EXT_ERR_ARRAY             (0x09u)
+#define BTLDR_EXT_ERR_ROW               (0x0Au)
+#define BTLDR_EXT_ERR_APP               (0x0Cu)
+#define BTLDR_EXT_ERR_SEQUENCE          (0x10u)
+
+/* Returned by a command handler that must not be answered */
+#define BTLDR_EXT_NO_RESPONSE           (0xFFu)
+
+
+/***************************************
+*        Progress journal
+***************************************/
+
+/* While an update is in progress, the validity record row holds the progress
+* journal instead: the validity record is cleared by the Enter command and
+* written again once the new image passes its checksum, which also ends the
+* journal. Committed rows are recorded in RAM and the journal is written
+* back every BTLDR_EXT_JOURNAL_INTERVAL newly committed rows, so an
+* interrupted update loses at most that many rows of progress. The bitmap
+* is returned by the Open Journal command and must fit in one response.
+*/
+#define BTLDR_EXT_JOURNAL_ROW           (BTLDR_EXT_VALID_ROW)
+#define BTLDR_EXT_JOURNAL_MAGIC         (0x4A524E4Cu)
+#define BTLDR_EXT_JOURNAL_INTERVAL      (8u)
+#define BTLDR_EXT_JOURNAL_MAP_SIZE      ((CY_FLASH_NUMBER_ROWS - BTLDR_EXT_FIRST_APP_ROW + 7u) / 8u)
+
+/* The journal fills one row. The check is the CRC-32C of the fields
+* before it, so a journal torn by a reset is not trusted.
+*/
+typedef struct _BtldrExt_Journal_T
+{
+    uint32  magic;                      /* BTLDR_EXT_JOURNAL_MAGIC */
+    uint32  imageId;                    /* image ID sent by the host */
+    uint8   committed[CY_FLASH_SIZEOF_ROW - 12u]; /* one bit per row */
+    uint32  check;                      /* hash of the fields above */
+} BtldrExt_Journal_T;
+
+/* Head of the slot record row or of BTLDR_EXT_SWAP_ROW, alternately, while
+* the slots are swapped. Each row that differs is saved to the validity
+* record row, programmed in slot A from slot B and restored to slot B,
+* after this record names it; a swap interrupted by a reset resumes from
+* the latest row named, and the hashes tell how far it got. The check is
+* the CRC-32C of the fields before it.
+*/
+typedef struct _BtldrExt_SwapRecord_T
+{
+    uint32  magic;                      /* BTLDR_EXT_SWAP_MAGIC */
+    uint32  row;                        /* row of the slot, BTLDR_EXT_SLOT_ROWS for the metadata row */
+    uint32  hashA;                      /* BtldrExt_RowHash() of the row going to slot A */
+    uint32  hashB;                      /* BtldrExt_RowHash() of the row going to slot B */
+    uint32  rollback;                   /* the swap restores the previous image */
+    uint32  check;                      /* hash of the fields above */
+} BtldrExt_SwapRecord_T;
+
+/***************************************
+*        Function Prototypes
+***************************************/
+
+void   BtldrExt_Start(void);
+uint8  BtldrExt_SlotInstall(void);
+uint8  BtldrExt_AppValid(void);
+uint8  BtldrExt_ValidateApp(void);
+void   BtldrExt_HostLink(uint8 timeOut);
+uint16 BtldrExt_PacketChecksum(const uint8 buffer[], uint16 size);
+uint32 BtldrExt_RowHash(const uint8 rowData[]);
+uint32 BtldrExt_Crc32(uint32 crc, const uint8 data[], uint16 size);
+uint32 BtldrExt_RowDigest(uint16 row, const uint8 rowData[]);
+
+#endif /* BTLDR_EXT_H */
+
+
+/* [] END OF FILE */
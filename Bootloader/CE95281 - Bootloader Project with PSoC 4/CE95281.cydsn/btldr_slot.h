@@ -0,0 +1,170 @@
+/*******************************************************************************
+* File: btldr_slot.h
+*
+* Version: 1.0
+*
+* Description:
+*  Defines the flash layout and the records that the bootloader shares with
+*  the bootloadable: the application slots, the record rows and the
+*  configuration that places them. The CE95280 bootloadable includes this
+*  file from the directory of this project, so both sides read the same
+*  values.
+*
+********************************************************************************
+* Copyright 2014, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+#if !defined(BTLDR_SLOT_H)
+#define BTLDR_SLOT_H
+
+#include <project.h>
+
+
+/***************************************
+*        Slot configuration
+***************************************/
+
+/* First flash row that belongs to the bootloadable. The rows below it hold
+* the bootloader and are never programmed by the host link. Keep it above
+* the flash usage reported for the CE95281 project in its build report.
+*/
+#define BTLDR_EXT_FIRST_APP_ROW         (64u)
+
+/* Keep a second application resident in slot B, for example a diagnostics
+* image next to the production firmware, instead of installing the image
+* committed there over slot A. The select record chooses the application
+* that is launched, so switching takes one reset and no transfer.
+*/
+#if !defined(BTLDR_EXT_MULTI_APP)
+    #define BTLDR_EXT_MULTI_APP         (0u)
+#endif /* !defined(BTLDR_EXT_MULTI_APP) */
+
+/* First-boot probation of an image installed from slot B, in milliseconds,
+* or 0 to install by a plain copy. The install then swaps the two slots, so
+* the previous image stays in slot B, and the new image is launched with
+* the watchdog armed for this time. It must confirm its health before the
+* time is up (AppSlot_Confirm() of the CE95280 project). If the device
+* starts again before that, from a watchdog or any other reset, the slots
+* are swapped back and the previous image runs without a transfer. Watchdog
+* counter 0 runs on the 32 kHz ILO, which limits the time to 2000 ms.
+* Not available with BTLDR_EXT_MULTI_APP: the swap records and the
+* probation record would take the rows of the select and slot records.
+*/
+#if !defined(BTLDR_EXT_PROBATION_TIME)
+    #if (BTLDR_EXT_MULTI_APP != 0u)
+        #define BTLDR_EXT_PROBATION_TIME    (0u)
+    #else
+        #define BTLDR_EXT_PROBATION_TIME    (1000u)
+    #endif /* (BTLDR_EXT_MULTI_APP != 0u) */
+#endif /* !defined(BTLDR_EXT_PROBATION_TIME) */
+
+#if ((BTLDR_EXT_MULTI_APP != 0u) && (BTLDR_EXT_PROBATION_TIME != 0u))
+    #error BTLDR_EXT_MULTI_APP and BTLDR_EXT_PROBATION_TIME share the record rows: set one of them to 0
+#endif /* ((BTLDR_EXT_MULTI_APP != 0u) && (BTLDR_EXT_PROBATION_TIME != 0u)) */
+
+
+/***************************************
+*        Flash access
+***************************************/
+
+#define BTLDR_EXT_ROW_ADDR(row)         ((const uint8 *)(CY_FLASH_BASE + \
+                                        ((uint32)(row) * CY_FLASH_SIZEOF_ROW)))
+
+/* CRC-32C (Castagnoli, reflected) of the row hashes, the image hash and
+* the journal check. BtldrExt_Crc32() continues the CRC of the previous
+* bytes, BTLDR_EXT_CRC_INIT for the first block.
+*/
+#define BTLDR_EXT_CRC_POLY              (0x82F63B78u)
+#define BTLDR_EXT_CRC_INIT              (0x00000000u)
+
+
+/***************************************
+*        Dual-slot layout
+***************************************/
+
+/* The application area is split in two slots of BTLDR_EXT_SLOT_ROWS rows.
+* The bootloadable runs from slot A at BTLDR_EXT_FIRST_APP_ROW and receives
+* a new image into slot B while it keeps running: the application rows into
+* slot B, the metadata row into BTLDR_EXT_SLOT_META_ROW and, once the staged
+* rows are verified, the slot record. The next time the bootloader starts it
+* copies a valid staged image over slot A and launches it. The bootloadable
+* must fit in slot A. The slot record row and the record rows that follow it
+* are never programmed by the host.
+*
+* With BTLDR_EXT_MULTI_APP set, the application committed to slot B stays
+* there and is launched in place when the select record, on the row after
+* the validity record, chooses it. It is built as a single-application
+* bootloadable placed at the first row of slot B, and its metadata row goes
+* to BTLDR_EXT_SLOT_META_ROW. A host that programs a row of slot B removes
+* it. No select record, or one that chooses an application that is not
+* there, launches slot A.
+*
+* With BTLDR_EXT_PROBATION_TIME set instead, the slots are swapped rather
+* than copied and the row after the validity record, BTLDR_EXT_SWAP_ROW,
+* takes every other swap record. It is the row of the select record, so
+* the two modes are exclusive.
+*/
+#define BTLDR_EXT_META_ROW              (CY_FLASH_NUMBER_ROWS - 1u)
+#define BTLDR_EXT_RECORD_ROWS           (((BTLDR_EXT_MULTI_APP != 0u) || (BTLDR_EXT_PROBATION_TIME != 0u)) ? 4u : 3u)
+#define BTLDR_EXT_SLOT_ROWS             ((BTLDR_EXT_META_ROW - BTLDR_EXT_FIRST_APP_ROW - BTLDR_EXT_RECORD_ROWS) / 2u)
+#define BTLDR_EXT_SLOT_B_ROW            (BTLDR_EXT_FIRST_APP_ROW + BTLDR_EXT_SLOT_ROWS)
+#define BTLDR_EXT_SLOT_META_ROW         (BTLDR_EXT_SLOT_B_ROW + BTLDR_EXT_SLOT_ROWS)
+#define BTLDR_EXT_SLOT_RECORD_ROW       (BTLDR_EXT_SLOT_META_ROW + 1u)
+#define BTLDR_EXT_VALID_ROW             (BTLDR_EXT_SLOT_RECORD_ROW + 1u)
+#define BTLDR_EXT_SELECT_ROW            (BTLDR_EXT_VALID_ROW + 1u)
+#define BTLDR_EXT_SWAP_ROW              (BTLDR_EXT_VALID_ROW + 1u)
+
+#define BTLDR_EXT_SLOT_MAGIC            (0x534C4F54u)
+#define BTLDR_EXT_VALID_MAGIC           (0x56414C44u)
+#define BTLDR_EXT_SELECT_MAGIC          (0x53454C43u)
+#define BTLDR_EXT_SWAP_MAGIC            (0x53574150u)
+#define BTLDR_EXT_PROBATION_MAGIC       (0x50524F42u)
+
+/* Applications of the select record */
+#define BTLDR_EXT_APP_A                 (0x00u)
+#define BTLDR_EXT_APP_B                 (0x01u)
+
+/* Run type that AppSlot_Select() leaves for its software reset, apart from
+* the START_APP and START_BTLDR values of the components. The bootloader
+* launches the selected application at once instead of waiting
+* BTLDR_EXT_WAIT_TIME for a host, as after Bootloadable_Load().
+*/
+#define BTLDR_EXT_START_SELECT          (0x20u)
+
+/* Head of the slot record row. The hash is the CRC-32C of the rowCount
+* staged rows followed by the staged metadata row.
+*/
+typedef struct _BtldrExt_SlotRecord_T
+{
+    uint32  magic;                      /* BTLDR_EXT_SLOT_MAGIC */
+    uint32  rowCount;                   /* application rows staged in slot B */
+    uint32  hash;                       /* hash of the staged image */
+    uint32  check;                      /* ~(magic ^ rowCount ^ hash) */
+} BtldrExt_SlotRecord_T;
+
+/* Head of the slot record row while an installed image is on probation */
+typedef struct _BtldrExt_ProbationRecord_T
+{
+    uint32  magic;                      /* BTLDR_EXT_PROBATION_MAGIC */
+    uint32  state;                      /* installed, launched with the watchdog armed, or rolled back */
+    uint32  check;                      /* ~(magic ^ state) */
+} BtldrExt_ProbationRecord_T;
+
+/* Head of the select record row */
+typedef struct _BtldrExt_SelectRecord_T
+{
+    uint32  magic;                      /* BTLDR_EXT_SELECT_MAGIC */
+    uint32  app;                        /* BTLDR_EXT_APP_A or BTLDR_EXT_APP_B */
+    uint32  check;                      /* ~(magic ^ app) */
+} BtldrExt_SelectRecord_T;
+
+#endif /* BTLDR_SLOT_H */
+
+
+/* [] END OF FILE */
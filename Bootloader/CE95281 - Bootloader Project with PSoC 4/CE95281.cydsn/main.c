@@ -17,6 +17,7 @@
 * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
 *******************************************************************************/
 #include <project.h>
+#include "btldr_ext.h"
 
 int main()
 {
@@ -27,7 +28,12 @@ int main()
     /* Turn on blue LED */
     Bootloader_Status_Write(0u);
 
-    /* Start bootloader communication */
+    /* Serve the extended host link. Returns only when the bootloadable is
+    * scheduled to run.
+    */
+    BtldrExt_Start();
+
+    /* Launch the bootloadable */
     Bootloader_Start();
 
     for(;;)
@@ -0,0 +1,326 @@
+/******************************************************************************
+* File Name: command.c
+*
+* Version: 1.00
+*
+* Description:
+*   This file implements the UART command dispatcher. The commands are looked
+*   up in a table given by the application. A single character typed on the
+*   console is executed by the application with a text response; a frame
+*   carries up to COMMAND_MAX_LENGTH commands, which are executed in order
+*   and answered with one binary result byte each, so a host can batch many
+*   commands in one exchange. A frame that stops for COMMAND_TIMEOUT is
+*   dropped, so a stray start byte costs at most one console byte.
+*
+*******************************************************************************
+* Copyright 2013, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license
+* agreement accompanying the software package from which you obtained
+* this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+******************************************************************************/
+
+#include "command.h"
+#include "uart_queue.h"
+
+/* States of the frame reception */
+#define COMMAND_STATE_CONSOLE   (0u)
+#define COMMAND_STATE_LENGTH    (1u)
+#define COMMAND_STATE_DATA      (2u)
+#define COMMAND_STATE_CHECK     (3u)
+
+#define COMMAND_CRC_POLYNOMIAL  (0x07u)
+
+/* Execute the commands of a valid frame and send the response */
+static void Command_Run(void);
+
+/* Send a response frame with the first Length bytes of Command_Frame */
+static void Command_Respond(uint8 Length);
+
+/* Continue the CRC-8 of a frame with one byte */
+static uint8 Command_Crc8(uint8 Crc, uint8 Data);
+
+static const Command_Entry_T *Command_Table;
+static uint8 Command_Entries;
+static uint8 (*Command_Result)(void);
+static uint32 (*Command_Clock)(void);
+
+/* The commands of the frame being received, then their results */
+static uint8 Command_Frame[COMMAND_MAX_LENGTH];
+static uint8 Command_State;
+static uint8 Command_Length;
+static uint8 Command_Index;
+static uint8 Command_Crc;
+static uint32 Command_LastByte;
+
+
+/******************************************************************************
+* Function Name: Command_Start
+*******************************************************************************
+*
+* Summary:
+*  Sets the command table and starts outside a frame.
+*
+* Parameters:
+*  const Command_Entry_T Table[]:  Command table
+*  uint8 Entries:                  Number of entries of the table
+*  uint8 (*Result)(void):          Returns the result byte of a command
+*                                  after it is executed
+*  uint32 (*Clock)(void):          Free-running clock, in the ticks of
+*                                  COMMAND_TIMEOUT
+*
+* Return:
+*  None.
+*
+******************************************************************************/
+void Command_Start(const Command_Entry_T Table[], uint8 Entries, uint8 (*Result)(void), uint32 (*Clock)(void))
+{
+    Command_Table = Table;
+    Command_Entries = Entries;
+    Command_Result = Result;
+    Command_Clock = Clock;
+    Command_State = COMMAND_STATE_CONSOLE;
+}
+
+
+/******************************************************************************
+* Function Name: Command_Find
+*******************************************************************************
+*
+* Summary:
+*  Looks up a command character in the command table.
+*
+* Parameters:
+*  char8 Code:  Command character, in either case
+*
+* Return:
+*  The table entry, or NULL if the command is unknown.
+*
+******************************************************************************/
+const Command_Entry_T *Command_Find(char8 Code)
+{
+    const Command_Entry_T *Entry = NULL;
+    uint8 Index;
+
+    if ((Code >= 'a') && (Code <= 'z'))
+    {
+        Code -= 'a' - 'A';
+    }
+
+    for (Index = 0u; (Index < Command_Entries) && (Entry == NULL); Index++)
+    {
+        if (Command_Table[Index].Code == Code)
+        {
+            Entry = &Command_Table[Index];
+        }
+    }
+
+    return (Entry);
+}
+
+
+/******************************************************************************
+* Function Name: Command_Receive
+*******************************************************************************
+*
+* Summary:
+*  Passes a received byte to the frame reception. A frame starts with
+*  COMMAND_STX; its commands are executed once its check byte is received.
+*  Any other byte outside a frame is left to the console. A byte that comes
+*  more than COMMAND_TIMEOUT after the previous one ends the frame being
+*  received, without a response, and is taken as outside a frame.
+*
+* Parameters:
+*  char8 Byte:  Byte received from UART
+*
+* Return:
+*  0 if the byte is a console command, 1 if it belongs to a frame.
+*
+******************************************************************************/
+uint8 Command_Receive(char8 Byte)
+{
+    uint8 Data = (uint8) Byte;
+    uint8 Consumed = 1u;
+    uint32 Now = Command_Clock();
+
+    if ((Command_State != COMMAND_STATE_CONSOLE) && ((Now - Command_LastByte) > COMMAND_TIMEOUT))
+    {
+        Command_State = COMMAND_STATE_CONSOLE;
+    }
+    Command_LastByte = Now;
+
+    switch (Command_State)
+    {
+        case COMMAND_STATE_LENGTH:
+            if ((Data == 0u) || (Data > COMMAND_MAX_LENGTH))
+            {
+                Command_State = COMMAND_STATE_CONSOLE;
+                Command_Respond(0u);
+            }
+            else
+            {
+                Command_Length = Data;
+                Command_Index = 0u;
+                Command_Crc = Command_Crc8(0u, Data);
+                Command_State = COMMAND_STATE_DATA;
+            }
+            break;
+
+        case COMMAND_STATE_DATA:
+            Command_Frame[Command_Index] = Data;
+            Command_Index++;
+            Command_Crc = Command_Crc8(Command_Crc, Data);
+            if (Command_Index == Command_Length)
+            {
+                Command_State = COMMAND_STATE_CHECK;
+            }
+            break;
+
+        case COMMAND_STATE_CHECK:
+            Command_State = COMMAND_STATE_CONSOLE;
+            if (Data == Command_Crc)
+            {
+                Command_Run();
+            }
+            else
+            {
+                Command_Respond(0u);
+            }
+            break;
+
+        default:
+            if (Data == COMMAND_STX)
+            {
+                Command_State = COMMAND_STATE_LENGTH;
+            }
+            else
+            {
+                Consumed = 0u;
+            }
+            break;
+    }
+
+    return (Consumed);
+}
+
+
+/******************************************************************************
+* Function Name: Command_Run
+*******************************************************************************
+*
+* Summary:
+*  Executes the commands of a frame in order; each result replaces its
+*  command. A command that enters a low power mode ends the frame: the mode
+*  is entered once the response is sent.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+******************************************************************************/
+static void Command_Run(void)
+{
+    const Command_Entry_T *Entry;
+    const Command_Entry_T *LowPower = NULL;
+    uint8 Index;
+
+    for (Index = 0u; (Index < Command_Length) && (LowPower == NULL); Index++)
+    {
+        Entry = Command_Find((char8) Command_Frame[Index]);
+        if (Entry == NULL)
+        {
+            Command_Frame[Index] = COMMAND_UNKNOWN;
+        }
+        else
+        {
+            if (Entry->Action != NULL)
+            {
+                Entry->Action();
+            }
+            Command_Frame[Index] = Command_Result();
+
+            if (Entry->LowPower != NULL)
+            {
+                LowPower = Entry;
+            }
+        }
+    }
+
+    Command_Respond(Index);
+
+    if (LowPower != NULL)
+    {
+        UartQueue_Drain();
+        LowPower->LowPower();
+    }
+}
+
+
+/******************************************************************************
+* Function Name: Command_Respond
+*******************************************************************************
+*
+* Summary:
+*  Queues a response frame for transmission.
+*
+* Parameters:
+*  uint8 Length:  Number of results at the start of Command_Frame
+*
+* Return:
+*  None.
+*
+******************************************************************************/
+static void Command_Respond(uint8 Length)
+{
+    uint8 Crc = Command_Crc8(0u, Length);
+    uint8 Index;
+
+    UartQueue_PutChar((char8) COMMAND_STX);
+    UartQueue_PutChar((char8) Length);
+
+    for (Index = 0u; Index < Length; Index++)
+    {
+        UartQueue_PutChar((char8) Command_Frame[Index]);
+        Crc = Command_Crc8(Crc, Command_Frame[Index]);
+    }
+
+    UartQueue_PutChar((char8) Crc);
+}
+
+
+/******************************************************************************
+* Function Name: Command_Crc8
+*******************************************************************************
+*
+* Summary:
+*  Continues the CRC-8 of a frame, polynomial 0x07, with one byte.
+*
+* Parameters:
+*  uint8 Crc:   CRC of the preceding bytes, 0 for the first
+*  uint8 Data:  Next byte
+*
+* Return:
+*  The updated CRC.
+*
+******************************************************************************/
+static uint8 Command_Crc8(uint8 Crc, uint8 Data)
+{
+    uint8 Bit;
+
+    Crc ^= Data;
+    for (Bit = 0u; Bit < 8u; Bit++)
+    {
+        Crc = ((Crc & 0x80u) != 0u) ? (uint8)((uint8)(Crc << 1u) ^ COMMAND_CRC_POLYNOMIAL) : (uint8)(Crc << 1u);
+    }
+
+    return (Crc);
+}
+
+
+/* [] END OF FILE */
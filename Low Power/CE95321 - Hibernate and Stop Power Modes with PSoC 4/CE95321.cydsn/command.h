@@ -0,0 +1,73 @@
+/******************************************************************************
+* File Name: command.h
+*
+* Version: 1.00
+*
+* Description:
+*   This file contains the constants, the command table entry and the
+*   function prototypes of the UART command dispatcher.
+*
+*******************************************************************************
+* Copyright 2013, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license
+* agreement accompanying the software package from which you obtained
+* this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+******************************************************************************/
+
+#if !defined(COMMAND_H)
+#define COMMAND_H
+
+#include <stddef.h>
+#include <device.h>
+
+/* A frame is COMMAND_STX, the number of commands, the command characters and
+ * the CRC-8 (polynomial 0x07, initial value 0) of the number and the
+ * commands. The response frame has the same layout, with one result byte
+ * per command executed; a frame that is not valid gets a response with no
+ * results.
+ */
+#define COMMAND_STX             (0x02u)
+
+/* Most commands in one frame */
+#define COMMAND_MAX_LENGTH      (64u)
+
+/* Result byte of a command that is not in the table */
+#define COMMAND_UNKNOWN         (0xFFu)
+
+/* A frame whose next byte comes later than this many ticks of the clock
+ * given to Command_Start() is dropped, and the byte is taken as if no frame
+ * had started: a stray COMMAND_STX does not swallow the console input.
+ * 3200 ticks of the 32 kHz ILO are 100 ms
+ */
+#if !defined(COMMAND_TIMEOUT)
+    #define COMMAND_TIMEOUT     (3200u)
+#endif /* !defined(COMMAND_TIMEOUT) */
+
+/* Entry of the command table */
+typedef struct
+{
+    char8 Code;                         /* upper case command character */
+    void (*Action)(void);               /* executes the command, or NULL */
+    void (*LowPower)(void);             /* enters a low power mode once the response is sent, or NULL */
+    const char8 *Text;                  /* response on the console */
+} Command_Entry_T;
+
+/* Set the command table, the function that returns the result byte and the
+ * free-running clock that times the frames
+ */
+void Command_Start(const Command_Entry_T Table[], uint8 Entries, uint8 (*Result)(void), uint32 (*Clock)(void));
+
+/* Find the entry of a command character, in either case; NULL if none */
+const Command_Entry_T *Command_Find(char8 Code);
+
+/* Pass a received byte; returns 0 if it is a console command outside a frame */
+uint8 Command_Receive(char8 Byte);
+
+#endif /* COMMAND_H */
+
+/* [] END OF FILE */
@@ -7,6 +7,13 @@
 *   This example project demonstrates Stop and hibernate low power mode.
 *   This project uses Low Power Comparator, Digital Pins, and
 *   UART Component. It also shows SRAM retention in hibernate mode.
+*   Between commands the CPU sleeps; the UART interrupt queues the received
+*   bytes and sends the queued output (uart_queue.c). The commands are
+*   looked up in a table (command.c): a character typed on the console gets
+*   a text response, and a host can send many commands in one frame and get
+*   one result byte per command back. The 'P' command reports the share
+*   of the time the CPU was awake since the previous 'P', measured on
+*   watchdog counter 2.
 *
 *******************************************************************************
 * Copyright 2013, Cypress Semiconductor Corporation. All rights reserved.
@@ -21,6 +28,9 @@
 ******************************************************************************/
 
 #include <device.h>
+#include "uart_queue.h"
+#include "command.h"
+#include "retained.h"
 
 /* Macro definitions */
 #define CONVERT_TO_ASCII		(48u)
@@ -29,8 +39,40 @@
 #define	LP_COMP_INTR_MASK		(0x03)
 #define CLEAR_SCREEN			(12u)
 
+/* Switch press events for the main loop */
+#define PRESS_NONE				(0u)
+#define PRESS_LONG				(1u)
+#define PRESS_SHORT				(2u)
+
+/* States of the switch press timing */
+#define PRESS_IDLE				(0u)
+#define PRESS_TIMING			(1u)
+#define PRESS_HELD				(2u)
+
+/* Watchdog counter 0 ticks every 50 ms on the 32 kHz ILO. The first tick
+ * ends the debounce; a press still held 20 ticks later is a long press
+ */
+#define PRESS_TICK				(1600u)
+#define PRESS_LONG_TICKS		(21u)
+
+/* The watchdog interrupt has no interrupt component in the schematic, so
+ * its vector is set at run time: IRQ 9 on the PSoC 4100/4200 devices, the
+ * CY8C4245AXI-483 of this project. Other devices number it differently
+ */
+#define WDT_IRQ					(9u)
+
+#if (CYDEV_CHIP_MEMBER_USED != CYDEV_CHIP_MEMBER_4A)
+	#error WDT_IRQ is the watchdog interrupt of the PSoC 4100/4200 (CY8C4245): set it for this device
+#endif /* (CYDEV_CHIP_MEMBER_USED != CYDEV_CHIP_MEMBER_4A) */
+
+/* Watchdog counter 2 runs freely on the 32 kHz ILO and times the sleeps of
+ * the main loop
+ */
+#define AWAKE_DIGITS			(4u)
+
 /* Interrupt prototypes */
 CY_ISR_PROTO(WakeupPin_ISR_Handler);
+CY_ISR_PROTO(PressTimer_ISR_Handler);
 CY_ISR_PROTO(Comparator_ISR_Handler);
 
 /* Initialize the peripherals as per the reset source */
@@ -42,15 +84,47 @@ void Convert_And_Send(const char8 []);
 /* Execute the command received from UART and send the count value back */
 void Execute_Command(char8);
 
+/* Actions and low power modes of the commands */
+void Increment_Count(void);
+void Decrement_Count(void);
+uint8 Read_Count(void);
+uint32 Read_Clock(void);
+void Measure_Awake(void);
+void Enter_Stop(void);
+void Enter_Hibernate(void);
+
 /* Enter low power if switch press detected in low power mode */
 void Check_SwitchPress(void);
 
-/* Attribute CY_NOINIT puts SRAM variable in memory section which is retained in low power modes */
-CY_NOINIT uint8 Count;
-CY_NOINIT uint8 Count_ASCII;
+/* Send the awake share latched by Measure_Awake() to UART */
+void Send_Awake(void);
 
-/* Flag to detect switch press in active mode and enter low power mode */
-uint32 LowPower_Flag;
+
+/* Commands of the UART console and of the frames */
+const Command_Entry_T Command_Table[] =
+{
+    /* Code  Action             Low power mode     Console response (NULL: Send_Awake()) */
+    {'H',    NULL,              &Enter_Hibernate,  " Hibernate Mode - Count Value "},
+    {'S',    NULL,              &Enter_Stop,       " Stop Mode - Count Value "},
+    {'I',    &Increment_Count,  NULL,              " Increment Value "},
+    {'D',    &Decrement_Count,  NULL,              " Decrement Value "},
+    {'Q',    NULL,              NULL,              " Count Value "},
+    {'P',    &Measure_Awake,    NULL,              NULL}
+};
+
+/* Switch press event to enter low power mode, set by PressTimer_ISR_Handler */
+volatile uint32 LowPower_Flag;
+
+/* Switch press timing, written by the switch and timer interrupts */
+volatile uint8 Press_State;
+volatile uint8 Press_Ticks;
+
+/* Watchdog counter 2 ticks since the measurement window started, asleep in
+ * the main loop, and the awake share of the last window in permille
+ */
+uint32 Awake_WindowStart;
+uint32 Awake_SleepTicks;
+uint32 Awake_Permille;
 
 
 /******************************************************************************
@@ -60,12 +134,13 @@ uint32 LowPower_Flag;
 * Summary:
 *  main() performs following functions:
 *  1: Initialize interrupts, peripherals and variables
-*  2: Read the command from UART
-*  3: Execute the command - Hibernate, Stop, Increment or Decrement depending
-*     upon the received character
+*  2: Read the commands queued by the UART RX interrupt
+*  3: Execute the command - Hibernate, Stop, Increment, Decrement or Query
+*     depending upon the received character, or the commands of a frame
 *  4: Enter low power mode from active mode by detecting the switch press
 *     as below:
 *     Pressing once enters Hibernate mode and Press and hold enters Stop mode
+*  5: Sleep until a byte is received or the switch is pressed
 *
 * Parameters:
 *  None.
@@ -79,6 +154,12 @@ void main()
     /* Data received from the serial port */
     char8 Input_Char = 0u;
 
+    /* Interrupt state saved around the sleep */
+    uint8 Interrupt_State;
+
+    /* Watchdog counter 2 when the sleep started */
+    uint32 Sleep_Start;
+
     /* Initialize the peripherals as per the reset source */
     Initialize();
 
@@ -87,14 +168,15 @@ void main()
 
     while(1)
     {
-        /* Check the UART status */
-        Input_Char = UART_UartGetChar();
-
-        /* If byte received, execute the command*/
-        if (Input_Char > 0u)
+        /* Execute the commands received from UART and send the count value back;
+         * the bytes of a frame go to the command dispatcher
+         */
+        while (UartQueue_Get(&Input_Char) != 0u)
         {
-            /* Execute the command received from UART and send the count value back */
-            Execute_Command(Input_Char);
+            if (Command_Receive(Input_Char) == 0u)
+            {
+                Execute_Command(Input_Char);
+            }
         }
 
         /* If Switch press detected in active mode, enter low power mode
@@ -102,6 +184,19 @@ void main()
          * b. Device enter stop mode if switch if pressed and held
          */
         Check_SwitchPress();
+
+        /* Sleep till a byte or a switch press wakes the CPU. With interrupts
+         * masked, an interrupt raised after the check still ends the sleep
+         * and is served once they are unmasked; its handler counts as awake
+         */
+        Interrupt_State = CyEnterCriticalSection();
+        if ((UartQueue_RxCount() == 0u) && (LowPower_Flag == PRESS_NONE))
+        {
+            Sleep_Start = CySysWdtReadCount(CY_SYS_WDT_COUNTER2);
+            CySysPmSleep();
+            Awake_SleepTicks += CySysWdtReadCount(CY_SYS_WDT_COUNTER2) - Sleep_Start;
+        }
+        CyExitCriticalSection(Interrupt_State);
     }
 }
 
@@ -128,6 +223,21 @@ void Initialize(void)
     /* Start and clear the interrupts */
     isr_WakeupPin_StartEx(WakeupPin_ISR_Handler);
     isr_Comparator_StartEx(Comparator_ISR_Handler);
+    CyIntSetVector(WDT_IRQ, PressTimer_ISR_Handler);
+    CyIntEnable(WDT_IRQ);
+
+    /* Watchdog counter 0 times the switch presses; it runs only during one */
+    Press_State = PRESS_IDLE;
+    CySysWdtWriteMode(CY_SYS_WDT_COUNTER0, CY_SYS_WDT_MODE_INT);
+    CySysWdtWriteMatch(CY_SYS_WDT_COUNTER0, PRESS_TICK);
+    CySysWdtWriteClearOnMatch(CY_SYS_WDT_COUNTER0, 1u);
+
+    /* Watchdog counter 2 measures the awake share, without an interrupt */
+    CySysWdtWriteMode(CY_SYS_WDT_COUNTER2, CY_SYS_WDT_MODE_NONE);
+    CySysWdtEnable(CY_SYS_WDT_COUNTER2_MASK);
+    Awake_WindowStart = CySysWdtReadCount(CY_SYS_WDT_COUNTER2);
+    Awake_SleepTicks = 0u;
+    Awake_Permille = 1000u;
 
     /* Wait till the switch is pressed */
     while (Wakeup_Pin_Read() == 0u);
@@ -143,28 +253,27 @@ void Initialize(void)
     CyGlobalIntEnable;
 
     /* Check the source of reset
-     * 1. Wake Up from Hibernate - Restart Low Power Comparator and UART
+     * 1. Wake Up from Hibernate with valid retained variables - Restart Low
+     *    Power Comparator and UART
      * 2. Any other reset - Initialize the Peripherals and SRAM variables
      */
-    if (CySysPmGetResetReason() == CY_PM_RESET_REASON_WAKEUP_HIB)
+    if ((CySysPmGetResetReason() == CY_PM_RESET_REASON_WAKEUP_HIB) && (Retained_Restore() != 0u))
     {
         /* Initialize variables */
-        LowPower_Flag = 0u;
+        LowPower_Flag = PRESS_NONE;
 
         /* Start Low Power Comparator */
         LPComp_Start();
 
-        /* Start UART Component */
+        /* Start UART Component and queue the received bytes */
         UART_Start();
+        UartQueue_Start();
     }
     else
     {
         /* Initialize variables */
-        Count = 0u;
-        LowPower_Flag = 0u;
-
-        /* Convert it to ASCII character */
-        Count_ASCII = Count + CONVERT_TO_ASCII;
+        Retained_Default();
+        LowPower_Flag = PRESS_NONE;
 
         /* Unfreeze GPIOs */
         CySysPmUnfreezeIo();
@@ -172,10 +281,17 @@ void Initialize(void)
         /* Start Low Power Comparator */
         LPComp_Start();
 
-        /* Start UART Component */
+        /* Start UART Component and queue the received bytes */
         UART_Start();
+        UartQueue_Start();
     }
 
+    /* Look up the commands in Command_Table; every command returns the count.
+     * Watchdog counter 2 times out the frames
+     */
+    Command_Start(Command_Table, (uint8)(sizeof(Command_Table) / sizeof(Command_Table[0])), &Read_Count,
+                  &Read_Clock);
+
     /* Turn the LED connected to Pin_LowPowerOut ON to indicate active mode */
     Pin_LowPowerOut_Write(LOW);
 
@@ -206,15 +322,15 @@ void Initialize(void)
 void Convert_And_Send(const char8 Str[])
 {
     /* Convert the present count value to ascii */
-    Count_ASCII = Count % 10u;
-    Count_ASCII += CONVERT_TO_ASCII;
+    Retained.Count_ASCII = Retained.Count % 10u;
+    Retained.Count_ASCII += CONVERT_TO_ASCII;
 
     /* Clear Screen */
-    UART_UartPutChar(CLEAR_SCREEN);
+    UartQueue_PutChar(CLEAR_SCREEN);
 
-    /* Write to UART */
-    UART_UartPutString(Str);
-    UART_UartPutChar(Count_ASCII);
+    /* Queue for UART; the interrupt sends it */
+    UartQueue_PutString(Str);
+    UartQueue_PutChar(Retained.Count_ASCII);
 }
 
 
@@ -224,8 +340,9 @@ void Convert_And_Send(const char8 Str[])
 *
 * Summary:
 *  Execute_Command() performs following functions:
-*  1: Reads the command from UART
-*  2: Executes the corresponding function
+*  1: Looks up the command received from UART in Command_Table
+*  2: Executes the corresponding function and sends the count value back,
+*     before a low power mode is entered
 *
 * Parameters:
 *  char8 Char_In:  Input character received from UART
@@ -236,66 +353,34 @@ void Convert_And_Send(const char8 Str[])
 ******************************************************************************/
 void Execute_Command(char8 Char_In)
 {
-    /* If 'S' is received through UART, set the device to enter stop mode */
-    if((Char_In == 'S') || (Char_In == 's'))
-    {
-        /* Convert count value to ASCII to send it on UART */
-        Convert_And_Send(" Stop Mode - Count Value ");
-        CyDelay(10u);
+    const Command_Entry_T *Entry = Command_Find(Char_In);
 
-        /* Turn the LED connected to Pin_LowPowerOut OFF to indicate low power mode */
-        Pin_LowPowerOut_Write(HIGH);
-
-        /* Note: If LED is active HIGH, then replace "HIGH" with "LOW" */
-
-        /* Set the indicator Pin_Stop to HIGH to indicate stop Mode */
-        Pin_Stop_Write(HIGH);
-
-        /* Enter Stop Mode */
-        CySysPmStop();
-    }
-
-    /* If 'H' is received through UART, set the device to enter hibernate mode */
-    else if((Char_In == 'H') || (Char_In == 'h'))
+    if (Entry != NULL)
     {
-        /*Convert count value to ASCII to send it on UART */
-        Convert_And_Send(" Hibernate Mode - Count Value ");
-        CyDelay(10u);
-
-        /* Turn the LED connected to Pin_LowPowerOut OFF to indicate low power mode */
-        Pin_LowPowerOut_Write(HIGH);
-
-        /* Note: If LED is active HIGH, then replace "HIGH" with "LOW" */
-
-        /* Enter Hibernate Mode */
-        CySysPmHibernate();
-    }
+        if (Entry->Action != NULL)
+        {
+            Entry->Action();
+        }
 
-    /* If 'I' is received through UART, increment the count value */
-    else if((Char_In == 'I')||(Char_In == 'i'))
-    {
-        /* Increment count value and convert it to ASCII to send it on UART */
-        Count++;
-        if(Count == 0u)
+        /* Convert count value to ASCII to send it on UART */
+        if (Entry->Text != NULL)
         {
-        	Count = 6u;
+            Convert_And_Send(Entry->Text);
+        }
+        else
+        {
+            Send_Awake();
         }
-        Convert_And_Send(" Increment Value ");
-    }
 
-    /* If 'D' is received through UART, decrement the count value */
-    else if((Char_In == 'D')||(Char_In == 'd'))
-    {
-        /*Decrement count value and convert it to ASCII to send it on UART */
-        Count--;
-        if(Count == 255u)
+        if (Entry->LowPower != NULL)
         {
-        	Count = 9u;
+            /* Wait till the last stop bit is sent */
+            UartQueue_Drain();
+            Entry->LowPower();
         }
-        Convert_And_Send(" Decrement Value ");
     }
 
-    /* If any other input is received, display UNKNOWN COMMAND - PRESS H S I D
+    /* If any other input is received, display UNKNOWN COMMAND - PRESS H S I D Q P
      * on UART and transition on the Pin_LowPowerOut
      */
     else
@@ -310,9 +395,227 @@ void Execute_Command(char8 Char_In)
         Pin_LowPowerOut_Write(LOW);
 
         /* Note: If LED is active HIGH, then replace "LOW" with "HIGH" */
-        UART_UartPutChar(CLEAR_SCREEN);
-        UART_UartPutString(" UNKNOWN COMMAND - PRESS H, S, I or D");
+        UartQueue_PutChar(CLEAR_SCREEN);
+        UartQueue_PutString(" UNKNOWN COMMAND - PRESS H, S, I, D, Q or P");
+    }
+}
+
+
+/******************************************************************************
+* Function Name: Increment_Count
+*******************************************************************************
+*
+* Summary:
+*  Action of the 'I' command: increments the count value.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+******************************************************************************/
+void Increment_Count(void)
+{
+    Retained.Count++;
+    if(Retained.Count == 0u)
+    {
+    	Retained.Count = 6u;
+    }
+}
+
+
+/******************************************************************************
+* Function Name: Decrement_Count
+*******************************************************************************
+*
+* Summary:
+*  Action of the 'D' command: decrements the count value.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+******************************************************************************/
+void Decrement_Count(void)
+{
+    Retained.Count--;
+    if(Retained.Count == 255u)
+    {
+    	Retained.Count = 9u;
+    }
+}
+
+
+/******************************************************************************
+* Function Name: Read_Count
+*******************************************************************************
+*
+* Summary:
+*  Returns the count value, the result of every command in a frame.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  The count value.
+*
+******************************************************************************/
+uint8 Read_Count(void)
+{
+    return (Retained.Count);
+}
+
+
+/******************************************************************************
+* Function Name: Read_Clock
+*******************************************************************************
+*
+* Summary:
+*  Returns the free-running count of watchdog counter 2, which times out the
+*  frames of the command dispatcher.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  Ticks of the 32 kHz ILO.
+*
+******************************************************************************/
+uint32 Read_Clock(void)
+{
+    return (CySysWdtReadCount(CY_SYS_WDT_COUNTER2));
+}
+
+
+/******************************************************************************
+* Function Name: Measure_Awake
+*******************************************************************************
+*
+* Summary:
+*  Action of the 'P' command: latches the share of the time the CPU was
+*  awake since the previous 'P', or since the start, and starts a new
+*  window. The sleeps are timed on the 32 kHz ILO, so each is rounded to
+*  about 31 us.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+******************************************************************************/
+void Measure_Awake(void)
+{
+    uint32 Now = CySysWdtReadCount(CY_SYS_WDT_COUNTER2);
+    uint32 Window = Now - Awake_WindowStart;
+
+    if (Window != 0u)
+    {
+        Awake_Permille = (uint32)(((uint64)(Window - Awake_SleepTicks) * 1000u) / Window);
     }
+
+    Awake_WindowStart = Now;
+    Awake_SleepTicks = 0u;
+}
+
+
+/******************************************************************************
+* Function Name: Send_Awake
+*******************************************************************************
+*
+* Summary:
+*  Console response of the 'P' command: sends the awake share latched by
+*  Measure_Awake(), in permille.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+******************************************************************************/
+void Send_Awake(void)
+{
+    char8 Digits[AWAKE_DIGITS + 1u];
+    uint32 Value = Awake_Permille;
+    uint8 Index = AWAKE_DIGITS;
+
+    /* Convert the value to ascii, without leading zeros */
+    Digits[AWAKE_DIGITS] = '\0';
+    do
+    {
+        Index--;
+        Digits[Index] = (char8)((Value % 10u) + CONVERT_TO_ASCII);
+        Value /= 10u;
+    }
+    while ((Value != 0u) && (Index != 0u));
+
+    /* Clear Screen */
+    UartQueue_PutChar(CLEAR_SCREEN);
+
+    UartQueue_PutString(" Awake Permille ");
+    UartQueue_PutString(&Digits[Index]);
+}
+
+
+/******************************************************************************
+* Function Name: Enter_Stop
+*******************************************************************************
+*
+* Summary:
+*  Low power mode of the 'S' command: indicates and enters Stop mode.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+******************************************************************************/
+void Enter_Stop(void)
+{
+    /* Turn the LED connected to Pin_LowPowerOut OFF to indicate low power mode */
+    Pin_LowPowerOut_Write(HIGH);
+
+    /* Note: If LED is active HIGH, then replace "HIGH" with "LOW" */
+
+    /* Set the indicator Pin_Stop to HIGH to indicate stop Mode */
+    Pin_Stop_Write(HIGH);
+
+    /* Enter Stop Mode */
+    CySysPmStop();
+}
+
+
+/******************************************************************************
+* Function Name: Enter_Hibernate
+*******************************************************************************
+*
+* Summary:
+*  Low power mode of the 'H' command: indicates and enters Hibernate mode.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+******************************************************************************/
+void Enter_Hibernate(void)
+{
+    /* Turn the LED connected to Pin_LowPowerOut OFF to indicate low power mode */
+    Pin_LowPowerOut_Write(HIGH);
+
+    /* Note: If LED is active HIGH, then replace "HIGH" with "LOW" */
+
+    /* Keep the count value over Hibernate mode */
+    Retained_Save();
+
+    /* Enter Hibernate Mode */
+    CySysPmHibernate();
 }
 
 
@@ -336,13 +639,13 @@ void Execute_Command(char8 Char_In)
 void Check_SwitchPress(void)
 {
     /* Checks the LowPower_Flag
-     * a. 1 - Enter Stop mode
-     * b. 2 - Enter Hibernate mode
-     * This flag is set in isr_WakeupPin.c
+     * a. PRESS_LONG - Enter Stop mode
+     * b. PRESS_SHORT - Enter Hibernate mode
+     * This flag is set by PressTimer_ISR_Handler
      */
-    if (LowPower_Flag == 1u)
+    if (LowPower_Flag == PRESS_LONG)
     {
-        LowPower_Flag = 0u;
+        LowPower_Flag = PRESS_NONE;
 
         /* Turn the LED connected to Pin_LowPowerOut OFF to indicate low power mode */
         Pin_LowPowerOut_Write(HIGH);
@@ -358,15 +661,17 @@ void Check_SwitchPress(void)
         /* Set the Pin_Stop HIGH to indicate stop mode */
         Pin_Stop_Write(HIGH);
 
+        /* Let the switch settle and the last stop bit be sent */
         CyDelay(10u);
+        UartQueue_Drain();
 
         /* Enter stop mode*/
         CySysPmStop();
     }
 
-    if (LowPower_Flag == 2u)
+    if (LowPower_Flag == PRESS_SHORT)
     {
-        LowPower_Flag = 0u;
+        LowPower_Flag = PRESS_NONE;
 
         /* Turn the LED connected to Pin_LowPowerOut OFF to indicate low power mode */
         Pin_LowPowerOut_Write(HIGH);
@@ -379,7 +684,12 @@ void Check_SwitchPress(void)
         /* Wait till the switch is pressed */
         while (Wakeup_Pin_Read() == 0u);
 
+        /* Let the switch settle and the last stop bit be sent */
         CyDelay(10u);
+        UartQueue_Drain();
+
+        /* Keep the count value over Hibernate mode */
+        Retained_Save();
 
         /* Enter hibernate mode*/
         CySysPmHibernate();
@@ -392,9 +702,9 @@ void Check_SwitchPress(void)
 ********************************************************************************
 *
 * Summary:
-*   Interrupt Service Routine for Wakeup_Pin. Checks if the button
-*   has been pressed for a long or short time and selects low power mode
-*   accordingly (long press for Stop mode).
+*   Interrupt Service Routine for Wakeup_Pin. Starts the timing of a
+*   press; PressTimer_ISR_Handler classifies it. Edges while a press is
+*   timed are bounces and are ignored.
 *
 * Parameters:
 *   None
@@ -405,27 +715,82 @@ void Check_SwitchPress(void)
 *******************************************************************************/
 CY_ISR(WakeupPin_ISR_Handler)
 {
-    uint32 counter;
-
-    /* Debounce delay */
-    CyDelay(50u);
-
-    /* If the switch is pressed for more than 1 sec, set the flag to enter Stop
-     * mode else set the flag to enter hibernate mode. This flag will be cleared
-     * by the device when the device wakes up from low power mode
-     */
-    for(counter = 0u; (counter < 20u) && (Wakeup_Pin_Read() == 0u); counter++)
+    if (Press_State == PRESS_IDLE)
     {
-        CyDelay(50u);
-    }
+        Press_State = PRESS_TIMING;
+        Press_Ticks = 0u;
 
-    LowPower_Flag = (counter == 20u) ? 1u : 2u;
+        CySysWdtResetCounters(CY_SYS_WDT_COUNTER0_RESET);
+        CySysWdtClearInterrupt(CY_SYS_WDT_COUNTER0_INT);
+        CySysWdtEnable(CY_SYS_WDT_COUNTER0_MASK);
+    }
 
 	Wakeup_Pin_ClearInterrupt();
     isr_WakeupPin_ClearPending();
 }
 
 
+/*******************************************************************************
+* Function Name: PressTimer_ISR_Handler
+********************************************************************************
+*
+* Summary:
+*   Interrupt Service Routine for watchdog counter 0, every 50 ms of a press.
+*   A press released within a second is short (Hibernate mode); one held
+*   longer is long (Stop mode) and is timed until it is released. The event
+*   is passed to the main loop in LowPower_Flag, which it clears when the
+*   device wakes up from low power mode.
+*
+* Parameters:
+*   None
+*
+* Return:
+*   None
+*
+*******************************************************************************/
+CY_ISR(PressTimer_ISR_Handler)
+{
+    uint8 Released = (Wakeup_Pin_Read() != 0u) ? 1u : 0u;
+
+    CySysWdtClearInterrupt(CY_SYS_WDT_COUNTER0_INT);
+    CyIntClearPending(WDT_IRQ);
+
+    Press_Ticks++;
+
+    if (Press_State == PRESS_TIMING)
+    {
+        if (Press_Ticks >= PRESS_LONG_TICKS)
+        {
+            LowPower_Flag = PRESS_LONG;
+            Press_State = PRESS_HELD;
+        }
+        else if (Released != 0u)
+        {
+            LowPower_Flag = PRESS_SHORT;
+            Press_State = PRESS_IDLE;
+        }
+        else
+        {
+            /* Still timing */
+        }
+    }
+    else if (Released != 0u)
+    {
+        /* The release of a long press has settled */
+        Press_State = PRESS_IDLE;
+    }
+    else
+    {
+        /* Still held */
+    }
+
+    if (Press_State == PRESS_IDLE)
+    {
+        CySysWdtDisable(CY_SYS_WDT_COUNTER0_MASK);
+    }
+}
+
+
 /*******************************************************************************
 * Function Name: Comparator_ISR_Handler
 ********************************************************************************
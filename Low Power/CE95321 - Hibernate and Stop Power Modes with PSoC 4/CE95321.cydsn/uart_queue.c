@@ -0,0 +1,343 @@
+/******************************************************************************
+* File Name: uart_queue.c
+*
+* Version: 1.00
+*
+* Description:
+*   This file implements the UART receive and transmit queues. The RX
+*   interrupt of the SCB moves every received byte from the hardware FIFO
+*   into a ring buffer, so the main loop can sleep between commands without
+*   losing input. The TX interrupt feeds the hardware FIFO from a second
+*   ring buffer, so a string is sent without the caller waiting for it. In
+*   each queue one side only writes the head and the other only the tail,
+*   so neither side needs to mask interrupts.
+*
+*   The UART component must have no interrupt (INTERRUPT_NONE) and an RX
+*   buffer of the FIFO size (8 bytes): UartQueue_Start() sets the vector of
+*   the SCB interrupt, UART_QUEUE_IRQ, to the handler of the queues.
+*
+*******************************************************************************
+* Copyright 2013, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license
+* agreement accompanying the software package from which you obtained
+* this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+******************************************************************************/
+
+#include "uart_queue.h"
+
+/* Index bits of the ring buffers; the indexes run freely over 0-255 */
+#define UART_QUEUE_RX_MASK      (UART_QUEUE_RX_SIZE - 1u)
+#define UART_QUEUE_TX_MASK      (UART_QUEUE_TX_SIZE - 1u)
+
+/* Interrupt prototype */
+CY_ISR_PROTO(UartQueue_ISR_Handler);
+
+static uint8 UartQueue_RxBuffer[UART_QUEUE_RX_SIZE];
+static uint8 UartQueue_TxBuffer[UART_QUEUE_TX_SIZE];
+
+/* Written by the interrupt only */
+static volatile uint8 UartQueue_RxHead;
+static volatile uint32 UartQueue_RxDroppedCount;
+static volatile uint8 UartQueue_TxTail;
+
+/* Written by the main loop only */
+static volatile uint8 UartQueue_RxTail;
+static volatile uint8 UartQueue_TxHead;
+
+
+/******************************************************************************
+* Function Name: UartQueue_Start
+*******************************************************************************
+*
+* Summary:
+*  Empties the queues and routes the interrupt of the UART to them. The
+*  TX interrupt is enabled only while there are bytes to send or
+*  UartQueue_Drain() waits.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+******************************************************************************/
+void UartQueue_Start(void)
+{
+    UartQueue_RxHead = 0u;
+    UartQueue_RxTail = 0u;
+    UartQueue_RxDroppedCount = 0u;
+    UartQueue_TxHead = 0u;
+    UartQueue_TxTail = 0u;
+
+    CyIntSetVector(UART_QUEUE_IRQ, &UartQueue_ISR_Handler);
+    UART_ClearRxInterruptSource(UART_INTR_RX_NOT_EMPTY);
+    UART_SetRxInterruptMode(UART_INTR_RX_NOT_EMPTY);
+
+    /* Nothing is being sent */
+    UART_SetTxInterruptMode(UART_NO_INTR_SOURCES);
+    UART_SetTxInterrupt(UART_INTR_TX_UART_DONE);
+
+    CyIntClearPending(UART_QUEUE_IRQ);
+    CyIntEnable(UART_QUEUE_IRQ);
+}
+
+
+/******************************************************************************
+* Function Name: UartQueue_Get
+*******************************************************************************
+*
+* Summary:
+*  Takes the oldest byte from the receive queue.
+*
+* Parameters:
+*  char8 *Byte:  Receives the byte
+*
+* Return:
+*  1 if a byte was taken, 0 if the queue is empty.
+*
+******************************************************************************/
+uint8 UartQueue_Get(char8 *Byte)
+{
+    uint8 Tail = UartQueue_RxTail;
+    uint8 Received = 0u;
+
+    if (Tail != UartQueue_RxHead)
+    {
+        *Byte = (char8) UartQueue_RxBuffer[Tail & UART_QUEUE_RX_MASK];
+
+        /* Free the entry only after it is read */
+        UartQueue_RxTail = Tail + 1u;
+        Received = 1u;
+    }
+
+    return (Received);
+}
+
+
+/******************************************************************************
+* Function Name: UartQueue_RxCount
+*******************************************************************************
+*
+* Summary:
+*  Returns the number of bytes waiting in the receive queue.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  Number of bytes.
+*
+******************************************************************************/
+uint8 UartQueue_RxCount(void)
+{
+    return ((uint8)(UartQueue_RxHead - UartQueue_RxTail));
+}
+
+
+/******************************************************************************
+* Function Name: UartQueue_RxDropped
+*******************************************************************************
+*
+* Summary:
+*  Returns the number of bytes dropped because the receive queue was full.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  Number of bytes.
+*
+******************************************************************************/
+uint32 UartQueue_RxDropped(void)
+{
+    return (UartQueue_RxDroppedCount);
+}
+
+
+/******************************************************************************
+* Function Name: UartQueue_PutChar
+*******************************************************************************
+*
+* Summary:
+*  Queues a byte for transmission and returns. Waits, with the CPU asleep,
+*  only while the transmit queue is full. Must not be called from an
+*  interrupt.
+*
+* Parameters:
+*  char8 Byte:  Byte to send
+*
+* Return:
+*  None.
+*
+******************************************************************************/
+void UartQueue_PutChar(char8 Byte)
+{
+    uint8 Head = UartQueue_TxHead;
+    uint8 Interrupt_State;
+
+    while ((uint8)(Head - UartQueue_TxTail) >= UART_QUEUE_TX_SIZE)
+    {
+        Interrupt_State = CyEnterCriticalSection();
+        if ((uint8)(Head - UartQueue_TxTail) >= UART_QUEUE_TX_SIZE)
+        {
+            CySysPmSleep();
+        }
+        CyExitCriticalSection(Interrupt_State);
+    }
+
+    UartQueue_TxBuffer[Head & UART_QUEUE_TX_MASK] = (uint8) Byte;
+    UartQueue_TxHead = Head + 1u;
+
+    /* The interrupt disables itself once it has emptied the queue */
+    UART_SetTxInterruptMode(UART_INTR_TX_NOT_FULL);
+}
+
+
+/******************************************************************************
+* Function Name: UartQueue_PutString
+*******************************************************************************
+*
+* Summary:
+*  Queues a null terminated string for transmission.
+*
+* Parameters:
+*  const char8 Str[]:  String to send
+*
+* Return:
+*  None.
+*
+******************************************************************************/
+void UartQueue_PutString(const char8 Str[])
+{
+    uint32 Index;
+
+    for (Index = 0u; Str[Index] != 0u; Index++)
+    {
+        UartQueue_PutChar(Str[Index]);
+    }
+}
+
+
+/******************************************************************************
+* Function Name: UartQueue_Drain
+*******************************************************************************
+*
+* Summary:
+*  Waits, with the CPU asleep, till the transmit queue is empty and the UART
+*  has sent the stop bit of the last byte. A low power mode entered next
+*  neither truncates the output nor waits longer than needed.
+*
+* Parameters:
+*  None.
+*
+* Return:
+*  None.
+*
+******************************************************************************/
+void UartQueue_Drain(void)
+{
+    uint8 Interrupt_State;
+
+    /* UART_DONE is cleared whenever a byte is written to the TX FIFO */
+    while ((UartQueue_TxTail != UartQueue_TxHead) ||
+           ((UART_GetTxInterruptSource() & UART_INTR_TX_UART_DONE) == 0u))
+    {
+        Interrupt_State = CyEnterCriticalSection();
+        if (UartQueue_TxTail == UartQueue_TxHead)
+        {
+            /* Only the FIFO is left: wake up when it is sent */
+            UART_SetTxInterruptMode(UART_INTR_TX_UART_DONE);
+        }
+        if ((UartQueue_TxTail != UartQueue_TxHead) ||
+            ((UART_GetTxInterruptSource() & UART_INTR_TX_UART_DONE) == 0u))
+        {
+            CySysPmSleep();
+        }
+        CyExitCriticalSection(Interrupt_State);
+    }
+}
+
+
+/*******************************************************************************
+* Function Name: UartQueue_ISR_Handler
+********************************************************************************
+*
+* Summary:
+*   Custom interrupt handler of the UART. Moves the bytes of the RX FIFO into
+*   the receive queue, dropping those that do not fit, and fills the TX FIFO
+*   from the transmit queue.
+*
+* Parameters:
+*   None
+*
+* Return:
+*   None
+*
+*******************************************************************************/
+CY_ISR(UartQueue_ISR_Handler)
+{
+    uint8 Head = UartQueue_RxHead;
+    uint8 Tail = UartQueue_TxTail;
+    uint8 Data;
+
+    if ((UART_GetRxInterruptSourceMasked() & UART_INTR_RX_NOT_EMPTY) != 0u)
+    {
+        while (UART_SpiUartGetRxBufferSize() != 0u)
+        {
+            Data = (uint8) UART_SpiUartReadRxData();
+
+            if ((uint8)(Head - UartQueue_RxTail) < UART_QUEUE_RX_SIZE)
+            {
+                UartQueue_RxBuffer[Head & UART_QUEUE_RX_MASK] = Data;
+                Head++;
+            }
+            else
+            {
+                UartQueue_RxDroppedCount++;
+            }
+        }
+
+        /* Publish the bytes only after they are stored */
+        UartQueue_RxHead = Head;
+
+        UART_ClearRxInterruptSource(UART_INTR_RX_NOT_EMPTY);
+    }
+
+    if ((UART_GetTxInterruptSourceMasked() & UART_INTR_TX_NOT_FULL) != 0u)
+    {
+        while ((Tail != UartQueue_TxHead) && (UART_SpiUartGetTxBufferSize() < UART_FIFO_SIZE))
+        {
+            UART_SpiUartWriteTxData((uint32) UartQueue_TxBuffer[Tail & UART_QUEUE_TX_MASK]);
+            Tail++;
+        }
+
+        /* Free the entries only after they are written to the FIFO; the
+         * bytes written are not sent yet
+         */
+        if (Tail != UartQueue_TxTail)
+        {
+            UartQueue_TxTail = Tail;
+            UART_ClearTxInterruptSource(UART_INTR_TX_UART_DONE);
+        }
+
+        UART_ClearTxInterruptSource(UART_INTR_TX_NOT_FULL);
+        if (Tail == UartQueue_TxHead)
+        {
+            UART_SetTxInterruptMode(UART_NO_INTR_SOURCES);
+        }
+    }
+
+    /* UartQueue_Drain() wakes up; it reads and keeps the UART_DONE source */
+    if ((UART_GetTxInterruptSourceMasked() & UART_INTR_TX_UART_DONE) != 0u)
+    {
+        UART_SetTxInterruptMode(UART_NO_INTR_SOURCES);
+    }
+}
+
+
+/* [] END OF FILE */
@@ -0,0 +1,69 @@
+/******************************************************************************
+* File Name: uart_queue.h
+*
+* Version: 1.00
+*
+* Description:
+*   This file contains the constants and function prototypes of the UART
+*   receive and transmit queues.
+*
+*******************************************************************************
+* Copyright 2013, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license
+* agreement accompanying the software package from which you obtained
+* this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+******************************************************************************/
+
+#if !defined(UART_QUEUE_H)
+#define UART_QUEUE_H
+
+#include <device.h>
+
+/* Bytes held by the receive queue, a power of two of at most 128 */
+#define UART_QUEUE_RX_SIZE      (32u)
+
+/* Bytes held by the transmit queue, a power of two of at most 128 */
+#define UART_QUEUE_TX_SIZE      (64u)
+
+/* Interrupt of the SCB of the UART: the UART is on P0.4/P0.5, which is
+ * SCB1, IRQ 11 on the PSoC 4100/4200 devices (SCB0 is IRQ 10). The number
+ * holds for the CY8C4245AXI-483 of this project; the checks below stop the
+ * build for another device or SCB instead of routing the wrong interrupt
+ */
+#define UART_QUEUE_IRQ          (11u)
+
+#if (CYDEV_CHIP_MEMBER_USED != CYDEV_CHIP_MEMBER_4A)
+    #error UART_QUEUE_IRQ is the SCB1 interrupt of the PSoC 4100/4200 (CY8C4245): set it for this device
+#endif /* (CYDEV_CHIP_MEMBER_USED != CYDEV_CHIP_MEMBER_4A) */
+
+#if (defined(UART_SCB__CTRL) && (UART_SCB__CTRL != CYREG_SCB1_CTRL))
+    #error UART_QUEUE_IRQ is the SCB1 interrupt: set it for the SCB the UART is placed on
+#endif /* (defined(UART_SCB__CTRL) && (UART_SCB__CTRL != CYREG_SCB1_CTRL)) */
+
+/* Start the queue once the UART is started */
+void UartQueue_Start(void);
+
+/* Take the oldest byte received; returns 0 if there is none */
+uint8 UartQueue_Get(char8 *Byte);
+
+/* Number of bytes waiting in the receive queue */
+uint8 UartQueue_RxCount(void);
+
+/* Number of bytes dropped because the receive queue was full */
+uint32 UartQueue_RxDropped(void);
+
+/* Queue a byte or a string for transmission */
+void UartQueue_PutChar(char8 Byte);
+void UartQueue_PutString(const char8 Str[]);
+
+/* Wait till the stop bit of the last byte queued is sent */
+void UartQueue_Drain(void);
+
+#endif /* UART_QUEUE_H */
+
+/* [] END OF FILE */
@@ -0,0 +1,210 @@
+/******************************************************************************
+* File Name: command_test.c
+*
+* Version: 1.00
+*
+* Description:
+*   Checks the command dispatcher of command.c on the host: console bytes,
+*   the results of a frame, the CRC-8 of the response against the standard
+*   check value, the empty response to a frame that is not valid, a low
+*   power command ending a frame, and the timeout that drops a frame which
+*   stops, so that a stray start byte does not swallow the console input.
+*   The UART queue is replaced by a buffer and the clock by a counter.
+*
+*   Build: gcc -Wall -Wextra -I. -I../CE95321.cydsn -o command_test
+*          command_test.c ../CE95321.cydsn/command.c
+*   Usage: command_test
+*
+*******************************************************************************
+* Copyright 2013, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license
+* agreement accompanying the software package from which you obtained
+* this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+******************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include "command.h"
+#include "uart_queue.h"
+
+/* Bytes of the response frames and console bytes the test keeps */
+#define TEST_OUTPUT_SIZE        (256u)
+
+/* Clock ticks between the bytes of a frame sent by a host */
+#define TEST_BYTE_TICKS         (3u)
+
+static uint8 Test_Output[TEST_OUTPUT_SIZE];
+static uint32 Test_OutputLength;
+static uint32 Test_Now;
+static uint8 Test_Count;
+static uint32 Test_LowPower;
+static uint32 Test_Failures;
+
+static void Test_Increment(void)
+{
+    Test_Count++;
+}
+
+static void Test_Sleep(void)
+{
+    Test_LowPower++;
+}
+
+static uint8 Test_Result(void)
+{
+    return (Test_Count);
+}
+
+static uint32 Test_Clock(void)
+{
+    return (Test_Now);
+}
+
+static const Command_Entry_T Test_Table[] =
+{
+    {'I',    &Test_Increment,   NULL,              " Increment Value "},
+    {'H',    NULL,              &Test_Sleep,       " Hibernate Mode - Count Value "},
+    {'Q',    NULL,              NULL,              " Count Value "}
+};
+
+/* The UART queue of the device */
+void UartQueue_PutChar(char8 Byte)
+{
+    if (Test_OutputLength < TEST_OUTPUT_SIZE)
+    {
+        Test_Output[Test_OutputLength] = (uint8) Byte;
+    }
+    Test_OutputLength++;
+}
+
+void UartQueue_Drain(void)
+{
+}
+
+/* Reference CRC-8, polynomial 0x07, MSB first */
+static uint8 Test_Crc8(const uint8 Data[], uint32 Length)
+{
+    uint8 Crc = 0u;
+    uint32 Index;
+    uint8 Bit;
+
+    for (Index = 0u; Index < Length; Index++)
+    {
+        for (Bit = 0u; Bit < 8u; Bit++)
+        {
+            Crc = ((((Crc >> 7u) ^ (Data[Index] >> (7u - Bit))) & 1u) != 0u) ?
+                  (uint8)((uint8)(Crc << 1u) ^ 0x07u) : (uint8)(Crc << 1u);
+        }
+    }
+
+    return (Crc);
+}
+
+/* Passes bytes to the dispatcher, TEST_BYTE_TICKS apart, and counts those
+ * taken as console bytes
+ */
+static uint32 Test_Receive(const uint8 Bytes[], uint32 Length)
+{
+    uint32 Console = 0u;
+    uint32 Index;
+
+    for (Index = 0u; Index < Length; Index++)
+    {
+        Test_Now += TEST_BYTE_TICKS;
+        if (Command_Receive((char8) Bytes[Index]) == 0u)
+        {
+            Console++;
+        }
+    }
+
+    return (Console);
+}
+
+/* Sends a frame of the commands, with a good or a wrong check byte */
+static void Test_SendFrame(const char8 Commands[], uint8 Good)
+{
+    uint8 Frame[COMMAND_MAX_LENGTH + 3u];
+    uint32 Length = strlen(Commands);
+
+    Frame[0u] = COMMAND_STX;
+    Frame[1u] = (uint8) Length;
+    memcpy(&Frame[2u], Commands, Length);
+    Frame[Length + 2u] = (uint8)(Test_Crc8(&Frame[1u], Length + 1u) ^ ((Good != 0u) ? 0u : 1u));
+
+    (void) Test_Receive(Frame, Length + 3u);
+}
+
+/* Checks that the output is one response frame with these results */
+static void Test_ExpectResponse(const char *Name, const uint8 Results[], uint32 Length)
+{
+    uint32 Pass = (Test_OutputLength == (Length + 3u)) && (Test_Output[0u] == COMMAND_STX) &&
+                  (Test_Output[1u] == Length) && (memcmp(&Test_Output[2u], Results, Length) == 0) &&
+                  (Test_Output[Length + 2u] == Test_Crc8(&Test_Output[1u], Length + 1u));
+
+    printf("  %-4s %s\n", (Pass != 0u) ? "ok" : "FAIL", Name);
+    Test_Failures += (Pass != 0u) ? 0u : 1u;
+    Test_OutputLength = 0u;
+}
+
+static void Test_Expect(const char *Name, uint32 Pass)
+{
+    printf("  %-4s %s\n", (Pass != 0u) ? "ok" : "FAIL", Name);
+    Test_Failures += (Pass != 0u) ? 0u : 1u;
+    Test_OutputLength = 0u;
+}
+
+int main(void)
+{
+    static const uint8 Check[] = "123456789";
+    static const uint8 Typed[] = "IQIQ";
+    static const uint8 StrayStart[] = {COMMAND_STX, '5'};
+    static const uint8 BadLength[] = {COMMAND_STX, COMMAND_MAX_LENGTH + 1u};
+    const uint8 Results1[] = {1u, 2u, 2u, COMMAND_UNKNOWN, 3u};
+    const uint8 Results2[] = {4u, 4u};
+    const uint8 Results3[] = {5u, 5u};
+    uint32 Console;
+
+    Command_Start(Test_Table, (uint8)(sizeof(Test_Table) / sizeof(Test_Table[0])), &Test_Result, &Test_Clock);
+
+    printf("crc-8\n");
+    Test_Expect("reference check value 0xF4", Test_Crc8(Check, 9u) == 0xF4u);
+
+    printf("console\n");
+    Test_Expect("bytes outside a frame go to the console", (Test_Receive(Typed, 4u) == 4u) && (Test_Count == 0u));
+
+    printf("frames\n");
+    Test_SendFrame("IIqXI", 1u);
+    Test_ExpectResponse("five commands, one unknown, in order", Results1, 5u);
+    Test_SendFrame("IHQ", 1u);
+    Test_ExpectResponse("a low power command ends the frame", Results2, 2u);
+    Test_Expect("the low power mode is entered once", Test_LowPower == 1u);
+    Test_SendFrame("I", 0u);
+    Test_ExpectResponse("a wrong check byte executes nothing", NULL, 0u);
+    Test_Expect("the count is kept", Test_Count == 4u);
+    (void) Test_Receive(BadLength, 2u);
+    Test_ExpectResponse("a length above COMMAND_MAX_LENGTH is refused", NULL, 0u);
+
+    printf("resync after %u ticks\n", COMMAND_TIMEOUT);
+    Console = Test_Receive(StrayStart, 2u);
+    Test_Now += COMMAND_TIMEOUT + 1u;
+    Console += Test_Receive(Typed, 4u);
+    Test_Expect("a stray start byte costs one console byte", (Console == 4u) && (Test_OutputLength == 0u));
+    Console = Test_Receive(StrayStart, 2u);
+    Test_Now += COMMAND_TIMEOUT - TEST_BYTE_TICKS;
+    Console += Test_Receive(Typed, 4u);
+    Test_Expect("bytes within the timeout stay in the frame", Console == 0u);
+    Test_Now += COMMAND_TIMEOUT + 1u;
+    Test_SendFrame("IQ", 1u);
+    Test_ExpectResponse("the next frame after a dropped one is executed", Results3, 2u);
+
+    printf("%u failed\n", Test_Failures);
+
+    return ((Test_Failures != 0u) ? 1 : 0);
+}
+
+/* [] END OF FILE */
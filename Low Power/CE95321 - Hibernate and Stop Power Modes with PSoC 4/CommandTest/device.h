@@ -0,0 +1,35 @@
+/******************************************************************************
+* File Name: device.h
+*
+* Version: 1.00
+*
+* Description:
+*   Host stand-in for the device header of the CE95321 project, with the
+*   types the command dispatcher uses, so that command_test.c can build
+*   command.c on the host.
+*
+*******************************************************************************
+* Copyright 2013, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license
+* agreement accompanying the software package from which you obtained
+* this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+******************************************************************************/
+
+#if !defined(DEVICE_H)
+#define DEVICE_H
+
+#include <stdint.h>
+
+typedef uint8_t  uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef char     char8;
+
+#endif /* DEVICE_H */
+
+/* [] END OF FILE */
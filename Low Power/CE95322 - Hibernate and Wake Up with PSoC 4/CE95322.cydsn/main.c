@@ -20,8 +20,7 @@
 *******************************************************************************/
 #include <device.h>
 #include <cyPm.h>
-
-CY_NOINIT uint16 cyHibernatesCount;
+#include "retained.h"
 
 
 /*******************************************************************************
@@ -96,21 +95,23 @@ void main()
     switch (reason)
     {
         case CY_PM_RESET_REASON_WAKEUP_STOP:
-            cyHibernatesCount = 0;
+            Retained_Default();
             LCD_PrintString("Stop");
             break;
         case CY_PM_RESET_REASON_WAKEUP_HIB:
-            ++cyHibernatesCount;
+            /* Count from the defaults if the retained count is not valid */
+            (void) Retained_Restore();
+            ++Retained.hibernatesCount;
             LCD_PrintString("Hibernate");
             LCD_Position(1, 10);
-            LCD_PrintNumber(cyHibernatesCount);
+            LCD_PrintNumber(Retained.hibernatesCount);
             break;
         case CY_PM_RESET_REASON_XRES:
-            cyHibernatesCount = 0;
+            Retained_Default();
             LCD_PrintString("XRES");
             break;
         default:
-            cyHibernatesCount = 0;
+            Retained_Default();
             LCD_PrintString("Unknown");
     }
 
@@ -144,6 +145,9 @@ void main()
         /* Freeze IO-Cells */
         CySysPmFreezeIo();
 
+        /* Keep the count over Hibernate mode */
+        Retained_Save();
+
         CySysPmHibernate();
         pin_0_0_toggle_Write(1);
     }
@@ -0,0 +1,155 @@
+/*******************************************************************************
+* File: retained.c
+*
+* Version: 1.0
+*
+* Description:
+*   This file implements the retained state: the variables of Retained_T
+*   in SRAM retained in Hibernate mode, with a tag and a CRC-16 saved next
+*   to them. The tag holds RETAINED_VERSION and the size of Retained_T, so
+*   a firmware with another layout does not take over the variables, and
+*   the CRC detects SRAM that was not retained or was corrupted.
+*
+********************************************************************************
+* Copyright 2013, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#include "retained.h"
+
+#define RETAINED_TAG            ((uint16)((RETAINED_VERSION << 8u) | sizeof(Retained_T)))
+
+/* CRC-16/CCITT, initial value 0xFFFF */
+#define RETAINED_CRC_SEED       (0xFFFFu)
+
+/* Compute the CRC of the retained variables */
+static uint16 Retained_Crc16(void);
+
+/* Attribute CY_NOINIT puts SRAM variable in memory section which is retained in low power modes */
+CY_NOINIT Retained_T Retained;
+CY_NOINIT static uint16 Retained_Tag;
+CY_NOINIT static uint16 Retained_Crc;
+
+static const Retained_T Retained_Defaults = RETAINED_DEFAULTS;
+
+/* CRC-16/CCITT of every value of a nibble; two lookups per byte */
+static const uint16 Retained_CrcTable[16u] =
+{
+    0x0000u, 0x1021u, 0x2042u, 0x3063u, 0x4084u, 0x50A5u, 0x60C6u, 0x70E7u,
+    0x8108u, 0x9129u, 0xA14Au, 0xB16Bu, 0xC18Cu, 0xD1ADu, 0xE1CEu, 0xF1EFu
+};
+
+
+/*******************************************************************************
+* Function Name: Retained_Restore
+********************************************************************************
+*
+* Summary:
+*  Checks the tag and the CRC of the retained variables. If either does not
+*  match, the variables are set to RETAINED_DEFAULTS.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  1 if the variables were retained, 0 if they were set to defaults.
+*
+*******************************************************************************/
+uint8 Retained_Restore(void)
+{
+    uint8 Valid = 0u;
+
+    if ((Retained_Tag == RETAINED_TAG) && (Retained_Crc == Retained_Crc16()))
+    {
+        Valid = 1u;
+    }
+    else
+    {
+        Retained_Default();
+    }
+
+    return (Valid);
+}
+
+
+/*******************************************************************************
+* Function Name: Retained_Default
+********************************************************************************
+*
+* Summary:
+*  Sets the retained variables to RETAINED_DEFAULTS. They are not valid
+*  after a wake up from Hibernate till Retained_Save() is called.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void Retained_Default(void)
+{
+    Retained = Retained_Defaults;
+    Retained_Tag = 0u;
+}
+
+
+/*******************************************************************************
+* Function Name: Retained_Save
+********************************************************************************
+*
+* Summary:
+*  Saves the tag and the CRC of the retained variables. Call it after the
+*  last change of the variables, right before entering Hibernate mode.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  None
+*
+*******************************************************************************/
+void Retained_Save(void)
+{
+    Retained_Crc = Retained_Crc16();
+    Retained_Tag = RETAINED_TAG;
+}
+
+
+/*******************************************************************************
+* Function Name: Retained_Crc16
+********************************************************************************
+*
+* Summary:
+*  Computes the CRC-16/CCITT of the retained variables, a nibble at a time.
+*
+* Parameters:
+*  None
+*
+* Return:
+*  The CRC.
+*
+*******************************************************************************/
+static uint16 Retained_Crc16(void)
+{
+    const uint8 *Data = (const uint8 *) &Retained;
+    uint16 Crc = RETAINED_CRC_SEED;
+    uint32 Index;
+
+    for (Index = 0u; Index < sizeof(Retained_T); Index++)
+    {
+        Crc = (uint16)(Crc << 4u) ^ Retained_CrcTable[(uint8)(Crc >> 12u) ^ (Data[Index] >> 4u)];
+        Crc = (uint16)(Crc << 4u) ^ Retained_CrcTable[(uint8)(Crc >> 12u) ^ (Data[Index] & 0x0Fu)];
+    }
+
+    return (Crc);
+}
+
+
+/* [] END OF FILE */
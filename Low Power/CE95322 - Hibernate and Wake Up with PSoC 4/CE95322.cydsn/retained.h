@@ -0,0 +1,53 @@
+/*******************************************************************************
+* File: retained.h
+*
+* Version: 1.0
+*
+* Description:
+*   This file declares the layout of the SRAM variables retained in
+*   Hibernate mode and the function prototypes of the retained state.
+*
+********************************************************************************
+* Copyright 2013, Cypress Semiconductor Corporation. All rights reserved.
+* This software is owned by Cypress Semiconductor Corporation and is protected
+* by and subject to worldwide patent and copyright laws and treaties.
+* Therefore, you may use this software only as provided in the license agreement
+* accompanying the software package from which you obtained this software.
+* CYPRESS AND ITS SUPPLIERS MAKE NO WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+* WITH REGARD TO THIS SOFTWARE, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT,
+* IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+*******************************************************************************/
+
+#if !defined(RETAINED_H)
+#define RETAINED_H
+
+#include <device.h>
+
+/* Increment whenever the meaning of Retained_T changes; a change of its size
+ * is detected without it
+ */
+#define RETAINED_VERSION        (1u)
+
+/* Variables retained in Hibernate mode */
+typedef struct
+{
+    uint16 hibernatesCount;             /* wake ups from Hibernate since another reset */
+} Retained_T;
+
+/* Values of Retained_T after any reset other than a wake up from Hibernate */
+#define RETAINED_DEFAULTS       {0u}
+
+extern Retained_T Retained;
+
+/* Validate the retained variables; returns 0 if they were set to defaults */
+uint8 Retained_Restore(void);
+
+/* Set the retained variables to RETAINED_DEFAULTS */
+void Retained_Default(void);
+
+/* Seal the retained variables before entering Hibernate mode */
+void Retained_Save(void);
+
+#endif /* RETAINED_H */
+
+/* [] END OF FILE */